@@ -0,0 +1,574 @@
+#include "vw/vw.h"
+#include "vw/version.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A benchmark times the wrapper against the equivalent raw C API calls. The
+// raw function may be empty when there is nothing to compare against.
+struct Benchmark
+{
+    std::string name;
+    size_t iterations;
+    std::function<void()> raw;
+    std::function<void()> wrapper;
+};
+
+struct Timing
+{
+    double minNs;
+    double medianNs;
+    double meanNs;
+};
+
+struct Options
+{
+    double scale;
+    size_t repetitions;
+    std::string filter;
+    std::string output;
+};
+
+// Runs the function the given number of times and returns the average time of
+// a single call in nanoseconds.
+double measure(size_t iterations, const std::function<void()>& func)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+        func();
+    auto end = std::chrono::steady_clock::now();
+
+    std::chrono::duration<double, std::nano> elapsed = end - start;
+    return elapsed.count() / iterations;
+}
+
+// Repeats the measurement so noise shows up in the spread between min and
+// median rather than in a single number.
+Timing collect(size_t iterations, size_t repetitions, const std::function<void()>& func)
+{
+    // Warm up caches and lazily initialized state
+    measure(std::max<size_t>(iterations / 10, 1), func);
+
+    std::vector<double> samples;
+    for (size_t i = 0; i < repetitions; ++i)
+        samples.push_back(measure(iterations, func));
+
+    std::sort(samples.begin(), samples.end());
+
+    Timing timing;
+    timing.minNs = samples.front();
+    timing.medianNs = samples[samples.size() / 2];
+    timing.meanNs = 0.0;
+    for (double sample : samples)
+        timing.meanNs += sample / samples.size();
+
+    return timing;
+}
+
+std::string escape(const std::string& text)
+{
+    std::string escaped;
+    for (char c : text)
+    {
+        if (c == '\0')
+            break;
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+        if (static_cast<unsigned char>(c) < 0x20)
+            continue;
+        escaped += c;
+    }
+
+    return escaped;
+}
+
+void writeTiming(std::ostream& out, const char* name, const Timing& timing)
+{
+    out << "\"" << name << "\": { \"min\": " << timing.minNs
+        << ", \"median\": " << timing.medianNs
+        << ", \"mean\": " << timing.meanNs << " }";
+}
+
+bool parseOptions(int argc, const char * const argv[], Options& options)
+{
+    options.scale = 1.0;
+    options.repetitions = 5;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+            return false;
+
+        if (arg == "--scale")
+            options.scale = std::strtod(argv[++i], nullptr);
+        else if (arg == "--repetitions")
+            options.repetitions = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--filter")
+            options.filter = argv[++i];
+        else if (arg == "--output")
+            options.output = argv[++i];
+        else
+            return false;
+    }
+
+    return options.scale > 0.0 && options.repetitions > 0;
+}
+
+int main(int argc, const char * const argv[])
+{
+    // Point VK_ICD_FILENAMES at a software or null ICD such as lavapipe to get
+    // stable numbers. No layers are enabled since they would dominate the
+    // timings.
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cerr << "Usage: vwbench [--scale factor] [--repetitions count] "
+            "[--filter substring] [--output file.json]\n";
+        return 1;
+    }
+
+    vw::InstanceCreator instanceCtor;
+    instanceCtor.setApplicationName("vwBench");
+    instanceCtor.setApplicationVersion(1);
+
+    vw::Instance instance;
+    vw::Device device;
+    vw::Instance::PhysicalDeviceList physicalDevices;
+
+    try
+    {
+        instance = instanceCtor.create();
+
+        physicalDevices = instance.enumeratePhysicalDevices();
+        if (physicalDevices.empty())
+        {
+            std::cerr << "No Vulkan devices were found.\n";
+            return 0;
+        }
+
+        vw::DeviceCreator deviceCtor;
+        deviceCtor.setPhysicalDevice(physicalDevices.front());
+        deviceCtor.addQueues(physicalDevices.front().getDeviceQueueFamilies().front(), { 1.0f });
+        device = deviceCtor.create();
+    }
+    catch (const vw::Exception& ex)
+    {
+        std::cerr << ex.getErrorMessage() << "\n";
+        return 0;
+    }
+
+    const vw::PhysicalDevice& physicalDevice = physicalDevices.front();
+    VkInstance instanceHandle = instance.getHandle();
+    VkPhysicalDevice physicalHandle = physicalDevice.getHandle();
+    const vw::DeviceDispatch& dispatch = device.getDispatch();
+    VkDevice deviceHandle = device.getHandle();
+    vw::Queue& queue = *device.getQueues().begin();
+    VkQueue queueHandle = queue.getHandle();
+
+    std::cerr << "Device " << physicalDevice.getDeviceName().c_str() << "\n";
+
+    // Creation info matching what the creators build
+    VkApplicationInfo appInfo;
+    appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    appInfo.pNext = nullptr;
+    appInfo.pApplicationName = "vwBench";
+    appInfo.applicationVersion = 1;
+    appInfo.pEngineName = "";
+    appInfo.engineVersion = 0;
+    appInfo.apiVersion = 0;
+
+    VkInstanceCreateInfo instanceCInfo;
+    instanceCInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instanceCInfo.pNext = nullptr;
+    instanceCInfo.flags = 0;
+    instanceCInfo.pApplicationInfo = &appInfo;
+    instanceCInfo.enabledLayerCount = 0;
+    instanceCInfo.ppEnabledLayerNames = nullptr;
+    instanceCInfo.enabledExtensionCount = 0;
+    instanceCInfo.ppEnabledExtensionNames = nullptr;
+
+    float priority = 1.0f;
+    VkDeviceQueueCreateInfo queueCInfo;
+    queueCInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueCInfo.pNext = nullptr;
+    queueCInfo.flags = 0;
+    queueCInfo.queueFamilyIndex = 0;
+    queueCInfo.queueCount = 1;
+    queueCInfo.pQueuePriorities = &priority;
+
+    VkDeviceCreateInfo deviceCInfo;
+    deviceCInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceCInfo.pNext = nullptr;
+    deviceCInfo.flags = 0;
+    deviceCInfo.queueCreateInfoCount = 1;
+    deviceCInfo.pQueueCreateInfos = &queueCInfo;
+    deviceCInfo.enabledLayerCount = 0;
+    deviceCInfo.ppEnabledLayerNames = nullptr;
+    deviceCInfo.enabledExtensionCount = 0;
+    deviceCInfo.ppEnabledExtensionNames = nullptr;
+    deviceCInfo.pEnabledFeatures = nullptr;
+
+    VkFenceCreateInfo fenceCInfo;
+    fenceCInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceCInfo.pNext = nullptr;
+    fenceCInfo.flags = 0;
+
+    // A fence provides a cheap device level call to measure
+    VkFence fence = VK_NULL_HANDLE;
+    dispatch.vkCreateFence(deviceHandle, &fenceCInfo, nullptr, &fence);
+
+    // Small device local blocks, as a typical per resource allocation
+    vw::MemoryAllocator& allocator = device.getMemoryAllocator();
+    const VkPhysicalDeviceMemoryProperties& memory = physicalDevice.getMemoryProperties();
+    uint32_t memoryType = 0;
+    for (uint32_t i = 0; i < memory.memoryTypeCount; ++i)
+    {
+        if (memory.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+        {
+            memoryType = i;
+            break;
+        }
+    }
+
+    VkMemoryRequirements requirements;
+    requirements.size = 64 * 1024;
+    requirements.alignment = 256;
+    requirements.memoryTypeBits = 1u << memoryType;
+
+    VkMemoryAllocateInfo allocateInfo;
+    allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.pNext = nullptr;
+    allocateInfo.allocationSize = requirements.size;
+    allocateInfo.memoryTypeIndex = memoryType;
+
+    vw::SyncPool& syncPool = device.getSyncPool();
+
+    std::vector<Benchmark> benchmarks;
+
+    benchmarks.push_back(Benchmark{ "instance_create_destroy", 200,
+        [&]()
+        {
+            VkInstance handle = VK_NULL_HANDLE;
+            vkCreateInstance(&instanceCInfo, nullptr, &handle);
+            vkDestroyInstance(handle, nullptr);
+        },
+        [&]()
+        {
+            vw::Instance created = instanceCtor.create();
+        }
+    });
+
+    benchmarks.push_back(Benchmark{ "device_create_destroy", 100,
+        [&]()
+        {
+            VkDevice handle = VK_NULL_HANDLE;
+            vkCreateDevice(physicalHandle, &deviceCInfo, nullptr, &handle);
+            vkDestroyDevice(handle, nullptr);
+        },
+        [&]()
+        {
+            vw::DeviceCreator deviceCtor;
+            deviceCtor.setPhysicalDevice(physicalDevice);
+            deviceCtor.addQueues(physicalDevice.getDeviceQueueFamilies().front(), { 1.0f });
+            vw::Device created = deviceCtor.create();
+        }
+    });
+
+    benchmarks.push_back(Benchmark{ "enumerate_physical_devices", 10000,
+        [&]()
+        {
+            uint32_t count = 0;
+            vkEnumeratePhysicalDevices(instanceHandle, &count, nullptr);
+            std::vector<VkPhysicalDevice> handles(count);
+            vkEnumeratePhysicalDevices(instanceHandle, &count, handles.data());
+        },
+        [&]()
+        {
+            instance.enumeratePhysicalDevices();
+        }
+    });
+
+    benchmarks.push_back(Benchmark{ "get_device_queue_families", 100000,
+        [&]()
+        {
+            uint32_t count = 0;
+            vkGetPhysicalDeviceQueueFamilyProperties(physicalHandle, &count, nullptr);
+            std::vector<VkQueueFamilyProperties> properties(count);
+            vkGetPhysicalDeviceQueueFamilyProperties(physicalHandle, &count, properties.data());
+        },
+        [&]()
+        {
+            physicalDevice.getDeviceQueueFamilies();
+        }
+    });
+
+    benchmarks.push_back(Benchmark{ "instance_move", 1000000,
+        nullptr,
+        [&]()
+        {
+            vw::Instance moved(std::move(instance));
+            instance = std::move(moved);
+        }
+    });
+
+    benchmarks.push_back(Benchmark{ "device_move", 1000000,
+        nullptr,
+        [&]()
+        {
+            vw::Device moved(std::move(device));
+            device = std::move(moved);
+        }
+    });
+
+    benchmarks.push_back(Benchmark{ "get_fence_status", 1000000,
+        [&]() { vkGetFenceStatus(deviceHandle, fence); },
+        [&]() { dispatch.vkGetFenceStatus(deviceHandle, fence); }
+    });
+
+    // An empty submission exercises the queue level path without doing work
+    benchmarks.push_back(Benchmark{ "queue_submit_empty", 1000000,
+        [&]() { vkQueueSubmit(queueHandle, 0, nullptr, VK_NULL_HANDLE); },
+        [&]() { queue.submit(0, nullptr, VK_NULL_HANDLE); }
+    });
+
+    benchmarks.push_back(Benchmark{ "fence_acquire_release", 100000,
+        [&]()
+        {
+            VkFence handle = VK_NULL_HANDLE;
+            vkCreateFence(deviceHandle, &fenceCInfo, nullptr, &handle);
+            vkDestroyFence(deviceHandle, handle, nullptr);
+        },
+        [&]()
+        {
+            syncPool.releaseFence(syncPool.acquireFence());
+        }
+    });
+
+    benchmarks.push_back(Benchmark{ "memory_allocate_free", 10000,
+        [&]()
+        {
+            VkDeviceMemory handle = VK_NULL_HANDLE;
+            vkAllocateMemory(deviceHandle, &allocateInfo, nullptr, &handle);
+            vkFreeMemory(deviceHandle, handle, nullptr);
+        },
+        [&]()
+        {
+            vw::Allocation allocation = allocator.allocate(requirements, 0);
+            allocator.free(allocation);
+        }
+    });
+
+    // Recording the same barriers on more threads shows how recording scales.
+    // The raw baseline records every item into one command buffer.
+    const uint32_t recordItemCount = 4096;
+
+    VkMemoryBarrier recordBarrier;
+    recordBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    recordBarrier.pNext = nullptr;
+    recordBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    recordBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    vw::ParallelRecorder::RecordFunction recordItems = [&](VkCommandBuffer commandBuffer,
+        uint32_t first, uint32_t count, uint32_t)
+    {
+        for (uint32_t i = first; i < first + count; ++i)
+        {
+            dispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &recordBarrier, 0, nullptr, 0,
+                nullptr);
+        }
+    };
+
+    const vw::QueueFamily* recordFamily = nullptr;
+    vw::PhysicalDevice::QueueFamilyList families = physicalDevice.getDeviceQueueFamilies();
+    for (const vw::QueueFamily& family : families)
+    {
+        if (family.getIndex() == queue.getFamilyIndex())
+            recordFamily = &family;
+    }
+
+    VkCommandPool recordPool = VK_NULL_HANDLE;
+    VkCommandBuffer recordBuffer = VK_NULL_HANDLE;
+    std::vector<std::unique_ptr<vw::ParallelRecorder>> recorders;
+
+    VkCommandPoolCreateInfo recordPoolCInfo;
+    recordPoolCInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    recordPoolCInfo.pNext = nullptr;
+    recordPoolCInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    recordPoolCInfo.queueFamilyIndex = queue.getFamilyIndex();
+    dispatch.vkCreateCommandPool(deviceHandle, &recordPoolCInfo, nullptr, &recordPool);
+
+    VkCommandBufferAllocateInfo recordAllocateInfo;
+    recordAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    recordAllocateInfo.pNext = nullptr;
+    recordAllocateInfo.commandPool = recordPool;
+    recordAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    recordAllocateInfo.commandBufferCount = 1;
+    dispatch.vkAllocateCommandBuffers(deviceHandle, &recordAllocateInfo, &recordBuffer);
+
+    VkCommandBufferBeginInfo recordBeginInfo;
+    recordBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    recordBeginInfo.pNext = nullptr;
+    recordBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    recordBeginInfo.pInheritanceInfo = nullptr;
+
+    uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    for (uint32_t workerCount : { 0u, 1u, 3u, 7u, 15u })
+    {
+        // A few workers are always measured, more only up to the cores
+        if (workerCount > 3 && workerCount >= hardwareThreads)
+            break;
+
+        vw::ParallelRecorder::Settings recorderSettings;
+        recorderSettings.workerCount = workerCount;
+        recorderSettings.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        recorders.emplace_back(new vw::ParallelRecorder(device, *recordFamily, recorderSettings));
+        vw::ParallelRecorder& recorder = *recorders.back();
+
+        benchmarks.push_back(Benchmark{ "parallel_record_workers_" + std::to_string(workerCount),
+            200,
+            [&]()
+            {
+                dispatch.vkResetCommandPool(deviceHandle, recordPool, 0);
+                dispatch.vkBeginCommandBuffer(recordBuffer, &recordBeginInfo);
+                recordItems(recordBuffer, 0, recordItemCount, 0);
+                dispatch.vkEndCommandBuffer(recordBuffer);
+            },
+            [&]()
+            {
+                recorder.beginFrame();
+                recorder.record(recordItemCount, recordItems);
+            }
+        });
+    }
+
+    // The cluster needs timeline semaphores, so it gets an instance of its own
+    // targeting Vulkan 1.2 and runs on every device found
+    vw::InstanceCreator clusterInstanceCtor;
+    clusterInstanceCtor.setApplicationName("vwBench");
+    clusterInstanceCtor.setApiVersion(1, 2, 0);
+
+    vw::Instance clusterInstance;
+    std::unique_ptr<vw::DeviceCluster> cluster;
+
+    try
+    {
+        clusterInstance = clusterInstanceCtor.create();
+
+        vw::Instance::PhysicalDeviceList clusterDevices =
+            clusterInstance.enumeratePhysicalDevices();
+        if (!clusterDevices.empty())
+            cluster.reset(new vw::DeviceCluster(clusterInstance, clusterDevices));
+    }
+    catch (const vw::Exception& ex)
+    {
+        std::cerr << "Skipping the cluster benchmarks: " << ex.getErrorMessage() << "\n";
+    }
+
+    // A task with no dispatches measures the scheduling and completion path
+    if (cluster)
+    {
+        benchmarks.push_back(Benchmark{ "cluster_submit_wait", 10000,
+            nullptr,
+            [&]()
+            {
+                cluster->submit([](vw::ComputeContext& context, uint32_t)
+                {
+                    return context.flush();
+                });
+                cluster->waitIdle();
+            }
+        });
+    }
+
+    std::ostringstream json;
+    json << "{\n";
+    json << "  \"library\": \"" << vw::MajorVersion << "." << vw::MinorVersion << "."
+        << vw::PatchVersion << "\",\n";
+    json << "  \"device\": \"" << escape(physicalDevice.getDeviceName()) << "\",\n";
+    json << "  \"vendorId\": " << physicalDevice.getVendorId() << ",\n";
+    json << "  \"deviceId\": " << physicalDevice.getDeviceId() << ",\n";
+    json << "  \"driverVersion\": " << physicalDevice.getDriverVersion() << ",\n";
+    json << "  \"apiVersion\": " << physicalDevice.getApiVersion() << ",\n";
+    json << "  \"repetitions\": " << options.repetitions << ",\n";
+    json << "  \"unit\": \"ns\",\n";
+    json << "  \"benchmarks\": [";
+
+    bool first = true;
+    for (const Benchmark& benchmark : benchmarks)
+    {
+        if (benchmark.name.find(options.filter) == std::string::npos)
+            continue;
+
+        size_t iterations = std::max<size_t>(
+            static_cast<size_t>(benchmark.iterations * options.scale), 1);
+
+        json << ((first) ? "\n" : ",\n");
+        json << "    { \"name\": \"" << benchmark.name << "\", \"iterations\": " << iterations;
+        first = false;
+
+        try
+        {
+            Timing wrapper = collect(iterations, options.repetitions, benchmark.wrapper);
+            json << ", ";
+            writeTiming(json, "wrapper", wrapper);
+
+            std::cerr << benchmark.name << ": wrapper " << wrapper.medianNs << " ns";
+
+            if (benchmark.raw)
+            {
+                Timing raw = collect(iterations, options.repetitions, benchmark.raw);
+                json << ", ";
+                writeTiming(json, "raw", raw);
+                json << ", \"overhead\": " << (wrapper.medianNs - raw.medianNs);
+
+                std::cerr << ", raw " << raw.medianNs << " ns";
+            }
+
+            std::cerr << "\n";
+        }
+        catch (const vw::Exception& ex)
+        {
+            json << ", \"error\": \"" << escape(ex.getErrorMessage()) << "\"";
+            std::cerr << benchmark.name << ": " << ex.getErrorMessage() << "\n";
+        }
+
+        json << " }";
+    }
+
+    json << "\n  ]\n}\n";
+
+    device.waitIdle();
+    recorders.clear();
+    dispatch.vkDestroyCommandPool(deviceHandle, recordPool, nullptr);
+    dispatch.vkDestroyFence(deviceHandle, fence, nullptr);
+
+    if (options.output.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream file(options.output.c_str());
+        file << json.str();
+        if (!file)
+        {
+            std::cerr << "Failed to write " << options.output << "\n";
+            return 1;
+        }
+    }
+
+    return 0;
+}
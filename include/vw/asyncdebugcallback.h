@@ -0,0 +1,154 @@
+#ifndef VW_ASYNCDEBUGCALLBACK_H
+#define VW_ASYNCDEBUGCALLBACK_H
+
+#include <vw/common.h>
+#include <vw/debugcallback.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace vw
+{
+    /*! @brief A DebugCallback that hands messages to another callback on a
+     *      thread of its own, so validation never stalls the calling thread.
+     *
+     *  Messages are copied into a bounded lock-free ring of preallocated
+     *  slots and the call returns right away. When the ring is full, the
+     *  message is dropped and counted. A drain thread empties the ring
+     *  regularly. It delivers a message with the same code and object at
+     *  most once per repeat interval, and delivers at most a set number of
+     *  messages per second overall, errors excepted. Suppressed repeats are
+     *  reported in the repeatCount of the next delivery of that message.
+     *
+     *  Since messages are delivered later, the offending Vulkan call is never
+     *  aborted, whatever the wrapped callback returns.
+     */
+    class AsyncDebugCallback : public DebugCallback
+    {
+        public:
+
+            /*! @brief Messages are truncated to fit a slot.
+             */
+            static const size_t MaxMessageLength = 1023;
+            static const size_t MaxLayerPrefixLength = 31;
+
+            struct Settings
+            {
+                Settings();
+
+                /*! @brief The number of slots in the ring, rounded up to a
+                 *      power of two.
+                 */
+                size_t capacity;
+
+                /*! @brief The minimum time between deliveries of messages with
+                 *      the same code and object. 0 delivers every message.
+                 */
+                std::chrono::milliseconds repeatInterval;
+
+                /*! @brief The maximum number of messages delivered per second,
+                 *      not counting errors. 0 means no limit.
+                 */
+                uint32_t maxPerSecond;
+
+                /*! @brief How often the drain thread wakes up.
+                 */
+                std::chrono::milliseconds drainInterval;
+            };
+
+            struct Statistics
+            {
+                uint64_t delivered;
+                uint64_t dropped;
+                uint64_t repeated;
+                uint64_t rateLimited;
+            };
+
+            /*! @brief Starts the drain thread.
+             *  @param callback The callback messages are delivered to.
+             */
+            explicit AsyncDebugCallback(std::shared_ptr<DebugCallback> callback,
+                const Settings& settings = Settings());
+
+            /*! @brief Delivers the queued messages and stops the drain thread.
+             */
+            ~AsyncDebugCallback();
+
+            /*! @brief Queues the message. Never blocks and never aborts the
+             *      call.
+             */
+            bool operator()(const CallbackData& data) override;
+
+            /*! @brief Delivers every queued message before returning.
+             */
+            void flush();
+
+            /*! @brief Returns how many messages were delivered, dropped because
+             *      the ring was full, suppressed as repeats, and suppressed by
+             *      the rate limit.
+             */
+            Statistics getStatistics() const;
+
+        private:
+
+            using Clock = std::chrono::steady_clock;
+            using Key = std::pair<int32_t, uint64_t>;
+
+            struct Slot
+            {
+                std::atomic<size_t> sequence;
+                VkDebugReportFlagsEXT flags;
+                VkDebugReportObjectTypeEXT objectType;
+                uint64_t object;
+                size_t location;
+                int32_t messageCode;
+                char layerPrefix[MaxLayerPrefixLength + 1];
+                char message[MaxMessageLength + 1];
+            };
+
+            struct Repeat
+            {
+                Clock::time_point lastDelivery;
+                uint32_t suppressed;
+            };
+
+            AsyncDebugCallback(const AsyncDebugCallback&) = delete;
+            AsyncDebugCallback& operator=(const AsyncDebugCallback&) = delete;
+
+            void run();
+            void drain();
+            void deliver(const Slot& slot, Clock::time_point now);
+
+            std::shared_ptr<DebugCallback> mCallback;
+            Settings mSettings;
+
+            // The ring is a bounded MPMC queue used with a single consumer
+            std::unique_ptr<Slot[]> mSlots;
+            size_t mMask;
+            std::atomic<size_t> mEnqueuePosition;
+            size_t mDequeuePosition;
+
+            std::atomic<uint64_t> mDelivered;
+            std::atomic<uint64_t> mDropped;
+            std::atomic<uint64_t> mRepeated;
+            std::atomic<uint64_t> mRateLimited;
+
+            // Only touched while draining
+            std::mutex mDrainMutex;
+            std::map<Key, Repeat> mRepeats;
+            Clock::time_point mRateWindowStart;
+            uint32_t mRateWindowCount;
+
+            std::mutex mThreadMutex;
+            std::condition_variable mWakeUp;
+            bool mStop;
+            std::thread mThread;
+    };
+}
+
+#endif
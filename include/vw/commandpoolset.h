@@ -0,0 +1,100 @@
+#ifndef VW_COMMANDPOOLSET_H
+#define VW_COMMANDPOOLSET_H
+
+#include <vw/common.h>
+#include <atomic>
+#include <vector>
+
+namespace vw
+{
+    class Device;
+    class QueueFamily;
+
+    /*! @brief Keeps one VkCommandPool per thread per frame in flight, so
+     *      threads can record without sharing an externally synchronized
+     *      pool.
+     *
+     *  Threads are identified by an index in [0, threadCount). Each thread may
+     *  only use its own index. Command buffers are never freed individually;
+     *  instead a pool is reset as a whole the first time its thread allocates
+     *  from it in a new frame, and its command buffers are handed out again.
+     *  Once every thread has allocated a frame's worth of command buffers,
+     *  allocation does no heap or driver allocations.
+     */
+    class CommandPoolSet
+    {
+        public:
+
+            /*! @brief Creates the pools on the device for the given family.
+             *  @param threadCount The number of threads that will record.
+             *  @param framesInFlight The number of frames the device may be
+             *      working on at once.
+             */
+            CommandPoolSet(Device& device, const QueueFamily& family,
+                uint32_t threadCount, uint32_t framesInFlight);
+
+            /*! @brief Destroys every pool along with its command buffers.
+             */
+            ~CommandPoolSet();
+
+            /*! @brief Advances to the next frame. The pools of the frame being
+             *      reused will be reset, so the device must be done with the
+             *      work recorded in them framesInFlight frames ago.
+             *  @note Must not be called while threads are allocating.
+             */
+            void beginFrame();
+
+            /*! @brief Returns a command buffer ready to be begun. It stays
+             *      valid until this thread's pool for the frame is reset.
+             *  @param thread The index of the calling thread.
+             */
+            VkCommandBuffer allocate(uint32_t thread,
+                VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+            /*! @brief Returns the pool the thread allocates from in the
+             *      current frame.
+             */
+            VkCommandPool getPool(uint32_t thread);
+
+            /*! @brief Returns the number of threads the set was created for.
+             */
+            uint32_t getThreadCount() const;
+
+            /*! @brief Returns the number of frames in flight.
+             */
+            uint32_t getFramesInFlight() const;
+
+            /*! @brief Returns the index of the queue family the pools were
+             *      created for.
+             */
+            uint32_t getFamilyIndex() const;
+
+        private:
+
+            // Each slot is used by a single thread, so it is padded to keep
+            // slots of different threads off the same cache line.
+            struct Slot
+            {
+                VkCommandPool pool;
+                uint64_t frame;
+                std::vector<VkCommandBuffer> buffers[2];
+                size_t used[2];
+                char padding[64];
+            };
+
+            CommandPoolSet(const CommandPoolSet&) = delete;
+            CommandPoolSet& operator=(const CommandPoolSet&) = delete;
+
+            Slot& getSlot(uint32_t thread);
+            void destroy();
+
+            Device& mDevice;
+            uint32_t mFamilyIndex;
+            uint32_t mThreadCount;
+            uint32_t mFramesInFlight;
+            std::atomic<uint64_t> mFrame;
+            std::vector<Slot> mSlots;
+    };
+}
+
+#endif
@@ -0,0 +1,212 @@
+#ifndef VW_COMPUTECONTEXT_H
+#define VW_COMPUTECONTEXT_H
+
+#include <vw/common.h>
+#include <vw/timelinesemaphore.h>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace vw
+{
+    class Device;
+    class Queue;
+
+    /*! @brief Runs SPIR-V compute kernels on the device's compute queue
+     *      without any setup beyond the kernel and its buffers.
+     *
+     *  A kernel is identified by its code, entry point, binding layout and
+     *  push constant size. Its descriptor set layout, pipeline layout and
+     *  pipeline are built the first time it is dispatched and kept for the
+     *  lifetime of the context. Its shader module comes from the device's
+     *  ShaderModuleCache and is only held while the pipeline is built.
+     *
+     *  Dispatches are recorded into the open batch, which holds a command
+     *  buffer and a descriptor pool, and the batch is submitted once it is
+     *  full, on flush(), or when one of its tickets is waited on. A ticket is
+     *  the value the context's timeline reaches once the dispatch completes.
+     *  Each dispatch waits for the writes of the dispatches before it, and
+     *  every batch makes its writes visible to the host.
+     *
+     *  All functions may be called from any thread.
+     */
+    class ComputeContext
+    {
+        public:
+
+            /*! @brief The largest number of buffers a kernel may bind.
+             */
+            static const uint32_t MaxBindings = 16;
+
+            /*! @brief The largest push constant block a kernel may use. This
+             *      is the minimum every device supports.
+             */
+            static const uint32_t MaxPushConstantSize = 128;
+
+            /*! @brief A buffer bound to set 0 of a kernel.
+             */
+            struct Binding
+            {
+                uint32_t binding;
+
+                /*! @brief VK_DESCRIPTOR_TYPE_STORAGE_BUFFER or
+                 *      VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER.
+                 */
+                VkDescriptorType type;
+
+                VkBuffer buffer;
+                VkDeviceSize offset;
+                VkDeviceSize range;
+            };
+
+            struct Settings
+            {
+                Settings();
+
+                /*! @brief The number of batches that may be in flight. Opening
+                 *      a batch waits for the device to finish the one
+                 *      recorded that many batches ago.
+                 */
+                uint32_t batchCount;
+
+                /*! @brief The number of dispatches after which a batch is
+                 *      submitted.
+                 */
+                uint32_t dispatchesPerBatch;
+
+                /*! @brief An optional cache to create pipelines with.
+                 */
+                VkPipelineCache pipelineCache;
+            };
+
+            /*! @brief Identifies a kernel built by getKernel().
+             */
+            using KernelId = uint32_t;
+
+            /*! @brief Creates the command and descriptor pools of each batch.
+             *      The device must have timeline semaphores enabled.
+             */
+            explicit ComputeContext(Device& device, const Settings& settings = Settings());
+
+            /*! @brief Submits the open batch, waits for every batch and
+             *      destroys the kernels.
+             */
+            ~ComputeContext();
+
+            /*! @brief Returns the kernel for the code, building it if it was
+             *      never seen before. Looking up a kernel hashes its code, so
+             *      callers dispatching often should keep the id.
+             *  @param code The SPIR-V words.
+             *  @param codeSize The size of the code in bytes.
+             *  @param bindings The buffers the kernel binds. Only their binding
+             *      numbers and types are used.
+             *  @param pushConstantSize The size of the kernel's push constant
+             *      block, or 0 if it has none.
+             */
+            KernelId getKernel(const uint32_t* code, size_t codeSize,
+                uint32_t bindingCount, const Binding* bindings,
+                uint32_t pushConstantSize, const char* entryPoint = "main");
+
+            /*! @brief Records a dispatch of the kernel.
+             *  @param bindings The buffers to bind, matching the binding
+             *      numbers and types the kernel was built with.
+             *  @param pushConstants The push constants, of the size the kernel
+             *      was built with.
+             *  @return The ticket of the dispatch.
+             */
+            uint64_t dispatch(KernelId kernel, uint32_t bindingCount,
+                const Binding* bindings, const void* pushConstants,
+                uint32_t groupCountX, uint32_t groupCountY = 1, uint32_t groupCountZ = 1);
+
+            /*! @brief Records a dispatch of the code's "main" entry point,
+             *      building the kernel if needed.
+             *  @return The ticket of the dispatch.
+             */
+            uint64_t dispatch(const uint32_t* code, size_t codeSize,
+                uint32_t bindingCount, const Binding* bindings,
+                const void* pushConstants, uint32_t pushConstantSize,
+                uint32_t groupCountX, uint32_t groupCountY = 1, uint32_t groupCountZ = 1);
+
+            /*! @brief Submits the open batch. If ending or submitting it
+             *      fails, its dispatches are discarded and their ticket is
+             *      signaled from the host before the error is rethrown, so
+             *      waits on it still return.
+             *  @return The ticket of the last dispatch recorded.
+             */
+            uint64_t flush();
+
+            /*! @brief Returns true once the dispatch of the ticket completes,
+             *      submitting it first if needed.
+             */
+            bool isComplete(uint64_t ticket);
+
+            /*! @brief Blocks until the dispatch of the ticket completes,
+             *      submitting it first if needed.
+             */
+            void wait(uint64_t ticket);
+
+            /*! @brief Returns the timeline signaled by the context's
+             *      submissions.
+             */
+            TimelineSemaphore& getTimeline();
+
+            /*! @brief Returns the queue dispatches are submitted to.
+             */
+            Queue& getQueue();
+
+        private:
+
+            using Layout = std::vector<std::pair<uint32_t, VkDescriptorType>>;
+
+            struct Kernel
+            {
+                std::vector<uint32_t> code;
+                std::string entryPoint;
+                Layout layout;
+                uint32_t pushConstantSize;
+
+                VkDescriptorSetLayout setLayout;
+                VkPipelineLayout pipelineLayout;
+                VkPipeline pipeline;
+            };
+
+            struct Batch
+            {
+                VkCommandPool commandPool;
+                VkCommandBuffer commandBuffer;
+                VkDescriptorPool descriptorPool;
+                uint64_t value;
+                uint32_t dispatchCount;
+            };
+
+            ComputeContext(const ComputeContext&) = delete;
+            ComputeContext& operator=(const ComputeContext&) = delete;
+
+            KernelId findKernel(uint64_t hash, const uint32_t* code, size_t codeSize,
+                const Layout& layout, uint32_t pushConstantSize, const char* entryPoint);
+            void buildKernel(Kernel& kernel);
+            void destroyKernel(Kernel& kernel);
+
+            Batch& beginBatch();
+            void submitBatch();
+
+            Device& mDevice;
+            Queue& mQueue;
+            Settings mSettings;
+            TimelineSemaphore mTimeline;
+
+            std::mutex mMutex;
+            std::vector<std::unique_ptr<Kernel>> mKernels;
+            std::unordered_multimap<uint64_t, KernelId> mKernelIndex;
+
+            std::vector<Batch> mBatches;
+            size_t mCurrentBatch;
+            bool mRecording;
+            bool mDispatched;
+            VkPipeline mBoundPipeline;
+    };
+}
+
+#endif
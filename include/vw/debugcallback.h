@@ -16,6 +16,10 @@ namespace vw
             int32_t messageCode;
             const char* layerPrefix;
             const char* message;
+
+            // The number of identical messages suppressed since this one was
+            // last delivered, when delivered by an AsyncDebugCallback
+            uint32_t repeatCount;
         };
 
         /*! @brief When set up correctly, this function will be called every
@@ -0,0 +1,114 @@
+#ifndef VW_DESCRIPTORALLOCATOR_H
+#define VW_DESCRIPTORALLOCATOR_H
+
+#include <vw/common.h>
+#include <atomic>
+#include <vector>
+
+namespace vw
+{
+    class Device;
+
+    /*! @brief Allocates descriptor sets from chains of VkDescriptorPools kept
+     *      per thread per frame in flight.
+     *
+     *  Threads are identified by an index in [0, threadCount) and only use
+     *  their own pools, so allocation takes no locks. Sets are never freed
+     *  individually; a thread's pools are reset as a whole the first time it
+     *  allocates in a new frame. When a pool runs out, another is chained. If
+     *  a frame needed more than one pool, the chain is replaced with a single
+     *  pool sized from the number of sets the frame used.
+     */
+    class DescriptorAllocator
+    {
+        public:
+
+            /*! @brief The number of descriptors of a type to reserve for each
+             *      set a pool can hold.
+             */
+            struct PoolRatio
+            {
+                VkDescriptorType type;
+                float perSet;
+            };
+
+            using PoolRatioList = std::vector<PoolRatio>;
+
+            /*! @brief Returns ratios suitable for typical material and
+             *      compute descriptor sets.
+             */
+            static PoolRatioList getDefaultRatios();
+
+            /*! @brief Constructs the allocator. Pools are created on demand.
+             *  @param threadCount The number of threads that will allocate.
+             *  @param framesInFlight The number of frames the device may be
+             *      working on at once.
+             *  @param setsPerPool The number of sets the first pool of each
+             *      thread can hold.
+             */
+            DescriptorAllocator(Device& device, uint32_t threadCount,
+                uint32_t framesInFlight, uint32_t setsPerPool = 64,
+                PoolRatioList ratios = getDefaultRatios());
+
+            /*! @brief Destroys every pool along with its descriptor sets.
+             */
+            ~DescriptorAllocator();
+
+            /*! @brief Advances to the next frame. The pools of the frame being
+             *      reused will be reset, so the device must be done with the
+             *      sets allocated from them framesInFlight frames ago.
+             *  @note Must not be called while threads are allocating.
+             */
+            void beginFrame();
+
+            /*! @brief Allocates a descriptor set with the layout. It stays
+             *      valid until this thread's pools for the frame are reset.
+             *  @param thread The index of the calling thread.
+             */
+            VkDescriptorSet allocate(uint32_t thread, VkDescriptorSetLayout layout);
+
+            /*! @brief Allocates a descriptor set for each of the layouts.
+             */
+            void allocate(uint32_t thread, uint32_t count,
+                const VkDescriptorSetLayout* layouts, VkDescriptorSet* sets);
+
+            /*! @brief Returns the number of threads the allocator was created
+             *      for.
+             */
+            uint32_t getThreadCount() const;
+
+            /*! @brief Returns the number of frames in flight.
+             */
+            uint32_t getFramesInFlight() const;
+
+        private:
+
+            // Each slot is used by a single thread, so it is padded to keep
+            // slots of different threads off the same cache line.
+            struct Slot
+            {
+                std::vector<VkDescriptorPool> pools;
+                size_t current;
+                uint32_t capacity;
+                uint32_t setsUsed;
+                uint64_t frame;
+                char padding[64];
+            };
+
+            DescriptorAllocator(const DescriptorAllocator&) = delete;
+            DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+            Slot& getSlot(uint32_t thread);
+            VkDescriptorPool createPool(uint32_t maxSets);
+            void destroyPools(Slot& slot);
+
+            Device& mDevice;
+            uint32_t mThreadCount;
+            uint32_t mFramesInFlight;
+            PoolRatioList mRatios;
+            std::atomic<uint64_t> mFrame;
+            std::vector<Slot> mSlots;
+    };
+}
+
+#endif
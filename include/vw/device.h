@@ -2,13 +2,23 @@
 #define VW_DEVICE_H
 
 #include <vw/common.h>
+#include <vw/physicaldevice.h>
 #include <vw/queue.h>
+#include <vw/result.h>
+#include <array>
+#include <memory>
 #include <vector>
 
 namespace vw
 {
-    class PhysicalDevice;
+    struct DeviceDispatch;
+    class HostAllocator;
+    class HostImport;
+    class Instance;
+    class MemoryAllocator;
     class QueueFamily;
+    class ShaderModuleCache;
+    class SyncPool;
 
     /*! @brief A wrapper for a VkDevice.
      */
@@ -16,6 +26,22 @@ namespace vw
     {
         public:
 
+            /*! @brief The kinds of work queues are addressed by.
+             */
+            enum QueueRole
+            {
+                QueueRole_Graphics,
+                QueueRole_Compute,
+                QueueRole_Transfer,
+                QueueRole_Count
+            };
+
+            /*! @brief The position in the queue list of each role's queue.
+             */
+            using QueueRoles = std::array<size_t, QueueRole_Count>;
+
+            using HostAllocatorPtr = std::shared_ptr<HostAllocator>;
+
             /*! @brief A wrapper for a container allowing non-const access to
              *      the data, but not allowing modifications to the container.
              */
@@ -80,10 +106,28 @@ namespace vw
              */
             Device();
 
-            /*! @brief Constructs a Device with the specified handle and queues.
-             *      Ownership of the handle is assumed.
+            /*! @brief Constructs a Device with the specified handle, function
+             *      table and queues. Ownership of the handle is assumed.
+             *  @param physicalDevice The PhysicalDevice the handle was created
+             *      on.
+             *  @param timelineSemaphores True if the handle was created with
+             *      timeline semaphores enabled.
+             *  @param roles The queue used for each role. By default every
+             *      role uses the first queue.
+             *  @param hostAllocator The allocator the handle was created with,
+             *      if any. Objects created from the device use it too.
+             *  @param hostImportAlignment The minImportedHostPointerAlignment
+             *      of the physical device if the handle was created with
+             *      VK_EXT_external_memory_host enabled, and 0 otherwise.
+             *  @param enabledFeatures The features the handle was created
+             *      with, if any.
              */
-            Device(VkDevice handle, QueueList queues);
+            Device(VkDevice handle, const PhysicalDevice& physicalDevice,
+                std::unique_ptr<DeviceDispatch> dispatch, QueueList queues,
+                bool timelineSemaphores = false, QueueRoles roles = QueueRoles(),
+                HostAllocatorPtr hostAllocator = nullptr,
+                VkDeviceSize hostImportAlignment = 0,
+                const VkPhysicalDeviceFeatures* enabledFeatures = nullptr);
 
             /*! @brief Move constructor that loots the other's VkDevice handle.
              */
@@ -109,6 +153,66 @@ namespace vw
              */
             const QueueList& getQueues() const;
 
+            /*! @brief Retrieves the queue chosen for a role. Roles share a
+             *      queue when the device has no separate one for them.
+             */
+            Queue& getQueue(QueueRole role);
+
+            /*! @brief Returns true if the role has a queue that no role before
+             *      it uses, so its work can overlap with theirs.
+             */
+            bool hasDedicatedQueue(QueueRole role) const;
+
+            /*! @brief Blocks until all work on the device completes.
+             */
+            void waitIdle();
+
+            /*! @brief Retrieves the device level functions loaded for this
+             *      device. Calls made through the table skip the loader.
+             */
+            const DeviceDispatch& getDispatch() const;
+
+            /*! @brief Retrieves the PhysicalDevice the device was created on.
+             */
+            const PhysicalDevice& getPhysicalDevice() const;
+
+            /*! @brief Retrieves the features the device was created with.
+             *      Features the PhysicalDevice supports but were not enabled
+             *      may not be used.
+             */
+            const VkPhysicalDeviceFeatures& getEnabledFeatures() const;
+
+            /*! @brief Retrieves the allocator that sub-allocates device memory
+             *      for this device.
+             */
+            MemoryAllocator& getMemoryAllocator();
+
+            /*! @brief Retrieves the pool of fences, semaphores and events, and
+             *      the timeline semaphores of the queues.
+             */
+            SyncPool& getSyncPool();
+
+            /*! @brief Retrieves the cache that shares shader modules between
+             *      users of the same SPIR-V. Handles to its modules must be
+             *      released before the device is destroyed.
+             */
+            ShaderModuleCache& getShaderModuleCache();
+
+            /*! @brief Retrieves the facility that makes host memory usable by
+             *      the device, importing it when the device supports it.
+             */
+            HostImport& getHostImport();
+
+            /*! @brief Returns the callbacks to pass when creating and
+             *      destroying objects of this device, or null if the
+             *      implementation allocates on its own.
+             */
+            const VkAllocationCallbacks* getAllocationCallbacks() const;
+
+            /*! @brief Returns the allocator the device was created with.
+             */
+            const HostAllocatorPtr& getHostAllocator() const;
+
             /*! @brief Retrieve the underlying VkDevice handle of the object.
              */
             VkDevice getHandle();
@@ -118,8 +222,19 @@ namespace vw
             Device(const Device& other) = delete;
             Device& operator=(const Device& other) = delete;
 
+            void destroy();
+
             VkDevice mHandle;
+            HostAllocatorPtr mHostAllocator;
+            PhysicalDevice mPhysicalDevice;
+            VkPhysicalDeviceFeatures mEnabledFeatures;
+            std::unique_ptr<DeviceDispatch> mDispatch;
+            std::unique_ptr<MemoryAllocator> mMemoryAllocator;
             QueueList mQueues;
+            QueueRoles mQueueRoles;
+            std::unique_ptr<SyncPool> mSyncPool;
+            std::unique_ptr<ShaderModuleCache> mShaderModuleCache;
+            std::unique_ptr<HostImport> mHostImport;
     };
 
     /*! @brief A convenience class for creating a Device.
@@ -139,6 +254,13 @@ namespace vw
              */
             void setPhysicalDevice(const PhysicalDevice& device);
 
+            /*! @brief Sets the Instance the PhysicalDevice belongs to. The
+             *      Device only gets what both the instance and the physical
+             *      device support, and without an Instance the creator
+             *      assumes one targeting Vulkan 1.0 without extensions.
+             */
+            void setInstance(Instance& instance);
+
             /*! @brief Adds queues from the specified family.
              *  @param family The queue family. Each family has specific sets of
              *      operations they support.
@@ -148,6 +270,15 @@ namespace vw
              */
             void addQueues(const QueueFamily& family, PriorityList priorities);
 
+            /*! @brief Adds queues for each Device::QueueRole, preferring
+             *      families dedicated to compute or transfer so that their
+             *      work can overlap with graphics. When there is no dedicated
+             *      compute family, a second queue of the graphics family is
+             *      used if there is one.
+             *  @return False if the PhysicalDevice has no graphics family.
+             */
+            bool planQueues();
+
             /*! @brief Adds the specified device layer.
              *  @param name The name of the layer.
              *  @note The specification has deprecated this function. Layers
@@ -167,24 +298,69 @@ namespace vw
              */
             void setEnabledFeatures(const VkPhysicalDeviceFeatures& features);
 
+            /*! @brief Enables timeline semaphores, adding the extension when
+             *      the instance or the device predates Vulkan 1.2. The Device
+             *      will then have a timeline semaphore for each queue.
+             *  @note Support is queried through vkGetPhysicalDeviceFeatures2,
+             *      so the Instance must be set and must target Vulkan 1.1 or
+             *      have VK_KHR_get_physical_device_properties2 enabled.
+             *      Creation fails with VK_ERROR_FEATURE_NOT_PRESENT otherwise,
+             *      or if the device lacks support.
+             */
+            void enableTimelineSemaphores();
+
+            /*! @brief Enables VK_EXT_external_memory_host if the device
+             *      supports it, so the Device's HostImport can import host
+             *      memory instead of copying it. When the instance or the
+             *      device predates Vulkan 1.1, VK_KHR_external_memory is
+             *      enabled too, which needs the Instance to be set with
+             *      VK_KHR_external_memory_capabilities enabled. Otherwise
+             *      the HostImport always copies.
+             */
+            void enableHostImport();
+
+            /*! @brief Sets the allocator the implementation allocates host
+             *      memory from for the device and the objects created from
+             *      it. By default the implementation uses its own.
+             */
+            void setHostAllocator(Device::HostAllocatorPtr allocator);
+
             /*! @brief Resets the DeviceCreator to a default state.
              */
             void reset();
 
-            /*! @brief Creates a Device and its queues. The queues added will be
-             *      cleared from the creator after creation.
+            /*! @brief Creates a Device and its queues, and loads the device
+             *      level function table. Each queue role is assigned the most
+             *      specialized queue that supports it. The queues added will
+             *      be cleared from the creator after creation.
              */
             Device create();
 
+            /*! @brief Creates a Device like create(), returning the error on
+             *      failure instead of throwing.
+             */
+            Result<Device> tryCreate() noexcept;
+
         private:
 
+            Device::QueueRoles assignQueueRoles(const Device::QueueList::Container& queues) const;
+            bool supportsTimelineSemaphores(uint32_t apiVersion) const;
+            VkDeviceSize getHostImportAlignment(uint32_t apiVersion) const;
+
             bool mDefineEnabledFeatures;
-            VkPhysicalDevice mPhysicalDevice;
+            bool mTimelineSemaphores;
+            bool mHostImport;
+            PhysicalDevice mPhysicalDevice;
+            VkInstance mInstance;
+            uint32_t mInstanceApiVersion;
+            bool mInstanceProperties2;
+            bool mInstanceExternalMemory;
             std::vector<VkDeviceQueueCreateInfo> mQueueInfos;
             PriorityList mQueuePriorities;
             std::vector<std::string> mLayers;
             std::vector<std::string> mExtensions;
             VkPhysicalDeviceFeatures mEnabledFeatures;
+            Device::HostAllocatorPtr mHostAllocator;
     };
 }
 
@@ -0,0 +1,146 @@
+#ifndef VW_DEVICECAPABILITIES_H
+#define VW_DEVICECAPABILITIES_H
+
+#include <vw/common.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace vw
+{
+    /*! @brief An immutable snapshot of what a physical device supports.
+     *
+     *  Each part (properties, features, memory properties, queue families
+     *  and extensions) is queried from the driver the first time it is
+     *  requested and never again. Parts may be requested from several
+     *  threads at once. Snapshots are shared, so every copy of a
+     *  PhysicalDevice reads the same one.
+     */
+    class DeviceCapabilities
+    {
+        public:
+
+            using QueueFamilyPropertiesList = std::vector<VkQueueFamilyProperties>;
+            using ExtensionList = std::vector<VkExtensionProperties>;
+
+            /*! @brief Constructs a snapshot of the device that queries nothing
+             *      until a part is requested.
+             */
+            explicit DeviceCapabilities(VkPhysicalDevice handle);
+
+            /*! @brief Returns the properties of the device.
+             */
+            const VkPhysicalDeviceProperties& getProperties() const;
+
+            /*! @brief Returns the features the device supports.
+             */
+            const VkPhysicalDeviceFeatures& getFeatures() const;
+
+            /*! @brief Returns the memory heaps and types of the device.
+             */
+            const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const;
+
+            /*! @brief Returns the properties of each queue family, in family
+             *      index order.
+             */
+            const QueueFamilyPropertiesList& getQueueFamilyProperties() const;
+
+            /*! @brief Returns the device extensions the implementation
+             *      provides.
+             */
+            const ExtensionList& getExtensions() const;
+
+            /*! @brief Returns true if the device provides the extension.
+             */
+            bool hasExtension(const std::string& name) const;
+
+            /*! @brief Queries every part that was not queried yet.
+             */
+            void populate() const;
+
+            /*! @brief Returns the device the snapshot describes.
+             */
+            VkPhysicalDevice getHandle() const;
+
+        private:
+
+            friend class CapabilityCache;
+
+            DeviceCapabilities(VkPhysicalDevice handle, const DeviceCapabilities& other);
+
+            DeviceCapabilities(const DeviceCapabilities&) = delete;
+            DeviceCapabilities& operator=(const DeviceCapabilities&) = delete;
+
+            VkPhysicalDevice mHandle;
+
+            mutable std::once_flag mPropertiesFlag;
+            mutable std::once_flag mFeaturesFlag;
+            mutable std::once_flag mMemoryFlag;
+            mutable std::once_flag mQueueFamiliesFlag;
+            mutable std::once_flag mExtensionsFlag;
+
+            mutable VkPhysicalDeviceProperties mProperties;
+            mutable VkPhysicalDeviceFeatures mFeatures;
+            mutable VkPhysicalDeviceMemoryProperties mMemoryProperties;
+            mutable QueueFamilyPropertiesList mQueueFamilies;
+            mutable ExtensionList mExtensions;
+    };
+
+    /*! @brief Snapshots of physical devices saved to a binary file, so warm
+     *      starts can choose a device without querying it again.
+     *
+     *  Snapshots are keyed by vendor ID, device ID, driver version, API
+     *  version and pipeline cache UUID. Only core properties are needed to
+     *  look one up, and a driver update invalidates it. The file records the
+     *  sizes of the structures it holds, so a file written by a build with
+     *  different Vulkan headers is ignored.
+     */
+    class CapabilityCache
+    {
+        public:
+
+            using CapabilitiesPtr = std::shared_ptr<const DeviceCapabilities>;
+
+            /*! @brief Constructs an empty cache.
+             */
+            CapabilityCache();
+
+            /*! @brief Replaces the snapshots with those in the file.
+             *  @return False if the file is missing or invalid, in which case
+             *      the cache is left empty.
+             */
+            bool load(const std::string& path);
+
+            /*! @brief Writes every snapshot to the file, querying any missing
+             *      parts first. The file is replaced atomically.
+             *  @return False if the file could not be written.
+             */
+            bool save(const std::string& path) const;
+
+            /*! @brief Returns a snapshot of the device matching its
+             *      properties, or null if there is none.
+             */
+            CapabilitiesPtr find(VkPhysicalDevice handle,
+                const VkPhysicalDeviceProperties& properties) const;
+
+            /*! @brief Adds a snapshot, replacing any with the same key.
+             */
+            void add(CapabilitiesPtr capabilities);
+
+            /*! @brief Returns true if snapshots were added since the last load
+             *      or save, meaning the file is out of date.
+             */
+            bool isDirty() const;
+
+        private:
+
+            CapabilityCache(const CapabilityCache&) = delete;
+            CapabilityCache& operator=(const CapabilityCache&) = delete;
+
+            mutable std::mutex mMutex;
+            std::vector<CapabilitiesPtr> mEntries;
+            mutable bool mDirty;
+    };
+}
+
+#endif
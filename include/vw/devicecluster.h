@@ -0,0 +1,186 @@
+#ifndef VW_DEVICECLUSTER_H
+#define VW_DEVICECLUSTER_H
+
+#include <vw/common.h>
+#include <vw/computecontext.h>
+#include <vw/device.h>
+#include <vw/physicaldevice.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vw
+{
+    class Instance;
+
+    /*! @brief Spreads compute work over several devices.
+     *
+     *  The cluster creates a Device and a ComputeContext for each physical
+     *  device it is given, and a worker thread per device. Tasks are queued
+     *  on the device expected to finish its queue first, going by the
+     *  throughput measured for each device so far, where devices yet to
+     *  complete a task count as the average of the others. A worker whose
+     *  queue runs dry steals the newest task of the most loaded device,
+     *  trying devices of its own device group first, since they can share
+     *  memory.
+     *
+     *  Physical devices reported in the same device group by
+     *  vkEnumeratePhysicalDeviceGroups share a group index. Each still gets a
+     *  Device of its own, so tasks never need device masks.
+     */
+    class DeviceCluster
+    {
+        public:
+
+            /*! @brief Records work on a device's context.
+             *  @param device The index of the device in the cluster.
+             *  @return The ticket of the last dispatch recorded. The task is
+             *      complete once the context reaches it.
+             */
+            using Task = std::function<uint64_t(ComputeContext& context, uint32_t device)>;
+
+            struct Settings
+            {
+                Settings();
+
+                /*! @brief The settings of every device's ComputeContext.
+                 */
+                ComputeContext::Settings compute;
+
+                /*! @brief The number of tasks a worker keeps submitted before
+                 *      waiting for the oldest, so the device is never idle
+                 *      while the next task is recorded.
+                 */
+                uint32_t tasksInFlight;
+
+                /*! @brief The weight of each new measurement in a device's
+                 *      throughput, in (0, 1].
+                 */
+                double smoothing;
+            };
+
+            struct Statistics
+            {
+                uint64_t taskCount;
+
+                /*! @brief The tasks taken from another device's queue.
+                 */
+                uint64_t stolenCount;
+
+                /*! @brief The cost of the tasks completed.
+                 */
+                double cost;
+
+                /*! @brief The measured cost completed per second, or 0 before
+                 *      the first task completes.
+                 */
+                double throughput;
+            };
+
+            /*! @brief Creates a device for each physical device, with timeline
+             *      semaphores enabled, and starts the workers.
+             *  @param instance The instance the physical devices belong to,
+             *      queried for device groups.
+             */
+            DeviceCluster(Instance& instance, const std::vector<PhysicalDevice>& physicalDevices,
+                const Settings& settings = Settings());
+
+            /*! @brief Runs the queued tasks, then joins the workers.
+             */
+            ~DeviceCluster();
+
+            /*! @brief Queues a task on the device expected to finish it first.
+             *  @param cost The amount of work in the task, in any unit used
+             *      consistently. Throughput is measured in cost per second.
+             */
+            void submit(Task task, double cost = 1.0);
+
+            /*! @brief Blocks until every task submitted has completed. If a
+             *      task threw, the first exception is rethrown.
+             */
+            void waitIdle();
+
+            /*! @brief Returns the number of devices.
+             */
+            uint32_t getDeviceCount() const;
+
+            /*! @brief Returns a device of the cluster.
+             */
+            Device& getDevice(uint32_t device);
+
+            /*! @brief Returns the context tasks of a device record on.
+             */
+            ComputeContext& getComputeContext(uint32_t device);
+
+            /*! @brief Returns the index of the device group the device belongs
+             *      to. Devices not in a group with others get one each.
+             */
+            uint32_t getGroup(uint32_t device) const;
+
+            /*! @brief Returns the work done by a device so far.
+             */
+            Statistics getStatistics(uint32_t device) const;
+
+        private:
+
+            using Clock = std::chrono::steady_clock;
+
+            struct Queued
+            {
+                Task task;
+                double cost;
+            };
+
+            struct Submitted
+            {
+                uint64_t ticket;
+                double cost;
+                Clock::time_point start;
+            };
+
+            struct Member
+            {
+                Device device;
+                std::unique_ptr<ComputeContext> context;
+                uint32_t group;
+
+                mutable std::mutex mutex;
+                std::deque<Queued> tasks;
+                double queuedCost;
+                double throughput;
+                Statistics statistics;
+                Clock::time_point lastCompletion;
+
+                std::thread thread;
+            };
+
+            DeviceCluster(const DeviceCluster&) = delete;
+            DeviceCluster& operator=(const DeviceCluster&) = delete;
+
+            void run(uint32_t index);
+            bool take(uint32_t index, Queued& queued);
+            bool steal(uint32_t index, Queued& queued);
+            void complete(Member& member, const Submitted& submitted);
+            double getFallbackThroughput() const;
+            double getExpectedTime(const Member& member, double cost, double fallback) const;
+
+            Settings mSettings;
+            std::vector<std::unique_ptr<Member>> mMembers;
+
+            std::mutex mMutex;
+            std::condition_variable mWork;
+            std::condition_variable mIdle;
+            uint64_t mPending;
+            uint64_t mGeneration;
+            bool mStopping;
+            std::exception_ptr mError;
+    };
+}
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef VW_DEVICEDISPATCH_H
+#define VW_DEVICEDISPATCH_H
+
+#include <vw/common.h>
+
+/*! @brief Expands X(name) for every Vulkan 1.0 device level command. The list
+ *      is used to declare and load the members of vw::DeviceDispatch.
+ */
+#define VW_DEVICE_FUNCTIONS(X) \
+    X(vkDestroyDevice) \
+    X(vkGetDeviceQueue) \
+    X(vkQueueSubmit) \
+    X(vkQueueWaitIdle) \
+    X(vkDeviceWaitIdle) \
+    X(vkAllocateMemory) \
+    X(vkFreeMemory) \
+    X(vkMapMemory) \
+    X(vkUnmapMemory) \
+    X(vkFlushMappedMemoryRanges) \
+    X(vkInvalidateMappedMemoryRanges) \
+    X(vkGetDeviceMemoryCommitment) \
+    X(vkBindBufferMemory) \
+    X(vkBindImageMemory) \
+    X(vkGetBufferMemoryRequirements) \
+    X(vkGetImageMemoryRequirements) \
+    X(vkGetImageSparseMemoryRequirements) \
+    X(vkQueueBindSparse) \
+    X(vkCreateFence) \
+    X(vkDestroyFence) \
+    X(vkResetFences) \
+    X(vkGetFenceStatus) \
+    X(vkWaitForFences) \
+    X(vkCreateSemaphore) \
+    X(vkDestroySemaphore) \
+    X(vkCreateEvent) \
+    X(vkDestroyEvent) \
+    X(vkGetEventStatus) \
+    X(vkSetEvent) \
+    X(vkResetEvent) \
+    X(vkCreateQueryPool) \
+    X(vkDestroyQueryPool) \
+    X(vkGetQueryPoolResults) \
+    X(vkCreateBuffer) \
+    X(vkDestroyBuffer) \
+    X(vkCreateBufferView) \
+    X(vkDestroyBufferView) \
+    X(vkCreateImage) \
+    X(vkDestroyImage) \
+    X(vkGetImageSubresourceLayout) \
+    X(vkCreateImageView) \
+    X(vkDestroyImageView) \
+    X(vkCreateShaderModule) \
+    X(vkDestroyShaderModule) \
+    X(vkCreatePipelineCache) \
+    X(vkDestroyPipelineCache) \
+    X(vkGetPipelineCacheData) \
+    X(vkMergePipelineCaches) \
+    X(vkCreateGraphicsPipelines) \
+    X(vkCreateComputePipelines) \
+    X(vkDestroyPipeline) \
+    X(vkCreatePipelineLayout) \
+    X(vkDestroyPipelineLayout) \
+    X(vkCreateSampler) \
+    X(vkDestroySampler) \
+    X(vkCreateDescriptorSetLayout) \
+    X(vkDestroyDescriptorSetLayout) \
+    X(vkCreateDescriptorPool) \
+    X(vkDestroyDescriptorPool) \
+    X(vkResetDescriptorPool) \
+    X(vkAllocateDescriptorSets) \
+    X(vkFreeDescriptorSets) \
+    X(vkUpdateDescriptorSets) \
+    X(vkCreateFramebuffer) \
+    X(vkDestroyFramebuffer) \
+    X(vkCreateRenderPass) \
+    X(vkDestroyRenderPass) \
+    X(vkGetRenderAreaGranularity) \
+    X(vkCreateCommandPool) \
+    X(vkDestroyCommandPool) \
+    X(vkResetCommandPool) \
+    X(vkAllocateCommandBuffers) \
+    X(vkFreeCommandBuffers) \
+    X(vkBeginCommandBuffer) \
+    X(vkEndCommandBuffer) \
+    X(vkResetCommandBuffer) \
+    X(vkCmdBindPipeline) \
+    X(vkCmdSetViewport) \
+    X(vkCmdSetScissor) \
+    X(vkCmdSetLineWidth) \
+    X(vkCmdSetDepthBias) \
+    X(vkCmdSetBlendConstants) \
+    X(vkCmdSetDepthBounds) \
+    X(vkCmdSetStencilCompareMask) \
+    X(vkCmdSetStencilWriteMask) \
+    X(vkCmdSetStencilReference) \
+    X(vkCmdBindDescriptorSets) \
+    X(vkCmdBindIndexBuffer) \
+    X(vkCmdBindVertexBuffers) \
+    X(vkCmdDraw) \
+    X(vkCmdDrawIndexed) \
+    X(vkCmdDrawIndirect) \
+    X(vkCmdDrawIndexedIndirect) \
+    X(vkCmdDispatch) \
+    X(vkCmdDispatchIndirect) \
+    X(vkCmdCopyBuffer) \
+    X(vkCmdCopyImage) \
+    X(vkCmdBlitImage) \
+    X(vkCmdCopyBufferToImage) \
+    X(vkCmdCopyImageToBuffer) \
+    X(vkCmdUpdateBuffer) \
+    X(vkCmdFillBuffer) \
+    X(vkCmdClearColorImage) \
+    X(vkCmdClearDepthStencilImage) \
+    X(vkCmdClearAttachments) \
+    X(vkCmdResolveImage) \
+    X(vkCmdSetEvent) \
+    X(vkCmdResetEvent) \
+    X(vkCmdWaitEvents) \
+    X(vkCmdPipelineBarrier) \
+    X(vkCmdBeginQuery) \
+    X(vkCmdEndQuery) \
+    X(vkCmdResetQueryPool) \
+    X(vkCmdWriteTimestamp) \
+    X(vkCmdCopyQueryPoolResults) \
+    X(vkCmdPushConstants) \
+    X(vkCmdBeginRenderPass) \
+    X(vkCmdNextSubpass) \
+    X(vkCmdEndRenderPass) \
+    X(vkCmdExecuteCommands)
+
+/*! @brief Expands X(name, suffix) for device level commands promoted to
+ *      core after Vulkan 1.0. They are loaded under their core name first and
+ *      their extension name second, and are null when neither is available.
+ */
+#define VW_DEVICE_FUNCTIONS_PROMOTED(X) \
+    X(vkGetSemaphoreCounterValue, KHR) \
+    X(vkWaitSemaphores, KHR) \
+    X(vkSignalSemaphore, KHR)
+
+/*! @brief Expands X(name) for device level commands only exposed by
+ *      extensions. They are null unless the extension was enabled.
+ */
+#define VW_DEVICE_FUNCTIONS_EXTENSION(X) \
+    X(vkGetMemoryHostPointerPropertiesEXT)
+
+namespace vw
+{
+    /*! @brief A table of device level functions retrieved directly from the
+     *      driver with vkGetDeviceProcAddr. Calling through the table skips
+     *      the loader's trampoline and dispatch chain.
+     */
+    struct DeviceDispatch
+    {
+        /*! @brief Constructs a table with every function set to null.
+         */
+        DeviceDispatch();
+
+        /*! @brief Constructs a table with the functions of the given device.
+         */
+        explicit DeviceDispatch(VkDevice device);
+
+        /*! @brief Loads every function for the given device. Functions the
+         *      device does not expose are set to null.
+         */
+        void load(VkDevice device);
+
+#define VW_DECLARE_DEVICE_FUNCTION(name) PFN_##name name;
+#define VW_DECLARE_PROMOTED_FUNCTION(name, suffix) PFN_##name name;
+        VW_DEVICE_FUNCTIONS(VW_DECLARE_DEVICE_FUNCTION)
+        VW_DEVICE_FUNCTIONS_PROMOTED(VW_DECLARE_PROMOTED_FUNCTION)
+        VW_DEVICE_FUNCTIONS_EXTENSION(VW_DECLARE_DEVICE_FUNCTION)
+#undef VW_DECLARE_PROMOTED_FUNCTION
+#undef VW_DECLARE_DEVICE_FUNCTION
+    };
+}
+
+#endif
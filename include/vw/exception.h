@@ -2,10 +2,13 @@
 #define VW_EXCEPTION_H
 
 #include <vw/common.h>
+#include <atomic>
 
 namespace vw
 {
     /*! @brief An exception thrown whenever an unhandled Vulkan event occurs.
+     *      Constructing one allocates nothing. The message is only formatted
+     *      when asked for.
      */
     class Exception
     {
@@ -13,29 +16,53 @@ namespace vw
 
             /*! @brief Constructs an exception using the provided details.
              *  @param location Preferably a function name. For example,
-             *      vw::InstanceCreator::create.
+             *      vw::InstanceCreator::create. It is copied into a fixed
+             *      buffer, truncating names longer than it.
              *  @param errorCode The result returned from a vulkan function
              *      call.
              */
+            Exception(const char* location, VkResult errorCode);
+
+            /*! @brief Constructs an exception using the provided details.
+             */
             Exception(const std::string& location, VkResult errorCode);
 
+            /*! @brief Copies the details of the other. The message is
+             *      formatted again when asked for.
+             */
+            Exception(const Exception& other);
+
+            /*! @brief Frees the message if it was formatted.
+             */
+            ~Exception();
+
+            /*! @brief Copies the details of the other.
+             */
+            Exception& operator=(const Exception& other);
+
             /*! @brief Returns the error code returned by Vulkan, allowing an
              *      implementation to recover when possible.
              */
             VkResult getErrorCode() const;
 
+            /*! @brief Returns where the exception was thrown.
+             */
+            const char* getLocation() const;
+
             /*! @brief Returns a human readable error message providing details
-             *      of the offending error.
+             *      of the offending error. Safe to call from several threads.
              */
             const std::string& getErrorMessage() const;
 
         private:
 
-            void setup(const std::string& location, const std::string& msg);
-            std::string getVulkanResultString(VkResult result) const;
+            static const size_t LocationSize = 128;
+
+            void setLocation(const char* location);
 
-            std::string mErrorMsg;
+            char mLocation[LocationSize];
             VkResult mErrorCode;
+            mutable std::atomic<std::string*> mErrorMsg;
     };
 }
 
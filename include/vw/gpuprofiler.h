@@ -0,0 +1,140 @@
+#ifndef VW_GPUPROFILER_H
+#define VW_GPUPROFILER_H
+
+#include <vw/common.h>
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace vw
+{
+    class Device;
+    class QueueFamily;
+
+    /*! @brief Measures GPU time spent in named scopes with timestamp queries.
+     *
+     *  Queries come from a single VkQueryPool split into one segment per frame
+     *  in flight. A segment's results are read back when it is about to be
+     *  reused, by which point the device is done with it, so resolving never
+     *  waits. Timestamps are masked to the valid bits of the queue family and
+     *  converted to nanoseconds with the device's timestampPeriod. Durations
+     *  are gathered into a histogram per scope.
+     */
+    class GpuProfiler
+    {
+        public:
+
+            using ScopeId = uint32_t;
+            using Token = uint32_t;
+
+            /*! @brief The token returned when a scope could not be recorded.
+             */
+            static const Token InvalidToken = ~0u;
+
+            /*! @brief Durations of a scope. Bucket 0 counts durations under a
+             *      microsecond, and bucket i > 0 counts those in
+             *      [2^(i-1), 2^i) microseconds.
+             */
+            struct Histogram
+            {
+                static const size_t BucketCount = 32;
+
+                uint64_t count;
+                double minNs;
+                double maxNs;
+                double totalNs;
+                std::array<uint64_t, BucketCount> buckets;
+            };
+
+            struct ScopeStatistics
+            {
+                std::string name;
+                Histogram histogram;
+            };
+
+            /*! @brief Creates the query pool. If the family does not support
+             *      timestamps, the profiler records nothing.
+             *  @param framesInFlight The number of frames the device may be
+             *      working on at once.
+             *  @param maxScopesPerFrame Scopes beyond this in a frame are
+             *      dropped.
+             */
+            GpuProfiler(Device& device, const QueueFamily& family,
+                uint32_t framesInFlight, uint32_t maxScopesPerFrame = 256);
+
+            /*! @brief Destroys the query pool.
+             */
+            ~GpuProfiler();
+
+            /*! @brief Returns the id of a named scope, registering it if
+             *      needed. Ids are stable, so this can be called once up front.
+             */
+            ScopeId getScope(const std::string& name);
+
+            /*! @brief Resolves the frame being reused and resets its queries in
+             *      the command buffer. The command buffer must execute before
+             *      any scopes of the frame, outside of a render pass.
+             *  @note Must not be called while scopes are being recorded.
+             */
+            void beginFrame(VkCommandBuffer commandBuffer);
+
+            /*! @brief Writes the starting timestamp of a scope. May be called
+             *      from several threads at once.
+             *  @return The token to pass to endScope().
+             */
+            Token beginScope(VkCommandBuffer commandBuffer, ScopeId scope,
+                VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+
+            /*! @brief Writes the ending timestamp of a scope.
+             */
+            void endScope(VkCommandBuffer commandBuffer, Token token,
+                VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+            /*! @brief Returns the histograms of every scope with results.
+             */
+            std::vector<ScopeStatistics> getStatistics() const;
+
+            /*! @brief Clears the gathered histograms.
+             */
+            void clearStatistics();
+
+            /*! @brief Returns true if the family supports timestamps.
+             */
+            bool isEnabled() const;
+
+        private:
+
+            struct Frame
+            {
+                uint32_t firstQuery;
+                std::atomic<uint32_t> scopeCount;
+                std::unique_ptr<ScopeId[]> scopes;
+            };
+
+            GpuProfiler(const GpuProfiler&) = delete;
+            GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+            void resolve(Frame& frame);
+            void record(ScopeId scope, double ns);
+
+            Device& mDevice;
+            VkQueryPool mPool;
+            uint32_t mMaxScopes;
+            uint64_t mMask;
+            double mPeriod;
+
+            uint64_t mFrameIndex;
+            std::vector<std::unique_ptr<Frame>> mFrames;
+            std::vector<uint64_t> mResults;
+
+            mutable std::mutex mScopeMutex;
+            std::map<std::string, ScopeId> mScopeIds;
+            std::vector<std::string> mScopeNames;
+            std::vector<Histogram> mHistograms;
+    };
+}
+
+#endif
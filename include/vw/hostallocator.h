@@ -0,0 +1,263 @@
+#ifndef VW_HOSTALLOCATOR_H
+#define VW_HOSTALLOCATOR_H
+
+#include <vw/common.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace vw
+{
+    /*! @brief Host memory the implementation allocates on behalf of the
+     *      application, handed out through VkAllocationCallbacks.
+     *
+     *  Subclasses only provide raw blocks. The base class aligns them, keeps
+     *  a small header in front of each allocation so reallocations and frees
+     *  know its size and scope, and keeps live counters per
+     *  VkSystemAllocationScope. The callbacks may be called from any thread.
+     *
+     *  An allocator must outlive every object created with its callbacks, so
+     *  Instance and Device hold on to theirs.
+     */
+    class HostAllocator
+    {
+        public:
+
+            /*! @brief The number of VkSystemAllocationScope values.
+             */
+            static const size_t ScopeCount = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+            struct Statistics
+            {
+                /*! @brief The bytes requested by live allocations.
+                 */
+                uint64_t bytes;
+
+                /*! @brief The number of live allocations.
+                 */
+                uint64_t allocations;
+
+                /*! @brief The number of allocations made so far, counting
+                 *      reallocations that moved.
+                 */
+                uint64_t totalAllocations;
+
+                /*! @brief The bytes the implementation reports having
+                 *      allocated itself, such as executable memory.
+                 */
+                uint64_t internalBytes;
+            };
+
+            HostAllocator();
+
+            virtual ~HostAllocator();
+
+            /*! @brief Returns the callbacks to pass to Vulkan. They stay
+             *      valid for the lifetime of the allocator.
+             */
+            const VkAllocationCallbacks* getCallbacks() const;
+
+            /*! @brief Returns the live counters of a scope.
+             */
+            Statistics getStatistics(VkSystemAllocationScope scope) const;
+
+            /*! @brief Returns the live counters of all scopes together.
+             */
+            Statistics getTotalStatistics() const;
+
+            /*! @brief Allocates memory as the implementation would. Returns
+             *      null on failure.
+             *  @param alignment A power of two.
+             */
+            void* allocate(size_t size, size_t alignment, VkSystemAllocationScope scope);
+
+            /*! @brief Resizes memory returned by allocate() or reallocate(),
+             *      preserving its contents up to the smaller size. A null
+             *      pointer allocates, and a size of 0 frees.
+             */
+            void* reallocate(void* memory, size_t size, size_t alignment,
+                VkSystemAllocationScope scope);
+
+            /*! @brief Frees memory returned by allocate() or reallocate().
+             *      Null is ignored.
+             */
+            void free(void* memory);
+
+        protected:
+
+            /*! @brief Blocks are aligned to at least this.
+             */
+            static const size_t BlockAlignment = alignof(std::max_align_t);
+
+            /*! @brief Returns a block of at least the size, aligned to
+             *      BlockAlignment, or null on failure.
+             */
+            virtual void* allocateBlock(size_t size, VkSystemAllocationScope scope) = 0;
+
+            /*! @brief Takes back a block with the size and scope it was
+             *      allocated with.
+             */
+            virtual void freeBlock(void* block, size_t size, VkSystemAllocationScope scope) = 0;
+
+        private:
+
+            struct Counters
+            {
+                std::atomic<uint64_t> bytes;
+                std::atomic<uint64_t> allocations;
+                std::atomic<uint64_t> totalAllocations;
+                std::atomic<uint64_t> internalBytes;
+            };
+
+            HostAllocator(const HostAllocator&) = delete;
+            HostAllocator& operator=(const HostAllocator&) = delete;
+
+            static VKAPI_ATTR void* VKAPI_CALL allocateCallback(void* userData,
+                size_t size, size_t alignment, VkSystemAllocationScope scope);
+            static VKAPI_ATTR void* VKAPI_CALL reallocateCallback(void* userData,
+                void* original, size_t size, size_t alignment,
+                VkSystemAllocationScope scope);
+            static VKAPI_ATTR void VKAPI_CALL freeCallback(void* userData,
+                void* memory);
+            static VKAPI_ATTR void VKAPI_CALL internalAllocationCallback(
+                void* userData, size_t size, VkInternalAllocationType type,
+                VkSystemAllocationScope scope);
+            static VKAPI_ATTR void VKAPI_CALL internalFreeCallback(void* userData,
+                size_t size, VkInternalAllocationType type,
+                VkSystemAllocationScope scope);
+
+            VkAllocationCallbacks mCallbacks;
+            std::array<Counters, ScopeCount> mCounters;
+    };
+
+    /*! @brief A HostAllocator that serves small allocations from size
+     *      classes carved out of slabs, and passes the rest to malloc.
+     *
+     *  Each thread is bound to one of a few caches of free blocks, so
+     *  threads rarely share a lock. A cache that runs dry takes a batch of
+     *  blocks from a shared depot, and one that grows too large gives half
+     *  back. Slabs are only released when the allocator is destroyed.
+     */
+    class PoolHostAllocator : public HostAllocator
+    {
+        public:
+
+            /*! @brief Blocks larger than this are passed to malloc.
+             */
+            static const size_t MaxPooledSize = 4096;
+
+            PoolHostAllocator();
+
+            ~PoolHostAllocator();
+
+        protected:
+
+            void* allocateBlock(size_t size, VkSystemAllocationScope scope) override;
+
+            void freeBlock(void* block, size_t size, VkSystemAllocationScope scope) override;
+
+        private:
+
+            static const size_t ClassCount = 9;
+            static const size_t CacheCount = 16;
+
+            struct FreeBlock
+            {
+                FreeBlock* next;
+            };
+
+            struct FreeList
+            {
+                FreeList();
+
+                void push(FreeBlock* block);
+                FreeBlock* pop();
+
+                FreeBlock* head;
+                size_t count;
+            };
+
+            struct Cache
+            {
+                std::mutex mutex;
+                std::array<FreeList, ClassCount> lists;
+            };
+
+            static size_t getClass(size_t size);
+            static size_t getClassSize(size_t sizeClass);
+
+            void refill(FreeList& list, size_t sizeClass);
+            void drain(FreeList& list, size_t sizeClass);
+
+            std::array<Cache, CacheCount> mCaches;
+
+            std::mutex mDepotMutex;
+            std::array<FreeList, ClassCount> mDepot;
+            std::vector<void*> mSlabs;
+    };
+
+    /*! @brief A HostAllocator for allocations that follow the lifetime of
+     *      their scope.
+     *
+     *  Command scope allocations only live for the duration of a Vulkan
+     *  call, so they are bump-allocated from chunks, and freeing them does
+     *  nothing but count. Each thread is bound to one of a few arenas, like
+     *  the caches of PoolHostAllocator, and an arena is rewound once none of
+     *  its allocations are live. Rewinding releases the chunks beyond the
+     *  first few, so a burst of large calls doesn't hold on to its memory.
+     *  Other scopes are pooled like PoolHostAllocator.
+     */
+    class ArenaHostAllocator : public PoolHostAllocator
+    {
+        public:
+
+            /*! @param chunkSize The size of each command scope chunk.
+             *      Larger allocations get a chunk of their own.
+             */
+            explicit ArenaHostAllocator(size_t chunkSize = 64 * 1024);
+
+            ~ArenaHostAllocator();
+
+            /*! @brief Returns the number of times an arena was rewound.
+             */
+            uint64_t getResetCount() const;
+
+        protected:
+
+            void* allocateBlock(size_t size, VkSystemAllocationScope scope) override;
+
+            void freeBlock(void* block, size_t size, VkSystemAllocationScope scope) override;
+
+        private:
+
+            static const size_t ArenaCount = 16;
+            static const size_t MaxIdleChunks = 4;
+
+            struct Chunk
+            {
+                char* data;
+                size_t size;
+            };
+
+            struct Arena
+            {
+                Arena();
+
+                std::mutex mutex;
+                std::vector<Chunk> chunks;
+                size_t currentChunk;
+                size_t offset;
+                size_t liveBlocks;
+            };
+
+            void rewind(Arena& arena);
+
+            size_t mChunkSize;
+            std::array<Arena, ArenaCount> mArenas;
+            std::atomic<uint64_t> mResetCount;
+    };
+}
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef VW_HOSTIMPORT_H
+#define VW_HOSTIMPORT_H
+
+#include <vw/common.h>
+#include <vw/memoryallocator.h>
+#include <atomic>
+
+namespace vw
+{
+    struct DeviceDispatch;
+
+    /*! @brief Makes host memory, such as a mmapped file, usable by the device
+     *      without copying it.
+     *
+     *  With VK_EXT_external_memory_host enabled, a region is imported as a
+     *  VkDeviceMemory aliasing the host pages and bound to a buffer. The
+     *  region is rounded out to minImportedHostPointerAlignment, so the pages
+     *  around it must be mapped too. This always holds for mmapped memory
+     *  when the alignment is no larger than the page size. The host memory
+     *  must stay mapped until the region is released.
+     *
+     *  When the extension is missing or the driver refuses the pointer, the
+     *  data is copied into a host visible buffer from the MemoryAllocator
+     *  instead. Either way the device reads the data through the region's
+     *  buffer. Each import takes a VkDeviceMemory of its own, so it is meant
+     *  for large regions.
+     */
+    class HostImport
+    {
+        public:
+
+            /*! @brief Host data made available to the device. It must be
+             *      returned with HostImport::release.
+             */
+            class Region
+            {
+                public:
+
+                    /*! @brief Constructs an invalid Region.
+                     */
+                    Region();
+
+                    /*! @brief Returns true if the region refers to a buffer.
+                     */
+                    operator bool() const;
+
+                    /*! @brief Returns the buffer holding the data.
+                     */
+                    VkBuffer getBuffer() const;
+
+                    /*! @brief Returns the offset of the data in the buffer.
+                     */
+                    VkDeviceSize getOffset() const;
+
+                    /*! @brief Returns the size of the data.
+                     */
+                    VkDeviceSize getSize() const;
+
+                    /*! @brief Returns true if the buffer aliases the host
+                     *      memory, and false if the data was copied.
+                     */
+                    bool isImported() const;
+
+                private:
+
+                    friend class HostImport;
+
+                    VkBuffer mBuffer;
+                    VkDeviceSize mOffset;
+                    VkDeviceSize mSize;
+                    VkDeviceMemory mMemory;
+                    Allocation mAllocation;
+            };
+
+            /*! @brief Constructs the facility for a device.
+             *  @param alignment The minImportedHostPointerAlignment of the
+             *      physical device if the device was created with
+             *      VK_EXT_external_memory_host enabled, and 0 to always copy.
+             *  @param callbacks The host allocation callbacks the device was
+             *      created with, if any.
+             */
+            HostImport(VkDevice device, const DeviceDispatch& dispatch,
+                MemoryAllocator& allocator, VkDeviceSize alignment,
+                const VkAllocationCallbacks* callbacks = nullptr);
+
+            /*! @brief Every region must have been released by now.
+             */
+            ~HostImport();
+
+            /*! @brief Returns true if regions can be imported rather than
+             *      copied.
+             */
+            bool isSupported() const;
+
+            /*! @brief Returns the alignment imported host pointers and sizes
+             *      are rounded to, or 0 if importing is not supported.
+             */
+            VkDeviceSize getAlignment() const;
+
+            /*! @brief Makes the host data available to the device, importing
+             *      it if possible and copying it otherwise. On failure, an
+             *      exception is thrown.
+             *  @param usage The usage of the region's buffer.
+             */
+            Region import(const void* data, VkDeviceSize size, VkBufferUsageFlags usage);
+
+            /*! @brief Destroys the region's buffer and frees its memory, and
+             *      resets the Region to an invalid state. The device must be
+             *      done with it.
+             */
+            void release(Region& region);
+
+            /*! @brief Returns the number of regions alive.
+             */
+            size_t getRegionCount() const;
+
+        private:
+
+            HostImport(const HostImport&) = delete;
+            HostImport& operator=(const HostImport&) = delete;
+
+            VkBuffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
+                bool external);
+            bool tryImport(const void* data, VkDeviceSize size,
+                VkBufferUsageFlags usage, Region& region);
+            void copy(const void* data, VkDeviceSize size,
+                VkBufferUsageFlags usage, Region& region);
+
+            VkDevice mDevice;
+            const DeviceDispatch& mDispatch;
+            MemoryAllocator& mAllocator;
+            const VkAllocationCallbacks* mCallbacks;
+            VkDeviceSize mAlignment;
+            std::atomic<size_t> mRegionCount;
+    };
+}
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef VW_IMAGECOPYPLANNER_H
+#define VW_IMAGECOPYPLANNER_H
+
+#include <vw/common.h>
+#include <vector>
+
+namespace vw
+{
+    class QueueFamily;
+
+    /*! @brief Turns dirty boxes of an image subresource into a few copy
+     *      regions that respect a queue family's image transfer granularity.
+     *
+     *  The level is divided into a grid of cells the size of the granularity.
+     *  Dirty boxes mark the cells they touch, and marked cells are merged
+     *  into boxes, first along rows, then across rows, then across slices.
+     *  Every resulting box starts on a cell boundary and either spans whole
+     *  cells or reaches the edge of the level, which is what copies on queues
+     *  with a coarse granularity require. A granularity of (0,0,0) only
+     *  allows whole levels, so any dirty box yields the whole level.
+     */
+    class ImageCopyPlanner
+    {
+        public:
+
+            /*! @brief A box of texels.
+             */
+            struct Box
+            {
+                VkOffset3D offset;
+                VkExtent3D extent;
+            };
+
+            /*! @brief Constructs a planner for one subresource.
+             *  @param granularity The minimum transfer granularity, in texel
+             *      blocks.
+             *  @param levelExtent The extent of the mip level in texels.
+             *  @param blockSize The size in bytes of a texel block.
+             *  @param blockExtent The extent of a texel block, which is not
+             *      (1,1,1) for compressed formats.
+             */
+            ImageCopyPlanner(VkExtent3D granularity, VkExtent3D levelExtent,
+                uint32_t blockSize, VkExtent3D blockExtent = VkExtent3D{ 1, 1, 1 });
+
+            /*! @brief Constructs a planner for copies on the family's queues.
+             */
+            ImageCopyPlanner(const QueueFamily& family, VkExtent3D levelExtent,
+                uint32_t blockSize, VkExtent3D blockExtent = VkExtent3D{ 1, 1, 1 });
+
+            /*! @brief Marks a box as needing to be copied. It is clipped to
+             *      the level.
+             */
+            void addDirty(const Box& box);
+
+            /*! @brief Clears every dirty box.
+             */
+            void clear();
+
+            /*! @brief Returns true if nothing is dirty.
+             */
+            bool isEmpty() const;
+
+            /*! @brief Returns the merged boxes to copy.
+             */
+            std::vector<Box> getRegions() const;
+
+            /*! @brief Returns the bytes needed to pack the regions with pack().
+             */
+            VkDeviceSize getPackedSize() const;
+
+            /*! @brief Returns the alignment of the buffer offsets produced by
+             *      pack(). The packed data must be placed at a multiple of it.
+             */
+            VkDeviceSize getOffsetAlignment() const;
+
+            /*! @brief Packs the regions from a full copy of the level in host
+             *      memory and returns the copies reading them.
+             *  @param src The level's texel blocks.
+             *  @param rowPitch The bytes between rows of blocks in src.
+             *  @param slicePitch The bytes between slices in src.
+             *  @param subresource The subresource the copies write.
+             *  @param dst Where to pack, at least getPackedSize() bytes. The
+             *      buffer offsets of the copies are relative to it.
+             */
+            std::vector<VkBufferImageCopy> pack(const void* src, size_t rowPitch,
+                size_t slicePitch, const VkImageSubresourceLayers& subresource,
+                void* dst) const;
+
+        private:
+
+            VkDeviceSize getRegionSize(const Box& box) const;
+            VkDeviceSize alignOffset(VkDeviceSize offset) const;
+
+            VkExtent3D mLevelExtent;
+            VkExtent3D mBlockExtent;
+            VkExtent3D mCellExtent;
+            VkExtent3D mGridExtent;
+            uint32_t mBlockSize;
+            VkDeviceSize mOffsetAlignment;
+            std::vector<uint8_t> mCells;
+            bool mEmpty;
+    };
+}
+
+#endif
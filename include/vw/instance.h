@@ -2,12 +2,16 @@
 #define VW_INSTANCE_H
 
 #include <vw/common.h>
+#include <vw/result.h>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace vw
 {
+    class CapabilityCache;
     struct DebugCallback;
+    class HostAllocator;
     class PhysicalDevice;
 
     /*! @brief A wrapper for a VkInstance object. */
@@ -17,6 +21,7 @@ namespace vw
 
             using PhysicalDeviceList = std::vector<PhysicalDevice>;
             using DebugCallbackPtr = std::shared_ptr<DebugCallback>;
+            using HostAllocatorPtr = std::shared_ptr<HostAllocator>;
 
             /*! @brief Constructs an invalid Instance.
              */
@@ -25,8 +30,14 @@ namespace vw
             /*! @brief Constructs an Instance.
              *  @param handle The Instance object created will assume ownership
              *      of the passed handle.
+             *  @param hostAllocator The allocator the handle was created with,
+             *      if any. It is kept alive until the handle is destroyed.
+             *  @param apiVersion The api version the handle was created for.
+             *  @param extensions The extensions the handle was created with.
              */
-            explicit Instance(VkInstance handle);
+            explicit Instance(VkInstance handle, HostAllocatorPtr hostAllocator = nullptr,
+                uint32_t apiVersion = VK_API_VERSION_1_0,
+                std::vector<std::string> extensions = std::vector<std::string>());
 
             /*! @brief Constructs an Instance using the looted VkInstance found
              *      in the passed parameter.
@@ -49,16 +60,46 @@ namespace vw
             operator bool() const;
 
             /*! @brief Returns a list of PhysicalDevices that can be examined.
+             *  @param cache Snapshots of devices seen on earlier runs. Devices
+             *      found in it are not queried beyond their core properties,
+             *      and devices missing from it are added to it.
              */
-            PhysicalDeviceList enumeratePhysicalDevices();
+            PhysicalDeviceList enumeratePhysicalDevices(CapabilityCache* cache = nullptr);
+
+            /*! @brief Returns a list of PhysicalDevices, or the error that
+             *      prevented enumerating them, without throwing.
+             */
+            Result<PhysicalDeviceList> tryEnumeratePhysicalDevices(
+                CapabilityCache* cache = nullptr) noexcept;
 
             /*! @brief Sets up the debug callback. Only a single callback is
              *      allowed.
              *  @note The validation layer and debug callback extension both
              *      need to have been specified when creating the instance.
+             *      Wrap the callback in an AsyncDebugCallback to keep message
+             *      handling off the threads making Vulkan calls.
              */
             void setDebugCallback(DebugCallbackPtr callback, bool verbose=false);
 
+            /*! @brief Returns the api version the instance was created for.
+             *      Devices only offer what both they and the instance support.
+             */
+            uint32_t getApiVersion() const;
+
+            /*! @brief Returns true if the instance was created with the
+             *      extension.
+             */
+            bool hasExtension(const std::string& name) const;
+
+            /*! @brief Returns the callbacks the instance was created with, or
+             *      null if the implementation allocates on its own.
+             */
+            const VkAllocationCallbacks* getAllocationCallbacks() const;
+
+            /*! @brief Returns the allocator the instance was created with.
+             */
+            const HostAllocatorPtr& getHostAllocator() const;
+
             /*! @brief Retrieves the handle to the underlying VkInstance.
              *      Ownership is still maintained. It is not transferred!
              */
@@ -70,6 +111,9 @@ namespace vw
             Instance& operator=(const Instance&) = delete;
 
             VkInstance mHandle;
+            HostAllocatorPtr mHostAllocator;
+            uint32_t mApiVersion;
+            std::vector<std::string> mExtensions;
 
             VkDebugReportCallbackEXT mDebugCallback;
             DebugCallbackPtr mDebugCallbackObj;
@@ -125,6 +169,12 @@ namespace vw
              */
             void addExtension(const std::string& name);
 
+            /*! @brief Sets the allocator the implementation allocates host
+             *      memory from for the instance and the objects created from
+             *      it. By default the implementation uses its own.
+             */
+            void setHostAllocator(Instance::HostAllocatorPtr allocator);
+
             /*! @brief Resets the creator to its default state.
              */
             void reset();
@@ -134,6 +184,12 @@ namespace vw
              */
             Instance create();
 
+            /*! @brief Attempts to create an Instance with the properties
+             *      specified, returning the error on failure instead of
+             *      throwing.
+             */
+            Result<Instance> tryCreate() noexcept;
+
         private:
 
             bool mUseAppInfo;
@@ -144,6 +200,7 @@ namespace vw
             uint32_t mApiVersion;
             std::vector<std::string> mLayers;
             std::vector<std::string> mExtensions;
+            Instance::HostAllocatorPtr mHostAllocator;
     };
 }
 
@@ -0,0 +1,213 @@
+#ifndef VW_MEMORYALLOCATOR_H
+#define VW_MEMORYALLOCATOR_H
+
+#include <vw/common.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace vw
+{
+    struct DeviceDispatch;
+    class PhysicalDevice;
+
+    /*! @brief A range of device memory handed out by a MemoryAllocator. It
+     *      must be returned with MemoryAllocator::free.
+     */
+    class Allocation
+    {
+        public:
+
+            /*! @brief Constructs an invalid Allocation.
+             */
+            Allocation();
+
+            /*! @brief Returns true if the allocation refers to memory.
+             */
+            operator bool() const;
+
+            /*! @brief Returns the VkDeviceMemory the range belongs to. Several
+             *      allocations may share the same memory object.
+             */
+            VkDeviceMemory getMemory() const;
+
+            /*! @brief Returns the offset of the range in the memory object.
+             *      This is the offset to pass to vkBind*Memory.
+             */
+            VkDeviceSize getOffset() const;
+
+            /*! @brief Returns the size of the range.
+             */
+            VkDeviceSize getSize() const;
+
+            /*! @brief Returns the index of the memory type of the range.
+             */
+            uint32_t getMemoryType() const;
+
+            /*! @brief Returns a pointer to the start of the range if the memory
+             *      is host visible. Host visible memory is kept persistently
+             *      mapped, so the pointer stays valid until the range is freed.
+             */
+            void* getMappedData() const;
+
+        private:
+
+            friend class MemoryAllocator;
+
+            VkDeviceMemory mMemory;
+            VkDeviceSize mOffset;
+            VkDeviceSize mSize;
+            uint32_t mMemoryType;
+            void* mMappedData;
+            void* mBlock;
+            uint32_t mPool;
+            uint32_t mNode;
+    };
+
+    /*! @brief Sub-allocates device memory from large VkDeviceMemory blocks,
+     *      keeping the number of driver allocations far below
+     *      maxMemoryAllocationCount.
+     *
+     *  Each memory type gets its own list of blocks which are managed with a
+     *  two level segregated fit (TLSF) scheme, so both allocating and freeing
+     *  take constant time. When bufferImageGranularity requires it, linear and
+     *  optimal resources are kept in separate blocks so they never share a
+     *  page. Requests larger than half a block get a dedicated VkDeviceMemory.
+     *  The allocator is thread safe, with one lock per memory type and
+     *  resource type.
+     */
+    class MemoryAllocator
+    {
+        public:
+
+            /*! @brief The kind of resource memory is being allocated for.
+             *      Buffers and linearly tiled images are linear resources while
+             *      optimally tiled images are not.
+             */
+            enum ResourceType
+            {
+                Resource_Linear,
+                Resource_Optimal
+            };
+
+            /*! @brief A summary of the memory owned by the allocator.
+             */
+            struct Statistics
+            {
+                size_t blockCount;
+                size_t allocationCount;
+                size_t dedicatedAllocationCount;
+                size_t freeRangeCount;
+                VkDeviceSize blockBytes;
+                VkDeviceSize usedBytes;
+                VkDeviceSize dedicatedBytes;
+                VkDeviceSize freeBytes;
+                VkDeviceSize largestFreeRange;
+
+                /*! @brief A value in [0, 1]. 0 means the free memory of each
+                 *      block is contiguous, values near 1 mean it is scattered
+                 *      in small ranges.
+                 */
+                float fragmentation;
+            };
+
+            static const VkDeviceSize DefaultBlockSize = 64 * 1024 * 1024;
+
+            /*! @brief Constructs an allocator for the given device.
+             *  @param blockSize The preferred size of each VkDeviceMemory
+             *      block. Heaps smaller than 8 blocks use an eighth of their
+             *      size instead.
+             *  @param callbacks The host allocation callbacks the device was
+             *      created with, if any.
+             */
+            MemoryAllocator(VkDevice device, const DeviceDispatch& dispatch,
+                const PhysicalDevice& physicalDevice,
+                VkDeviceSize blockSize = DefaultBlockSize,
+                const VkAllocationCallbacks* callbacks = nullptr);
+
+            /*! @brief Releases every block. All allocations must have been
+             *      freed by now.
+             */
+            ~MemoryAllocator();
+
+            /*! @brief Allocates memory satisfying the given requirements. On
+             *      failure, an exception is thrown.
+             *  @param required Property flags the memory type must have.
+             *  @param preferred Property flags the memory type should have if
+             *      a matching type exists.
+             *  @param type The kind of resource the memory will be bound to.
+             */
+            Allocation allocate(const VkMemoryRequirements& requirements,
+                VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred = 0,
+                ResourceType type = Resource_Linear);
+
+            /*! @brief Allocates memory for the buffer and binds it.
+             */
+            Allocation allocateForBuffer(VkBuffer buffer,
+                VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred = 0);
+
+            /*! @brief Allocates memory for the image and binds it.
+             */
+            Allocation allocateForImage(VkImage image,
+                VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred = 0,
+                ResourceType type = Resource_Optimal);
+
+            /*! @brief Returns the range to the allocator and resets the
+             *      Allocation to an invalid state.
+             */
+            void free(Allocation& allocation);
+
+            /*! @brief Makes host writes to the allocation visible to the
+             *      device. Only needed for memory that is not host coherent.
+             */
+            void flush(const Allocation& allocation);
+
+            /*! @brief Makes device writes to the allocation visible to the
+             *      host. Only needed for memory that is not host coherent.
+             */
+            void invalidate(const Allocation& allocation);
+
+            /*! @brief Returns statistics summed over all memory types.
+             */
+            Statistics getStatistics() const;
+
+            /*! @brief Returns statistics for a single memory type.
+             */
+            Statistics getStatistics(uint32_t memoryType) const;
+
+            /*! @brief Returns the memory properties of the physical device.
+             */
+            const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const;
+
+        private:
+
+            class Block;
+            struct Pool;
+
+            MemoryAllocator(const MemoryAllocator&) = delete;
+            MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+            uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags required,
+                VkMemoryPropertyFlags preferred) const;
+            bool allocateFromBlock(Pool& pool, Block& block, VkDeviceSize size,
+                VkDeviceSize alignment, Allocation& allocation);
+            bool isCoherent(uint32_t memoryType) const;
+            VkDeviceMemory allocateMemory(uint32_t memoryType, VkDeviceSize size,
+                void** mapped);
+            void freeMemory(VkDeviceMemory memory);
+            VkDeviceSize addStatistics(const Pool& pool, Statistics& stats) const;
+
+            VkDevice mDevice;
+            const DeviceDispatch& mDispatch;
+            const VkAllocationCallbacks* mCallbacks;
+            VkPhysicalDeviceMemoryProperties mMemoryProperties;
+            VkDeviceSize mBlockSize;
+            VkDeviceSize mBufferImageGranularity;
+            VkDeviceSize mNonCoherentAtomSize;
+            uint32_t mMaxAllocationCount;
+            std::atomic<uint32_t> mAllocationCount;
+            std::vector<std::unique_ptr<Pool>> mPools;
+    };
+}
+
+#endif
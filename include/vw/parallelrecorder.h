@@ -0,0 +1,169 @@
+#ifndef VW_PARALLELRECORDER_H
+#define VW_PARALLELRECORDER_H
+
+#include <vw/common.h>
+#include <vw/commandpoolset.h>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vw
+{
+    class Device;
+    class Queue;
+    class QueueFamily;
+
+    /*! @brief Records a large number of draws or dispatches on several
+     *      threads.
+     *
+     *  The items to record are split into chunks, and each chunk is recorded
+     *  into a command buffer of its own from the recording thread's pool in a
+     *  CommandPoolSet. Every thread starts with a contiguous run of chunks.
+     *  A thread that runs out steals the upper half of the largest run left,
+     *  so uneven chunks still keep every core busy. The calling thread
+     *  records too.
+     *
+     *  The command buffers are returned in chunk order whichever thread
+     *  recorded them, so the result is the same on every run. They are
+     *  secondary command buffers to execute in a primary, or primaries to
+     *  submit in one batch.
+     */
+    class ParallelRecorder
+    {
+        public:
+
+            /*! @brief Records the items [first, first + count) into the
+             *      command buffer, which has already been begun.
+             *  @param thread The index of the recording thread, in
+             *      [0, getThreadCount()), for per-thread resources.
+             */
+            using RecordFunction = std::function<void(VkCommandBuffer commandBuffer,
+                uint32_t first, uint32_t count, uint32_t thread)>;
+
+            struct Settings
+            {
+                Settings();
+
+                /*! @brief The number of worker threads besides the calling
+                 *      thread. By default, one less than the number of
+                 *      hardware threads.
+                 */
+                uint32_t workerCount;
+
+                /*! @brief The number of frames the device may be working on
+                 *      at once. See CommandPoolSet.
+                 */
+                uint32_t framesInFlight;
+
+                /*! @brief Chunks have at least this many items, so the cost
+                 *      of a command buffer stays small next to recording.
+                 */
+                uint32_t minChunkItems;
+
+                /*! @brief The largest number of chunks per thread. More chunks
+                 *      balance better and cost more command buffers.
+                 */
+                uint32_t chunksPerThread;
+
+                /*! @brief VK_COMMAND_BUFFER_LEVEL_SECONDARY or
+                 *      VK_COMMAND_BUFFER_LEVEL_PRIMARY.
+                 */
+                VkCommandBufferLevel level;
+            };
+
+            /*! @brief Creates the command pools for the family and starts the
+             *      workers.
+             */
+            ParallelRecorder(Device& device, const QueueFamily& family,
+                const Settings& settings = Settings());
+
+            /*! @brief Joins the workers and destroys the command pools.
+             */
+            ~ParallelRecorder();
+
+            /*! @brief Advances the command pools to the next frame. The device
+             *      must be done with the command buffers recorded
+             *      framesInFlight frames ago.
+             */
+            void beginFrame();
+
+            /*! @brief Records the items in parallel and returns the command
+             *      buffers in order. Calls must not overlap. If a record
+             *      function throws, the first exception is rethrown once
+             *      every chunk is done.
+             *  @param inheritance The state secondary command buffers inherit.
+             *      Required for secondaries. If it names a render pass, they
+             *      continue it.
+             */
+            std::vector<VkCommandBuffer> record(uint32_t itemCount,
+                const RecordFunction& function,
+                const VkCommandBufferInheritanceInfo* inheritance = nullptr);
+
+            /*! @brief Records the execution of secondary command buffers, in
+             *      order, into a primary.
+             */
+            void execute(VkCommandBuffer primary,
+                const std::vector<VkCommandBuffer>& commandBuffers);
+
+            /*! @brief Submits primary command buffers, in order, in a single
+             *      batch.
+             */
+            void submit(Queue& queue, const std::vector<VkCommandBuffer>& commandBuffers,
+                VkFence fence = VK_NULL_HANDLE);
+
+            /*! @brief Returns the number of recording threads, including the
+             *      calling thread.
+             */
+            uint32_t getThreadCount() const;
+
+        private:
+
+            // Each range is taken from by other threads, so it is padded to
+            // keep the ranges of different threads off the same cache line.
+            struct Range
+            {
+                std::mutex mutex;
+                uint32_t begin;
+                uint32_t end;
+                char padding[64];
+            };
+
+            ParallelRecorder(const ParallelRecorder&) = delete;
+            ParallelRecorder& operator=(const ParallelRecorder&) = delete;
+
+            void run(uint32_t thread);
+            void work(uint32_t thread);
+            bool take(uint32_t thread, uint32_t& chunk);
+            bool steal(uint32_t thread);
+            void recordChunk(uint32_t thread, uint32_t chunk);
+
+            Device& mDevice;
+            Settings mSettings;
+            CommandPoolSet mPools;
+            std::vector<Range> mRanges;
+
+            // The job being recorded
+            std::mutex mRecordMutex;
+            const RecordFunction* mFunction;
+            const VkCommandBufferInheritanceInfo* mInheritance;
+            uint32_t mItemCount;
+            uint32_t mChunkCount;
+            std::vector<VkCommandBuffer> mResults;
+            std::atomic<uint32_t> mRemaining;
+            std::exception_ptr mError;
+
+            std::mutex mMutex;
+            std::condition_variable mJobReady;
+            std::condition_variable mJobDone;
+            uint64_t mGeneration;
+            uint32_t mBusy;
+            bool mStopping;
+            std::vector<std::thread> mThreads;
+    };
+}
+
+#endif
@@ -3,13 +3,18 @@
 
 #include <vw/common.h>
 #include <array>
+#include <memory>
 #include <vector>
 
 namespace vw
 {
+    class DeviceCapabilities;
     class QueueFamily;
 
-    /*! @brief A wrapper for a VkPhysicalDevice object. */
+    /*! @brief A wrapper for a VkPhysicalDevice object. Copies share one
+     *      DeviceCapabilities snapshot, so the driver is queried once no
+     *      matter how often the device is copied or examined.
+     */
     class PhysicalDevice
     {
         public:
@@ -25,6 +30,7 @@ namespace vw
 
             using Uuid = std::array<uint8_t, VK_UUID_SIZE>;
             using QueueFamilyList = std::vector<QueueFamily>;
+            using CapabilitiesPtr = std::shared_ptr<const DeviceCapabilities>;
 
             /*! @brief Constructs a PhysicalDevice that is valid only during the
              *      lifetime of the Instance it was obtained from.
@@ -33,6 +39,11 @@ namespace vw
              */
             explicit PhysicalDevice(VkPhysicalDevice handle);
 
+            /*! @brief Constructs a PhysicalDevice described by an existing
+             *      snapshot, such as one from a CapabilityCache.
+             */
+            explicit PhysicalDevice(CapabilitiesPtr capabilities);
+
             /*! @brief Returns true if the data contained is valid.
              */
             operator bool() const;
@@ -80,6 +91,19 @@ namespace vw
              */
             const VkPhysicalDeviceSparseProperties& getDeviceSparseProperties() const;
 
+            /*! @brief Retrieves the memory heaps of the device and the memory
+             *      types that can be allocated from them.
+             */
+            const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const;
+
+            /*! @brief Retrieves the features the device supports.
+             */
+            const VkPhysicalDeviceFeatures& getFeatures() const;
+
+            /*! @brief Returns true if the device provides the extension.
+             */
+            bool hasExtension(const std::string& name) const;
+
             /*! @brief Returns a list of descriptions for each queue on the
              *      device.
              */
@@ -90,10 +114,14 @@ namespace vw
              */
             VkPhysicalDevice getHandle() const;
 
+            /*! @brief Returns the snapshot of the device's capabilities, which
+             *      also lists its extensions.
+             */
+            const CapabilitiesPtr& getCapabilities() const;
+
         private:
 
-            VkPhysicalDevice mHandle;
-            VkPhysicalDeviceProperties mProperties;
+            CapabilitiesPtr mCapabilities;
     };
 }
 
@@ -0,0 +1,94 @@
+#ifndef VW_PIPELINECACHE_H
+#define VW_PIPELINECACHE_H
+
+#include <vw/common.h>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace vw
+{
+    class Device;
+
+    /*! @brief A VkPipelineCache persisted to a file between runs.
+     *
+     *  The file starts with a header recording the vendor ID, device ID,
+     *  driver version and pipeline cache UUID of the device that wrote it, so
+     *  a cache from another device or driver is ignored instead of being
+     *  handed to the driver. Each thread compiles into its own cache, seeded
+     *  with the loaded data, so threads do not contend on one cache. Saving
+     *  merges the thread caches and replaces the file atomically, so a crash
+     *  mid-write never leaves a truncated cache behind.
+     */
+    class PipelineCache
+    {
+        public:
+
+            /*! @brief Loads the cache file, if there is a valid one, and
+             *      creates a cache for each thread.
+             *  @param path The file to load from and save to.
+             *  @param threadCount The number of threads that will create
+             *      pipelines.
+             *  @param saveInterval The minimum time between saves made by
+             *      saveIfDue(). 0 disables periodic saving.
+             */
+            PipelineCache(Device& device, const std::string& path,
+                uint32_t threadCount,
+                std::chrono::seconds saveInterval = std::chrono::seconds(0));
+
+            /*! @brief Saves the cache and destroys it. Errors while saving are
+             *      ignored.
+             */
+            ~PipelineCache();
+
+            /*! @brief Returns the cache the thread should pass when creating
+             *      pipelines.
+             *  @param thread The index of the calling thread.
+             */
+            VkPipelineCache getHandle(uint32_t thread);
+
+            /*! @brief Returns true if valid data was loaded from the file.
+             */
+            bool wasLoaded() const;
+
+            /*! @brief Merges the thread caches and writes them to the file.
+             *  @return False if the file could not be written.
+             */
+            bool save();
+
+            /*! @brief Saves if the save interval has elapsed since the last
+             *      save. Intended to be called regularly, such as once a
+             *      frame.
+             *  @return True if a save occurred and succeeded.
+             */
+            bool saveIfDue();
+
+            /*! @brief Returns the number of threads the cache was created for.
+             */
+            uint32_t getThreadCount() const;
+
+        private:
+
+            using Clock = std::chrono::steady_clock;
+
+            PipelineCache(const PipelineCache&) = delete;
+            PipelineCache& operator=(const PipelineCache&) = delete;
+
+            VkPipelineCache createCache(const void* data, size_t size);
+            bool isValid(const char* file, size_t size) const;
+            bool write(const std::vector<char>& data);
+            void destroy();
+
+            Device& mDevice;
+            std::string mPath;
+            std::chrono::seconds mSaveInterval;
+            bool mLoaded;
+
+            std::mutex mSaveMutex;
+            Clock::time_point mLastSave;
+            VkPipelineCache mMergedCache;
+            std::vector<VkPipelineCache> mThreadCaches;
+    };
+}
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef VW_PIPELINECOMPILER_H
+#define VW_PIPELINECOMPILER_H
+
+#include <vw/common.h>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace vw
+{
+    class Device;
+    class PipelineCache;
+    class ThreadPool;
+
+    /*! @brief Compiles named pipelines on a ThreadPool and records the order
+     *      in which a run first requested them.
+     *
+     *  Pipelines are registered by name along with a function that creates
+     *  them. Requesting a pipeline schedules its compilation, if it was not
+     *  already scheduled, and returns a future for it. The recorded trace can
+     *  be saved and passed to prewarm() on the next launch, so pipelines are
+     *  compiled in the order they will be needed before they are requested.
+     *  The compiler owns the pipelines it creates.
+     */
+    class PipelineCompiler
+    {
+        public:
+
+            /*! @brief Creates a pipeline with the given cache. Called on a
+             *      worker thread. Failures are reported by throwing.
+             */
+            using Builder = std::function<VkPipeline(Device& device, VkPipelineCache cache)>;
+
+            using Future = std::shared_future<VkPipeline>;
+            using NameList = std::vector<std::string>;
+
+            /*! @brief Constructs a compiler. The device, pool and cache must
+             *      outlive it.
+             *  @param cache An optional cache, with at least as many threads as
+             *      the pool.
+             */
+            PipelineCompiler(Device& device, ThreadPool& pool,
+                PipelineCache* cache = nullptr);
+
+            /*! @brief Waits for scheduled compilations and destroys the
+             *      pipelines.
+             */
+            ~PipelineCompiler();
+
+            /*! @brief Registers how to create a named pipeline. Registering an
+             *      existing name replaces its builder if it was not scheduled.
+             */
+            void add(const std::string& name, Builder builder);
+
+            /*! @brief Registers a compute pipeline. The create info is copied,
+             *      but the objects it refers to must stay alive until it is
+             *      compiled.
+             */
+            void addCompute(const std::string& name,
+                const VkComputePipelineCreateInfo& info);
+
+            /*! @brief Returns the pipeline, scheduling it if needed, and
+             *      records the request in the trace.
+             */
+            Future request(const std::string& name);
+
+            /*! @brief Schedules the registered pipelines among the names, in
+             *      order, without recording them in the trace. Unknown names
+             *      are skipped.
+             */
+            void prewarm(const NameList& names);
+
+            /*! @brief Returns the names requested so far in the order of their
+             *      first request.
+             */
+            NameList getTrace() const;
+
+            /*! @brief Writes the trace to a file, one name per line.
+             *  @return False if the file could not be written.
+             */
+            bool saveTrace(const std::string& path) const;
+
+            /*! @brief Reads a trace written by saveTrace(). A missing file
+             *      gives an empty list.
+             */
+            static NameList loadTrace(const std::string& path);
+
+        private:
+
+            struct Entry
+            {
+                Builder builder;
+                Future future;
+                bool scheduled;
+                bool requested;
+            };
+
+            PipelineCompiler(const PipelineCompiler&) = delete;
+            PipelineCompiler& operator=(const PipelineCompiler&) = delete;
+
+            Future schedule(Entry& entry);
+
+            Device& mDevice;
+            ThreadPool& mPool;
+            PipelineCache* mCache;
+
+            mutable std::mutex mMutex;
+            std::map<std::string, Entry> mEntries;
+            NameList mTrace;
+    };
+}
+
+#endif
@@ -2,18 +2,28 @@
 #define VW_QUEUE_H
 
 #include <vw/common.h>
+#include <memory>
+#include <mutex>
 
 namespace vw
 {
+    struct DeviceDispatch;
+
     /*! @brief A wrapper for a VkQueue.
+     *
+     *  Copies of a queue share a lock, which submit() and waitIdle() take
+     *  since Vulkan requires calls on a queue to be externally synchronized.
      */
     class Queue
     {
         public:
 
             /*! @brief Constructs a queue with the given details.
+             *  @param dispatch The function table of the owning Device. It
+             *      must outlive the queue.
              */
-            Queue(uint32_t family, uint32_t index, VkQueue handle);
+            Queue(uint32_t family, uint32_t index, VkQueue handle,
+                const DeviceDispatch* dispatch);
 
             /*! @brief Returns true if the queue is valid.
              */
@@ -27,6 +37,32 @@ namespace vw
              */
             uint32_t getQueueIndex() const;
 
+            /*! @brief Submits work to the queue. On failure, an exception is
+             *      thrown.
+             *  @param fence An optional fence signaled once all of the
+             *      submitted work completes.
+             */
+            void submit(uint32_t count, const VkSubmitInfo* infos,
+                VkFence fence = VK_NULL_HANDLE);
+
+            /*! @brief Submits a single batch of work to the queue.
+             */
+            void submit(const VkSubmitInfo& info, VkFence fence = VK_NULL_HANDLE);
+
+            /*! @brief Blocks until all work submitted to the queue completes.
+             */
+            void waitIdle();
+
+            /*! @brief Returns the lock shared by copies of the queue. It must
+             *      be held when calling functions that need the queue
+             *      externally synchronized directly on the handle.
+             */
+            std::mutex& getMutex() const;
+
+            /*! @brief Returns the function table of the owning Device.
+             */
+            const DeviceDispatch& getDispatch() const;
+
             /*! @brief Returns the VkQueue handle for the underlying object.
              */
             VkQueue getHandle();
@@ -36,6 +72,8 @@ namespace vw
             uint32_t mFamily;
             uint32_t mIndex;
             VkQueue mHandle;
+            const DeviceDispatch* mDispatch;
+            std::shared_ptr<std::mutex> mMutex;
     };
 }
 
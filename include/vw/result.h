@@ -0,0 +1,155 @@
+#ifndef VW_RESULT_H
+#define VW_RESULT_H
+
+#include <vw/common.h>
+#include <cassert>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace vw
+{
+    /*! @brief Returns a description of a VkResult. The string is static, so
+     *      nothing is allocated.
+     */
+    const char* getResultString(VkResult result) noexcept;
+
+    /*! @brief The outcome of a call that reports failure instead of throwing.
+     *
+     *  Holds the VkResult of the call and, if it produced one, its value. A
+     *  call may produce a value along with a success code other than
+     *  VK_SUCCESS, such as a partial list with VK_INCOMPLETE.
+     */
+    template <typename T>
+    class Result
+    {
+        public:
+
+            /*! @brief Constructs a result without a value.
+             */
+            Result(VkResult code) noexcept
+                : mCode(code)
+                , mHasValue(false)
+            {
+            }
+
+            /*! @brief Constructs a result holding a value.
+             */
+            Result(T value, VkResult code = VK_SUCCESS)
+                noexcept(std::is_nothrow_move_constructible<T>::value)
+                : mCode(code)
+                , mHasValue(true)
+            {
+                new (&mStorage) T(std::move(value));
+            }
+
+            Result(Result&& other)
+                noexcept(std::is_nothrow_move_constructible<T>::value)
+                : mCode(other.mCode)
+                , mHasValue(other.mHasValue)
+            {
+                if (mHasValue)
+                    new (&mStorage) T(std::move(other.getValue()));
+            }
+
+            ~Result()
+            {
+                if (mHasValue)
+                    getValue().~T();
+            }
+
+            /*! @brief Returns true unless the code is an error. Success codes
+             *      such as VK_TIMEOUT or VK_INCOMPLETE count as success.
+             */
+            explicit operator bool() const noexcept
+            {
+                return mCode >= 0;
+            }
+
+            /*! @brief Returns the code returned by Vulkan.
+             */
+            VkResult getCode() const noexcept
+            {
+                return mCode;
+            }
+
+            /*! @brief Returns true if the call produced a value.
+             */
+            bool hasValue() const noexcept
+            {
+                return mHasValue;
+            }
+
+            /*! @brief Returns the value. There must be one.
+             */
+            T& getValue() noexcept
+            {
+                assert(mHasValue);
+                return *reinterpret_cast<T*>(&mStorage);
+            }
+
+            const T& getValue() const noexcept
+            {
+                assert(mHasValue);
+                return *reinterpret_cast<const T*>(&mStorage);
+            }
+
+            /*! @brief Moves the value out of the result. There must be one.
+             */
+            T takeValue()
+            {
+                return std::move(getValue());
+            }
+
+            /*! @brief Returns a description of the code.
+             */
+            const char* getMessage() const noexcept
+            {
+                return getResultString(mCode);
+            }
+
+        private:
+
+            Result(const Result&) = delete;
+            Result& operator=(const Result&) = delete;
+            Result& operator=(Result&&) = delete;
+
+            VkResult mCode;
+            bool mHasValue;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type mStorage;
+    };
+
+    /*! @brief The outcome of a call that produces nothing but its code.
+     */
+    template <>
+    class Result<void>
+    {
+        public:
+
+            Result(VkResult code) noexcept
+                : mCode(code)
+            {
+            }
+
+            explicit operator bool() const noexcept
+            {
+                return mCode >= 0;
+            }
+
+            VkResult getCode() const noexcept
+            {
+                return mCode;
+            }
+
+            const char* getMessage() const noexcept
+            {
+                return getResultString(mCode);
+            }
+
+        private:
+
+            VkResult mCode;
+    };
+}
+
+#endif
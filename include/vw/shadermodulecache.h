@@ -0,0 +1,171 @@
+#ifndef VW_SHADERMODULECACHE_H
+#define VW_SHADERMODULECACHE_H
+
+#include <vw/common.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace vw
+{
+    struct DeviceDispatch;
+
+    /*! @brief Shares one VkShaderModule between every user of the same SPIR-V.
+     *
+     *  Modules are keyed by a 128-bit hash of the code and created the first
+     *  time the code is acquired. Handles are reference counted, and a
+     *  module is destroyed when its last handle is released, so the cache
+     *  never holds on to code nobody uses. The map is split into shards with
+     *  a lock each, so concurrent lookups rarely contend, and a module is
+     *  created outside of the lock.
+     *
+     *  Debug and non-semantic instructions may optionally be stripped before
+     *  creating a module. They do not change what the shader computes but
+     *  the driver still has to parse and keep them.
+     */
+    class ShaderModuleCache
+    {
+        public:
+
+            struct Hash
+            {
+                uint64_t low;
+                uint64_t high;
+
+                bool operator==(const Hash& other) const;
+            };
+
+            /*! @brief A module shared by every handle to it.
+             */
+            class Module
+            {
+                public:
+
+                    /*! @brief Returns the VkShaderModule handle.
+                     */
+                    VkShaderModule getHandle() const;
+
+                    /*! @brief Returns the hash of the code it was acquired
+                     *      with.
+                     */
+                    const Hash& getHash() const;
+
+                    /*! @brief Returns true if debug and non-semantic
+                     *      instructions were stripped.
+                     */
+                    bool isStripped() const;
+
+                    /*! @brief Returns the size in bytes of the code the module
+                     *      was created from.
+                     */
+                    size_t getCodeSize() const;
+
+                private:
+
+                    friend class ShaderModuleCache;
+
+                    VkShaderModule mHandle;
+                    Hash mHash;
+                    bool mStripped;
+                    size_t mCodeSize;
+            };
+
+            using ModulePtr = std::shared_ptr<const Module>;
+
+            struct Statistics
+            {
+                uint64_t hits;
+                uint64_t misses;
+
+                /*! @brief The bytes of code removed by stripping.
+                 */
+                uint64_t strippedBytes;
+            };
+
+            /*! @brief Constructs an empty cache for the device.
+             *  @param callbacks The host allocation callbacks the device was
+             *      created with, if any.
+             */
+            ShaderModuleCache(VkDevice device, const DeviceDispatch& dispatch,
+                const VkAllocationCallbacks* callbacks = nullptr);
+
+            /*! @brief Every handle must have been released by now.
+             */
+            ~ShaderModuleCache();
+
+            /*! @brief Returns the module for the code, creating it if no
+             *      handle to it is alive. On failure, an exception is thrown.
+             *  @param codeSize The size of the code in bytes.
+             *  @param strip True to strip debug and non-semantic instructions
+             *      before creating the module. Stripped and unstripped modules
+             *      of the same code are kept apart.
+             */
+            ModulePtr acquire(const uint32_t* code, size_t codeSize, bool strip = false);
+
+            /*! @brief Returns the number of modules alive.
+             */
+            size_t getModuleCount() const;
+
+            /*! @brief Returns how many acquisitions found a module, created
+             *      one, and how much code was stripped.
+             */
+            Statistics getStatistics() const;
+
+            /*! @brief Returns the hash the cache keys the code by.
+             */
+            static Hash hash(const uint32_t* code, size_t codeSize);
+
+            /*! @brief Returns the code without OpSource, OpName, OpLine and
+             *      the other debug instructions, and without non-semantic
+             *      extended instruction sets. Code that can't be parsed or
+             *      that imports a semantic debug set such as
+             *      OpenCL.DebugInfo.100 is returned unchanged.
+             */
+            static std::vector<uint32_t> strip(const uint32_t* code, size_t codeSize);
+
+        private:
+
+            static const size_t ShardCount = 16;
+
+            struct Key
+            {
+                Hash hash;
+                bool stripped;
+
+                bool operator==(const Key& other) const;
+            };
+
+            struct KeyHasher
+            {
+                size_t operator()(const Key& key) const;
+            };
+
+            struct Shard
+            {
+                std::mutex mutex;
+                std::unordered_map<Key, std::weak_ptr<const Module>, KeyHasher> modules;
+            };
+
+            ShaderModuleCache(const ShaderModuleCache&) = delete;
+            ShaderModuleCache& operator=(const ShaderModuleCache&) = delete;
+
+            Shard& getShard(const Key& key);
+            ModulePtr create(const Key& key, const uint32_t* code, size_t codeSize);
+            void release(Module* module);
+
+            VkDevice mDevice;
+            const DeviceDispatch& mDispatch;
+            const VkAllocationCallbacks* mCallbacks;
+
+            std::array<Shard, ShardCount> mShards;
+            std::atomic<size_t> mModuleCount;
+            std::atomic<uint64_t> mHits;
+            std::atomic<uint64_t> mMisses;
+            std::atomic<uint64_t> mStrippedBytes;
+    };
+}
+
+#endif
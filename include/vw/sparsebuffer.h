@@ -0,0 +1,126 @@
+#ifndef VW_SPARSEBUFFER_H
+#define VW_SPARSEBUFFER_H
+
+#include <vw/common.h>
+#include <vw/memoryallocator.h>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace vw
+{
+    class Device;
+    class Queue;
+
+    /*! @brief A buffer reserving a large virtual range whose memory is
+     *      committed and decommitted page by page.
+     *
+     *  The buffer is created with sparse binding and residency, so only the
+     *  pages in use need memory. Growing it binds memory to the pages added
+     *  and leaves the existing contents where they are, and shrinking it
+     *  returns the memory of the pages dropped to the MemoryAllocator. Binds
+     *  are submitted to the first queue of the device whose family supports
+     *  sparse binding, and each call waits for its binds to complete.
+     *
+     *  The device must have the sparseBinding and sparseResidencyBuffer
+     *  features enabled. Reading a page with no memory bound returns
+     *  undefined values unless the device reports residencyNonResidentStrict.
+     *  All functions may be called from any thread.
+     */
+    class SparseBuffer
+    {
+        public:
+
+            struct Settings
+            {
+                Settings();
+
+                /*! @brief The granularity memory is committed in. It is
+                 *      rounded up to a multiple of the buffer's sparse
+                 *      alignment. 0 uses the alignment itself.
+                 */
+                VkDeviceSize pageSize;
+
+                /*! @brief Property flags the memory of each page must have.
+                 */
+                VkMemoryPropertyFlags memoryFlags;
+            };
+
+            /*! @brief Creates a buffer of the reserved size with no memory
+             *      committed. On failure, an exception is thrown.
+             */
+            SparseBuffer(Device& device, VkDeviceSize reservedSize,
+                VkBufferUsageFlags usage, const Settings& settings = Settings());
+
+            /*! @brief Destroys the buffer and frees the memory of its pages.
+             *      The device must be done with the buffer.
+             */
+            ~SparseBuffer();
+
+            /*! @brief Binds memory to every page overlapping the range. Pages
+             *      already committed keep their memory and contents.
+             */
+            void commit(VkDeviceSize offset, VkDeviceSize size);
+
+            /*! @brief Unbinds and frees the memory of the pages lying entirely
+             *      within the range. The device must be done with them.
+             */
+            void decommit(VkDeviceSize offset, VkDeviceSize size);
+
+            /*! @brief Commits the pages covering [0, size) and decommits every
+             *      page after them, with a single bind.
+             */
+            void resize(VkDeviceSize size);
+
+            /*! @brief Returns true if every page overlapping the range is
+             *      committed.
+             */
+            bool isCommitted(VkDeviceSize offset, VkDeviceSize size) const;
+
+            /*! @brief Returns the size of the virtual range.
+             */
+            VkDeviceSize getReservedSize() const;
+
+            /*! @brief Returns the bytes of memory bound to the buffer.
+             */
+            VkDeviceSize getCommittedSize() const;
+
+            /*! @brief Returns the granularity memory is committed in.
+             */
+            VkDeviceSize getPageSize() const;
+
+            /*! @brief Returns the queue binds are submitted to.
+             */
+            Queue& getQueue();
+
+            /*! @brief Returns the VkBuffer handle.
+             */
+            VkBuffer getBuffer();
+
+        private:
+
+            using Bind = std::pair<size_t, Allocation>;
+
+            SparseBuffer(const SparseBuffer&) = delete;
+            SparseBuffer& operator=(const SparseBuffer&) = delete;
+
+            VkDeviceSize getPageBytes(size_t page) const;
+            void addCommits(size_t firstPage, size_t endPage, std::vector<Bind>& binds);
+            void addDecommits(size_t firstPage, size_t endPage, std::vector<Bind>& binds);
+            void bind(std::vector<Bind>& binds);
+
+            Device& mDevice;
+            Queue* mQueue;
+            VkBuffer mBuffer;
+            VkDeviceSize mReservedSize;
+            VkDeviceSize mPageSize;
+            VkMemoryRequirements mRequirements;
+            VkMemoryPropertyFlags mMemoryFlags;
+
+            mutable std::mutex mMutex;
+            std::vector<Allocation> mPages;
+            VkDeviceSize mCommittedSize;
+    };
+}
+
+#endif
@@ -0,0 +1,183 @@
+#ifndef VW_STAGINGRING_H
+#define VW_STAGINGRING_H
+
+#include <vw/common.h>
+#include <vw/memoryallocator.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace vw
+{
+    class Device;
+
+    /*! @brief A persistently mapped, host visible ring buffer used to stream
+     *      data to the device.
+     *
+     *  Producers on any thread reserve space without locking, write into the
+     *  mapped pointer and record copies out of the ring. Once the submission
+     *  consuming the copies has been made, the submitter retires the
+     *  reservations it consumed. Their space is reclaimed when the returned
+     *  fence or the given timeline value signals and every reservation before
+     *  them has been reclaimed too, so a producer that is slow to submit never
+     *  has its data overwritten. Reserving only blocks when the ring is
+     *  genuinely full.
+     */
+    class StagingRing
+    {
+        public:
+
+            /*! @brief A range of the ring that can be written to.
+             */
+            struct Reservation
+            {
+                /*! @brief The mapped pointer to write the data to.
+                 */
+                void* data;
+
+                /*! @brief The buffer backing the ring.
+                 */
+                VkBuffer buffer;
+
+                /*! @brief The offset of the range in the buffer.
+                 */
+                VkDeviceSize offset;
+
+                /*! @brief The size that was requested.
+                 */
+                VkDeviceSize size;
+
+                /*! @brief The positions the range spans in the stream of
+                 *      reservations, including the padding before it.
+                 */
+                uint64_t begin;
+                uint64_t end;
+            };
+
+            /*! @brief Creates a ring of the given capacity on the device.
+             */
+            StagingRing(Device& device, VkDeviceSize capacity);
+
+            /*! @brief Waits for every retired submission and releases the
+             *      buffer.
+             */
+            ~StagingRing();
+
+            /*! @brief Reserves space in the ring, waiting for earlier
+             *      submissions to complete when it is full. When the space is
+             *      held by reservations no one has retired yet, waits for
+             *      another producer to retire them, so the calling thread must
+             *      not hold unretired reservations itself. An exception is
+             *      only thrown when the size can never fit in the ring.
+             *  @param alignment The alignment of the offset in the buffer.
+             *      Copies to images need a multiple of the texel size.
+             */
+            Reservation reserve(VkDeviceSize size, VkDeviceSize alignment = 16);
+
+            /*! @brief Attempts to reserve space without waiting. Returns false
+             *      when the ring is full.
+             */
+            bool tryReserve(VkDeviceSize size, VkDeviceSize alignment,
+                Reservation& reservation);
+
+            /*! @brief Makes the host writes to the reservation visible to the
+             *      device. Only does work for non-coherent memory.
+             */
+            void flush(const Reservation& reservation);
+
+            /*! @brief Records a copy from the reservation to a buffer.
+             */
+            void copyToBuffer(VkCommandBuffer commandBuffer,
+                const Reservation& reservation, VkBuffer dst,
+                VkDeviceSize dstOffset);
+
+            /*! @brief Records a copy from the reservation to an image.
+             *  @param region The bufferOffset is relative to the reservation.
+             */
+            void copyToImage(VkCommandBuffer commandBuffer,
+                const Reservation& reservation, VkImage dst, VkImageLayout layout,
+                const VkBufferImageCopy& region);
+
+            /*! @brief Marks the reservations as consumed by the next
+             *      submission. The returned fence is owned by the ring and
+             *      must be passed to that submission. Each reservation is
+             *      retired exactly once.
+             */
+            VkFence retire(uint32_t count, const Reservation* reservations);
+
+            /*! @brief Marks the reservations as consumed by a submission that
+             *      signals the timeline semaphore with the given value. The
+             *      semaphore must outlive the ring.
+             */
+            void retire(uint32_t count, const Reservation* reservations,
+                VkSemaphore timeline, uint64_t value);
+
+            /*! @brief Reclaims the space of every retired submission that has
+             *      completed, up to the first reservation still in use. Never
+             *      blocks.
+             */
+            void reclaim();
+
+            /*! @brief Returns the number of bytes currently reserved and not
+             *      yet reclaimed.
+             */
+            VkDeviceSize getUsedBytes() const;
+
+            /*! @brief Returns the size of the ring.
+             */
+            VkDeviceSize getCapacity() const;
+
+            /*! @brief Returns the buffer backing the ring.
+             */
+            VkBuffer getBuffer();
+
+        private:
+
+            // A range of positions, from begin to end
+            using Range = std::pair<uint64_t, uint64_t>;
+
+            struct Mark
+            {
+                std::vector<Range> ranges;
+                VkFence fence;
+                VkSemaphore timeline;
+                uint64_t value;
+            };
+
+            StagingRing(const StagingRing&) = delete;
+            StagingRing& operator=(const StagingRing&) = delete;
+
+            void addRanges(Mark& mark, uint32_t count, const Reservation* reservations);
+            bool isRetired(const Mark& mark) const;
+            void waitOldest(uint64_t tail);
+            void release(Mark& mark);
+            void recycleFences();
+
+            Device& mDevice;
+            VkDeviceSize mCapacity;
+            VkDeviceSize mAtomSize;
+            VkBuffer mBuffer;
+            Allocation mAllocation;
+            char* mData;
+
+            std::atomic<uint64_t> mHead;
+            std::atomic<uint64_t> mTail;
+
+            std::mutex mMarkMutex;
+            std::condition_variable mRetired;
+            std::deque<Mark> mMarks;
+            std::map<uint64_t, uint64_t> mCompleted;
+            std::vector<VkFence> mFreeFences;
+
+            // Signaled fences are only reset once no thread is waiting, since
+            // a waiter may still be about to wait on one
+            uint32_t mWaiters;
+            std::vector<VkFence> mSignaledFences;
+    };
+}
+
+#endif
@@ -0,0 +1,195 @@
+#ifndef VW_STREAMLOADER_H
+#define VW_STREAMLOADER_H
+
+#include <vw/common.h>
+#include <vw/threadpool.h>
+#include <vw/transferengine.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace vw
+{
+    class Device;
+
+    /*! @brief Loads files into device buffers, overlapping disk reads with
+     *      uploads.
+     *
+     *  A file is split into chunks which move through four stages: a read
+     *  into a host buffer on one of the reader threads, a write into the
+     *  staging ring of a TransferEngine, the copy on the transfer queue, and
+     *  a notification of the consumer once the copy completes. At most depth
+     *  chunks are read ahead and at most depth copies are in flight, so the
+     *  memory used is bounded however large the file is. With enough depth
+     *  loading runs at the speed of the slowest stage, usually the disk.
+     *
+     *  Statistics report how long each stage was busy, so the bottleneck can
+     *  be found. A stage is busy while at least one chunk is in it.
+     */
+    class StreamLoader
+    {
+        public:
+
+            struct Settings
+            {
+                Settings();
+
+                /*! @brief The size of each chunk in bytes.
+                 */
+                VkDeviceSize chunkSize;
+
+                /*! @brief The number of chunks that may be in each stage at
+                 *      once. The staging ring holds one more, so the next
+                 *      chunk is staged without waiting for a copy.
+                 */
+                uint32_t depth;
+
+                /*! @brief The number of threads reading chunks concurrently.
+                 */
+                uint32_t readThreads;
+            };
+
+            /*! @brief The activity of one stage.
+             */
+            struct Stage
+            {
+                VkDeviceSize bytes;
+                uint64_t nanoseconds;
+
+                /*! @brief The bytes divided by the time the stage was busy.
+                 */
+                double bytesPerSecond;
+            };
+
+            /*! @brief Totals over every load so far.
+             */
+            struct Statistics
+            {
+                uint64_t chunkCount;
+                Stage read;
+                Stage staging;
+                Stage copy;
+                Stage notify;
+
+                /*! @brief The bytes loaded divided by the time spent in
+                 *      load().
+                 */
+                Stage total;
+            };
+
+            /*! @brief Called on the loading thread once a chunk is in the
+             *      buffer. Chunks are reported in order.
+             *  @param offset The offset of the chunk from the start of the
+             *      data loaded.
+             */
+            using ChunkCallback = std::function<void(VkDeviceSize offset, VkDeviceSize size)>;
+
+            /*! @brief Creates the transfer engine and starts the reader
+             *      threads. The device must have timeline semaphores enabled.
+             */
+            explicit StreamLoader(Device& device, const Settings& settings = Settings());
+
+            /*! @brief Joins the reader threads and waits for the transfer
+             *      engine.
+             */
+            ~StreamLoader();
+
+            /*! @brief Loads the whole file into the buffer, blocking until
+             *      every chunk has been copied. Returns false if the file
+             *      could not be opened or read. Vulkan errors throw an
+             *      exception.
+             *  @param dstFamily The family that will use the buffer, or
+             *      VK_QUEUE_FAMILY_IGNORED. See TransferEngine.
+             */
+            bool load(const std::string& path, VkBuffer dst, VkDeviceSize dstOffset = 0,
+                const ChunkCallback& callback = ChunkCallback(),
+                uint32_t dstFamily = VK_QUEUE_FAMILY_IGNORED);
+
+            /*! @brief Loads a range of an open file into the buffer. The
+             *      descriptor is only read with pread, so its file offset is
+             *      left alone.
+             */
+            bool load(int fd, VkDeviceSize fileOffset, VkDeviceSize size, VkBuffer dst,
+                VkDeviceSize dstOffset = 0, const ChunkCallback& callback = ChunkCallback(),
+                uint32_t dstFamily = VK_QUEUE_FAMILY_IGNORED);
+
+            /*! @brief Returns the activity of each stage summed over every
+             *      load.
+             */
+            Statistics getStatistics() const;
+
+            /*! @brief Returns the engine uploads go through. Consumers on
+             *      other families record their acquires with it.
+             */
+            TransferEngine& getTransferEngine();
+
+        private:
+
+            using Clock = std::chrono::steady_clock;
+
+            /*! @brief Accumulates the time any chunk is in a stage.
+             */
+            class StageClock
+            {
+                public:
+
+                    StageClock();
+
+                    void begin();
+                    void end(VkDeviceSize bytes);
+                    Stage get() const;
+
+                private:
+
+                    mutable std::mutex mMutex;
+                    uint32_t mActive;
+                    Clock::time_point mStart;
+                    VkDeviceSize mBytes;
+                    uint64_t mNanoseconds;
+            };
+
+            struct Slot
+            {
+                std::vector<char> data;
+                VkDeviceSize offset;
+                VkDeviceSize size;
+                bool ready;
+                bool failed;
+            };
+
+            struct Copy
+            {
+                uint64_t value;
+                VkDeviceSize offset;
+                VkDeviceSize size;
+            };
+
+            StreamLoader(const StreamLoader&) = delete;
+            StreamLoader& operator=(const StreamLoader&) = delete;
+
+            void read(int fd, VkDeviceSize fileOffset, Slot& slot);
+            void notify(const Copy& copy, const ChunkCallback& callback);
+
+            Settings mSettings;
+            TransferEngine mEngine;
+            ThreadPool mReaders;
+
+            std::mutex mLoadMutex;
+            std::mutex mSlotMutex;
+            std::condition_variable mSlotReady;
+            std::vector<Slot> mSlots;
+
+            StageClock mRead;
+            StageClock mStaging;
+            StageClock mCopy;
+            StageClock mNotify;
+            StageClock mTotal;
+            std::atomic<uint64_t> mChunkCount;
+    };
+}
+
+#endif
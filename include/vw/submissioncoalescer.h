@@ -0,0 +1,125 @@
+#ifndef VW_SUBMISSIONCOALESCER_H
+#define VW_SUBMISSIONCOALESCER_H
+
+#include <vw/common.h>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace vw
+{
+    class Queue;
+
+    /*! @brief Collects submissions from any number of threads and hands them
+     *      to a Queue as a single vkQueueSubmit call.
+     *
+     *  Submissions are kept in the order they were enqueued, so a submission
+     *  may wait on a semaphore signaled by an earlier one in the same batch.
+     *  Timeline semaphore values chained with VkTimelineSemaphoreSubmitInfo
+     *  are preserved. Work is flushed explicitly, once a number of submissions
+     *  are pending, or once the oldest pending submission is older than a
+     *  delay. The delay is only checked when enqueuing or polling.
+     *
+     *  Batches go through vkQueueSubmit rather than vkQueueSubmit2, which
+     *  needs Vulkan 1.3 or VK_KHR_synchronization2, so that timeline values
+     *  only need Vulkan 1.2 or VK_KHR_timeline_semaphore.
+     */
+    class SubmissionCoalescer
+    {
+        public:
+
+            /*! @brief Constructs a coalescer for the queue. The queue must
+             *      outlive the coalescer, and work should only be submitted to
+             *      it through the coalescer.
+             *  @param maxPending Pending submissions that trigger a flush. 0
+             *      disables the threshold.
+             *  @param maxDelay Age of the oldest pending submission that
+             *      triggers a flush. 0 disables the threshold.
+             */
+            explicit SubmissionCoalescer(Queue& queue, size_t maxPending = 0,
+                std::chrono::microseconds maxDelay = std::chrono::microseconds(0));
+
+            /*! @brief Flushes any pending submissions. If the submission
+             *      fails, the error is ignored and the submissions dropped.
+             */
+            ~SubmissionCoalescer();
+
+            /*! @brief Copies a submission into the pending batch. The arrays
+             *      the info points to may be reused once this returns.
+             *  @note The only structure allowed in the pNext chain is a
+             *      VkTimelineSemaphoreSubmitInfo. Any other throws an
+             *      exception with VK_ERROR_FEATURE_NOT_PRESENT.
+             */
+            void enqueue(const VkSubmitInfo& info);
+
+            /*! @brief Enqueues a command buffer with no semaphores.
+             */
+            void enqueue(VkCommandBuffer commandBuffer);
+
+            /*! @brief Submits every pending submission in one call.
+             *  @param fence An optional fence signaled once the batch
+             *      completes. It is submitted even if the batch is empty.
+             *  @return The number of submissions flushed.
+             */
+            size_t flush(VkFence fence = VK_NULL_HANDLE);
+
+            /*! @brief Flushes if the delay threshold has been reached.
+             *  @return True if a flush occurred.
+             */
+            bool poll();
+
+            /*! @brief Returns the number of submissions waiting for a flush.
+             */
+            size_t getPendingCount() const;
+
+        private:
+
+            using Clock = std::chrono::steady_clock;
+
+            struct Range
+            {
+                uint32_t waitOffset;
+                uint32_t waitCount;
+                uint32_t commandBufferOffset;
+                uint32_t commandBufferCount;
+                uint32_t signalOffset;
+                uint32_t signalCount;
+                bool timeline;
+            };
+
+            // The submissions of a batch are stored in flat arrays which keep
+            // their capacity between flushes.
+            struct Batch
+            {
+                void clear();
+
+                std::vector<Range> ranges;
+                std::vector<VkSemaphore> waitSemaphores;
+                std::vector<VkPipelineStageFlags> waitStages;
+                std::vector<uint64_t> waitValues;
+                std::vector<VkCommandBuffer> commandBuffers;
+                std::vector<VkSemaphore> signalSemaphores;
+                std::vector<uint64_t> signalValues;
+                std::vector<VkSubmitInfo> infos;
+                std::vector<VkTimelineSemaphoreSubmitInfo> timelineInfos;
+                Clock::time_point oldest;
+            };
+
+            SubmissionCoalescer(const SubmissionCoalescer&) = delete;
+            SubmissionCoalescer& operator=(const SubmissionCoalescer&) = delete;
+
+            bool isDue(const Batch& batch) const;
+
+            Queue& mQueue;
+            size_t mMaxPending;
+            std::chrono::microseconds mMaxDelay;
+
+            mutable std::mutex mPendingMutex;
+            Batch mPending;
+
+            std::mutex mSubmitMutex;
+            Batch mSubmitting;
+    };
+}
+
+#endif
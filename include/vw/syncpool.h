@@ -0,0 +1,112 @@
+#ifndef VW_SYNCPOOL_H
+#define VW_SYNCPOOL_H
+
+#include <vw/common.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace vw
+{
+    struct DeviceDispatch;
+    class Queue;
+    class TimelineSemaphore;
+
+    /*! @brief Recycles the synchronization objects of a Device, so
+     *      submissions do not create and destroy them every frame.
+     *
+     *  Fences and events are reset when they are released and handed out
+     *  unsignaled. Binary semaphores must be released only once no pending
+     *  operation waits on or signals them. When timeline semaphores are
+     *  enabled, each queue of the device also has its own TimelineSemaphore.
+     *  All functions may be called from any thread.
+     */
+    class SyncPool
+    {
+        public:
+
+            /*! @brief Constructs a pool for the device. A timeline is created
+             *      for each queue if timelineSemaphores is true.
+             *  @param callbacks The host allocation callbacks the device was
+             *      created with, if any.
+             */
+            SyncPool(VkDevice device, const DeviceDispatch& dispatch,
+                const std::vector<Queue>& queues, bool timelineSemaphores,
+                const VkAllocationCallbacks* callbacks = nullptr);
+
+            /*! @brief Destroys every pooled object. Objects still acquired are
+             *      not tracked and must be released first.
+             */
+            ~SyncPool();
+
+            /*! @brief Returns an unsignaled fence.
+             */
+            VkFence acquireFence();
+
+            /*! @brief Resets the fence and returns it to the pool. The fence
+             *      must not be in use by a pending submission.
+             */
+            void releaseFence(VkFence fence);
+
+            /*! @brief Resets the fences with a single call and returns them to
+             *      the pool.
+             */
+            void releaseFences(uint32_t count, const VkFence* fences);
+
+            /*! @brief Returns an unsignaled binary semaphore.
+             */
+            VkSemaphore acquireSemaphore();
+
+            /*! @brief Returns a binary semaphore to the pool. It must be
+             *      unsignaled, with no pending operations on it.
+             */
+            void releaseSemaphore(VkSemaphore semaphore);
+
+            /*! @brief Returns an unset event.
+             */
+            VkEvent acquireEvent();
+
+            /*! @brief Resets the event and returns it to the pool.
+             */
+            void releaseEvent(VkEvent event);
+
+            /*! @brief Returns true if the pool has per-queue timelines.
+             */
+            bool hasTimelines() const;
+
+            /*! @brief Returns the timeline of the queue. If the queue does
+             *      not belong to the device, an exception is thrown.
+             *  @note Timeline semaphores must be enabled.
+             */
+            TimelineSemaphore& getTimeline(const Queue& queue);
+
+        private:
+
+            struct QueueTimeline
+            {
+                uint32_t family;
+                uint32_t index;
+                std::unique_ptr<TimelineSemaphore> timeline;
+            };
+
+            SyncPool(const SyncPool&) = delete;
+            SyncPool& operator=(const SyncPool&) = delete;
+
+            VkDevice mDevice;
+            const DeviceDispatch& mDispatch;
+            const VkAllocationCallbacks* mCallbacks;
+
+            std::mutex mFenceMutex;
+            std::vector<VkFence> mFences;
+
+            std::mutex mSemaphoreMutex;
+            std::vector<VkSemaphore> mSemaphores;
+
+            std::mutex mEventMutex;
+            std::vector<VkEvent> mEvents;
+
+            std::vector<QueueTimeline> mTimelines;
+    };
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef VW_THREADPOOL_H
+#define VW_THREADPOOL_H
+
+#include <vw/common.h>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vw
+{
+    /*! @brief A fixed set of worker threads running tasks in the order they
+     *      were enqueued.
+     *
+     *  Each task is passed the index of the worker running it, in
+     *  [0, getThreadCount()), so tasks can use per-thread objects such as a
+     *  CommandPoolSet or PipelineCache without locking.
+     */
+    class ThreadPool
+    {
+        public:
+
+            using Task = std::function<void(uint32_t thread)>;
+
+            /*! @brief Starts the workers.
+             *  @param threadCount The number of workers. 0 uses the number of
+             *      hardware threads.
+             */
+            explicit ThreadPool(uint32_t threadCount = 0);
+
+            /*! @brief Runs the tasks already enqueued, then joins the workers.
+             *      An exception not yet rethrown by waitIdle() is discarded.
+             */
+            ~ThreadPool();
+
+            /*! @brief Queues a task to run on a worker. Exceptions thrown by
+             *      tasks are caught; the first is rethrown by waitIdle() and
+             *      the rest are discarded.
+             */
+            void enqueue(Task task);
+
+            /*! @brief Blocks until every enqueued task has finished, then
+             *      rethrows the first exception a task threw since the last
+             *      call, if any.
+             */
+            void waitIdle();
+
+            /*! @brief Returns the number of workers.
+             */
+            uint32_t getThreadCount() const;
+
+        private:
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            void run(uint32_t thread);
+
+            std::mutex mMutex;
+            std::condition_variable mTaskReady;
+            std::condition_variable mIdle;
+            std::deque<Task> mTasks;
+            std::exception_ptr mError;
+            uint32_t mActive;
+            bool mStopping;
+            std::vector<std::thread> mThreads;
+    };
+}
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef VW_TIMELINESEMAPHORE_H
+#define VW_TIMELINESEMAPHORE_H
+
+#include <vw/common.h>
+#include <vw/result.h>
+#include <atomic>
+#include <limits>
+
+namespace vw
+{
+    struct DeviceDispatch;
+
+    /*! @brief A wrapper for a timeline VkSemaphore whose payload only ever
+     *      increases.
+     *
+     *  Each submission signals the value returned by advance(). The last value
+     *  known to have completed is cached, so checking whether work retired is
+     *  usually an atomic load and only queries the driver when the cache is
+     *  behind the requested value.
+     */
+    class TimelineSemaphore
+    {
+        public:
+
+            /*! @brief Creates a timeline semaphore with an initial value of 0.
+             *      The device must have timeline semaphores enabled.
+             *  @param callbacks The host allocation callbacks the device was
+             *      created with, if any.
+             */
+            TimelineSemaphore(VkDevice device, const DeviceDispatch& dispatch,
+                const VkAllocationCallbacks* callbacks = nullptr);
+
+            /*! @brief Destroys the semaphore. The device must be done with it.
+             */
+            ~TimelineSemaphore();
+
+            /*! @brief Reserves and returns the next value to signal. Values
+             *      must be signaled in the order they were reserved.
+             */
+            uint64_t advance();
+
+            /*! @brief Returns the last value reserved with advance().
+             */
+            uint64_t getLastValue() const;
+
+            /*! @brief Returns true once the semaphore has reached the value.
+             */
+            bool isRetired(uint64_t value);
+
+            /*! @brief Blocks until the semaphore reaches the value or the
+             *      timeout in nanoseconds expires.
+             *  @return True if the value was reached.
+             */
+            bool wait(uint64_t value,
+                uint64_t timeout = std::numeric_limits<uint64_t>::max());
+
+            /*! @brief Queries the current value of the semaphore from the
+             *      device and updates the cached value.
+             */
+            uint64_t getCompletedValue();
+
+            /*! @brief Signals a value reserved with advance() from the host,
+             *      for when the submission meant to signal it failed. Blocks
+             *      until the value before it is reached first, since the host
+             *      may not signal ahead of pending submissions.
+             */
+            void signal(uint64_t value);
+
+            /*! @brief Waits like wait() without throwing.
+             *  @return VK_SUCCESS if the value was reached, VK_TIMEOUT if the
+             *      timeout expired, or the error.
+             */
+            Result<void> tryWait(uint64_t value,
+                uint64_t timeout = std::numeric_limits<uint64_t>::max()) noexcept;
+
+            /*! @brief Queries the current value like getCompletedValue()
+             *      without throwing.
+             */
+            Result<uint64_t> tryGetCompletedValue() noexcept;
+
+            /*! @brief Signals the value like signal() without throwing.
+             */
+            Result<void> trySignal(uint64_t value) noexcept;
+
+            /*! @brief Returns the underlying VkSemaphore handle.
+             */
+            VkSemaphore getHandle();
+
+        private:
+
+            TimelineSemaphore(const TimelineSemaphore&) = delete;
+            TimelineSemaphore& operator=(const TimelineSemaphore&) = delete;
+
+            void updateCompleted(uint64_t value);
+
+            VkDevice mDevice;
+            const DeviceDispatch& mDispatch;
+            const VkAllocationCallbacks* mCallbacks;
+            VkSemaphore mHandle;
+            std::atomic<uint64_t> mLastValue;
+            std::atomic<uint64_t> mCompletedValue;
+    };
+}
+
+#endif
@@ -0,0 +1,183 @@
+#ifndef VW_TRANSFERENGINE_H
+#define VW_TRANSFERENGINE_H
+
+#include <vw/common.h>
+#include <vw/stagingring.h>
+#include <vw/timelinesemaphore.h>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace vw
+{
+    class Device;
+    class ImageCopyPlanner;
+    class Queue;
+
+    /*! @brief Uploads buffers and images on the device's transfer queue so
+     *      copies overlap with graphics and compute work.
+     *
+     *  Uploads may be queued from any thread. Their data is copied into a
+     *  StagingRing right away, and the copies are recorded into one command
+     *  buffer and submitted together on flush(). Every upload returns the
+     *  value the engine's timeline reaches once it completes. The engine has
+     *  a timeline of its own, since only it knows the order values are
+     *  signaled in.
+     *
+     *  When the destination is used on another queue family, the engine
+     *  records the ownership release, and the consumer records the matching
+     *  acquire with recordAcquires() before using the resources.
+     */
+    class TransferEngine
+    {
+        public:
+
+            /*! @brief Constructs an engine on the device's transfer queue. The
+             *      device must have timeline semaphores enabled.
+             *  @param stagingCapacity The size of the staging ring in bytes.
+             */
+            TransferEngine(Device& device, VkDeviceSize stagingCapacity);
+
+            /*! @brief Waits for all submitted uploads and destroys the command
+             *      pool. Uploads that were never flushed are discarded.
+             */
+            ~TransferEngine();
+
+            /*! @brief Queues a copy of host data into a buffer. If the staging
+             *      ring is full, queued uploads are flushed and the call
+             *      blocks until space is retired.
+             *  @param dstFamily The family that will use the buffer, or
+             *      VK_QUEUE_FAMILY_IGNORED if it is used on the transfer
+             *      queue's family.
+             *  @return The timeline value signaled once the copy completes.
+             */
+            uint64_t uploadBuffer(const void* data, VkDeviceSize size, VkBuffer dst,
+                VkDeviceSize dstOffset, uint32_t dstFamily = VK_QUEUE_FAMILY_IGNORED);
+
+            /*! @brief Queues a copy of host data into an image.
+             *  @param regions The regions to copy. Their buffer offsets are
+             *      relative to data.
+             *  @param range The subresources written, which are transitioned
+             *      to finalLayout once the copy completes. Their previous
+             *      contents are discarded.
+             *  @return The timeline value signaled once the copy completes.
+             */
+            uint64_t uploadImage(const void* data, VkDeviceSize size, VkImage dst,
+                uint32_t regionCount, const VkBufferImageCopy* regions,
+                const VkImageSubresourceRange& range, VkImageLayout finalLayout,
+                uint32_t dstFamily = VK_QUEUE_FAMILY_IGNORED);
+
+            /*! @brief Queues a partial update of an image subresource. Only
+             *      the planner's regions are staged, packed from a full copy of
+             *      the subresource in host memory, so small changes stay cheap
+             *      and meet the transfer queue's granularity.
+             *  @param planner The dirty regions, planned for the transfer
+             *      queue's family.
+             *  @param rowPitch The bytes between rows of texel blocks in data.
+             *  @param slicePitch The bytes between slices in data.
+             *  @param currentLayout The layout of the subresource, whose
+             *      contents outside the regions are preserved. It must be
+             *      usable on the transfer queue's family, for example through
+             *      concurrent sharing.
+             *  @return The timeline value signaled once the copy completes, or
+             *      the last value if the planner is empty.
+             */
+            uint64_t updateImage(const ImageCopyPlanner& planner, const void* data,
+                size_t rowPitch, size_t slicePitch, VkImage dst,
+                const VkImageSubresourceLayers& subresource, VkImageLayout currentLayout,
+                VkImageLayout finalLayout, uint32_t dstFamily = VK_QUEUE_FAMILY_IGNORED);
+
+            /*! @brief Records and submits every queued upload. If recording
+             *      or submitting fails, the uploads are discarded and their
+             *      value is signaled from the host before the error is
+             *      rethrown, so waits on it still return.
+             *  @return The timeline value of the submission, or the last
+             *      value if there was nothing to submit.
+             */
+            uint64_t flush();
+
+            /*! @brief Records the ownership acquires of flushed uploads destined
+             *      for the family. The submission of the command buffer must
+             *      wait on the returned value of getTimeline().
+             *  @return The value to wait on, or 0 if nothing was recorded.
+             */
+            uint64_t recordAcquires(VkCommandBuffer commandBuffer, uint32_t family,
+                VkPipelineStageFlags dstStages, VkAccessFlags dstAccess);
+
+            /*! @brief Returns true once the timeline value is reached.
+             */
+            bool isComplete(uint64_t value);
+
+            /*! @brief Blocks until the timeline value is reached.
+             */
+            void wait(uint64_t value);
+
+            /*! @brief Returns the timeline signaled by the engine's
+             *      submissions.
+             */
+            TimelineSemaphore& getTimeline();
+
+            /*! @brief Returns the queue uploads are submitted to.
+             */
+            Queue& getQueue();
+
+        private:
+
+            struct Job
+            {
+                StagingRing::Reservation reservation;
+                VkBuffer buffer;
+                VkDeviceSize bufferOffset;
+                VkImage image;
+                std::vector<VkBufferImageCopy> regions;
+                VkImageSubresourceRange range;
+                VkImageLayout initialLayout;
+                VkImageLayout finalLayout;
+                uint32_t dstFamily;
+            };
+
+            struct Acquire
+            {
+                uint64_t value;
+                uint32_t family;
+                Job job;
+            };
+
+            struct InFlight
+            {
+                VkCommandBuffer commandBuffer;
+                uint64_t value;
+            };
+
+            TransferEngine(const TransferEngine&) = delete;
+            TransferEngine& operator=(const TransferEngine&) = delete;
+
+            uint64_t enqueue(VkDeviceSize size, VkDeviceSize alignment,
+                const std::function<void(void*)>& write, Job& job);
+            bool needsTransfer(const Job& job) const;
+            VkCommandBuffer getCommandBuffer();
+            void retireCommandBuffers();
+            void record(VkCommandBuffer commandBuffer, const std::vector<Job>& jobs);
+
+            Device& mDevice;
+            Queue& mQueue;
+            uint32_t mFamily;
+            TimelineSemaphore mTimeline;
+            StagingRing mRing;
+            VkCommandPool mCommandPool;
+
+            std::mutex mJobMutex;
+            std::vector<Job> mJobs;
+
+            std::mutex mSubmitMutex;
+            std::vector<Job> mRecording;
+            std::deque<InFlight> mInFlight;
+            std::vector<VkCommandBuffer> mFreeCommandBuffers;
+
+            std::mutex mAcquireMutex;
+            std::vector<Acquire> mAcquires;
+    };
+}
+
+#endif
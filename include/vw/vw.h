@@ -2,12 +2,37 @@
 #define VW_VW_H
 
 #include <vw/exception.h>
+#include <vw/asyncdebugcallback.h>
+#include <vw/commandpoolset.h>
+#include <vw/computecontext.h>
 #include <vw/device.h>
+#include <vw/devicecapabilities.h>
+#include <vw/devicecluster.h>
+#include <vw/devicedispatch.h>
 #include <vw/debugcallback.h>
+#include <vw/descriptorallocator.h>
+#include <vw/gpuprofiler.h>
+#include <vw/hostallocator.h>
+#include <vw/hostimport.h>
+#include <vw/imagecopyplanner.h>
 #include <vw/instance.h>
+#include <vw/memoryallocator.h>
+#include <vw/parallelrecorder.h>
 #include <vw/physicaldevice.h>
+#include <vw/pipelinecache.h>
+#include <vw/pipelinecompiler.h>
 #include <vw/queue.h>
 #include <vw/queuefamily.h>
+#include <vw/result.h>
+#include <vw/shadermodulecache.h>
+#include <vw/sparsebuffer.h>
+#include <vw/stagingring.h>
+#include <vw/streamloader.h>
+#include <vw/submissioncoalescer.h>
+#include <vw/syncpool.h>
+#include <vw/threadpool.h>
+#include <vw/timelinesemaphore.h>
+#include <vw/transferengine.h>
 
 namespace vw
 {
@@ -0,0 +1,246 @@
+#include "vw/asyncdebugcallback.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace vw
+{
+    const size_t AsyncDebugCallback::MaxMessageLength;
+    const size_t AsyncDebugCallback::MaxLayerPrefixLength;
+
+    namespace
+    {
+        // Repeats are forgotten once this many keys are tracked
+        const size_t MaxTrackedRepeats = 4096;
+
+        void copyString(char* dst, const char* src, size_t maxLength)
+        {
+            size_t length = (src) ? strnlen(src, maxLength) : 0;
+            if (length > 0)
+                std::memcpy(dst, src, length);
+            dst[length] = '\0';
+        }
+    }
+
+    AsyncDebugCallback::Settings::Settings()
+        : capacity(512)
+        , repeatInterval(1000)
+        , maxPerSecond(100)
+        , drainInterval(10)
+    {
+    }
+
+    AsyncDebugCallback::AsyncDebugCallback(std::shared_ptr<DebugCallback> callback,
+        const Settings& settings)
+        : mCallback(std::move(callback))
+        , mSettings(settings)
+        , mMask(0)
+        , mEnqueuePosition(0)
+        , mDequeuePosition(0)
+        , mDelivered(0)
+        , mDropped(0)
+        , mRepeated(0)
+        , mRateLimited(0)
+        , mRateWindowStart(Clock::now())
+        , mRateWindowCount(0)
+        , mStop(false)
+    {
+        assert(mCallback);
+
+        size_t capacity = 2;
+        while (capacity < mSettings.capacity)
+            capacity *= 2;
+        mMask = capacity - 1;
+
+        // A slot is free for the enqueue at position p when its sequence is
+        // p, and holds a message for the dequeue at p when it is p + 1
+        mSlots.reset(new Slot[capacity]);
+        for (size_t i = 0; i < capacity; ++i)
+            mSlots[i].sequence.store(i, std::memory_order_relaxed);
+
+        mThread = std::thread(&AsyncDebugCallback::run, this);
+    }
+
+    AsyncDebugCallback::~AsyncDebugCallback()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mThreadMutex);
+            mStop = true;
+        }
+
+        mWakeUp.notify_one();
+        mThread.join();
+
+        flush();
+    }
+
+    bool AsyncDebugCallback::operator()(const CallbackData& data)
+    {
+        size_t position = mEnqueuePosition.load(std::memory_order_relaxed);
+        Slot* slot = nullptr;
+        for (;;)
+        {
+            slot = &mSlots[position & mMask];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) -
+                static_cast<intptr_t>(position);
+
+            if (difference == 0)
+            {
+                if (mEnqueuePosition.compare_exchange_weak(position, position + 1,
+                    std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                // Full, and waiting on the drain thread would stall the caller
+                mDropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                position = mEnqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->flags = data.flags;
+        slot->objectType = data.objectType;
+        slot->object = data.object;
+        slot->location = data.location;
+        slot->messageCode = data.messageCode;
+        copyString(slot->layerPrefix, data.layerPrefix, MaxLayerPrefixLength);
+        copyString(slot->message, data.message, MaxMessageLength);
+        slot->sequence.store(position + 1, std::memory_order_release);
+
+        return false;
+    }
+
+    void AsyncDebugCallback::flush()
+    {
+        drain();
+    }
+
+    AsyncDebugCallback::Statistics AsyncDebugCallback::getStatistics() const
+    {
+        Statistics statistics;
+        statistics.delivered = mDelivered.load(std::memory_order_relaxed);
+        statistics.dropped = mDropped.load(std::memory_order_relaxed);
+        statistics.repeated = mRepeated.load(std::memory_order_relaxed);
+        statistics.rateLimited = mRateLimited.load(std::memory_order_relaxed);
+        return statistics;
+    }
+
+    void AsyncDebugCallback::run()
+    {
+        // Producers never signal, since that would take a lock on their side,
+        // so the ring is polled
+        std::unique_lock<std::mutex> lock(mThreadMutex);
+        while (!mStop)
+        {
+            lock.unlock();
+            drain();
+            lock.lock();
+
+            mWakeUp.wait_for(lock, mSettings.drainInterval, [this]() { return mStop; });
+        }
+    }
+
+    void AsyncDebugCallback::drain()
+    {
+        std::lock_guard<std::mutex> lock(mDrainMutex);
+
+        Clock::time_point now = Clock::now();
+        for (;;)
+        {
+            Slot& slot = mSlots[mDequeuePosition & mMask];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence != mDequeuePosition + 1)
+                break;
+
+            deliver(slot, now);
+
+            slot.sequence.store(mDequeuePosition + mMask + 1, std::memory_order_release);
+            ++mDequeuePosition;
+        }
+
+        // Forget keys that have not repeated lately
+        if (mRepeats.size() > MaxTrackedRepeats)
+        {
+            for (auto it = mRepeats.begin(); it != mRepeats.end();)
+            {
+                if (it->second.suppressed == 0 &&
+                    now - it->second.lastDelivery >= mSettings.repeatInterval)
+                {
+                    it = mRepeats.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    void AsyncDebugCallback::deliver(const Slot& slot, Clock::time_point now)
+    {
+        Repeat* repeat = nullptr;
+        if (mSettings.repeatInterval.count() > 0)
+        {
+            auto it = mRepeats.find(Key(slot.messageCode, slot.object));
+            if (it != mRepeats.end() && now - it->second.lastDelivery < mSettings.repeatInterval)
+            {
+                ++it->second.suppressed;
+                mRepeated.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            if (it != mRepeats.end())
+                repeat = &it->second;
+        }
+
+        // Errors are always worth seeing
+        if (mSettings.maxPerSecond > 0 && !(slot.flags & VK_DEBUG_REPORT_ERROR_BIT_EXT))
+        {
+            if (now - mRateWindowStart >= std::chrono::seconds(1))
+            {
+                mRateWindowStart = now;
+                mRateWindowCount = 0;
+            }
+
+            if (mRateWindowCount >= mSettings.maxPerSecond)
+            {
+                mRateLimited.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            ++mRateWindowCount;
+        }
+
+        uint32_t repeatCount = 0;
+        if (mSettings.repeatInterval.count() > 0)
+        {
+            if (!repeat)
+                repeat = &mRepeats[Key(slot.messageCode, slot.object)];
+            else
+                repeatCount = repeat->suppressed;
+
+            repeat->lastDelivery = now;
+            repeat->suppressed = 0;
+        }
+
+        CallbackData data;
+        data.flags = slot.flags;
+        data.objectType = slot.objectType;
+        data.object = slot.object;
+        data.location = slot.location;
+        data.messageCode = slot.messageCode;
+        data.layerPrefix = slot.layerPrefix;
+        data.message = slot.message;
+        data.repeatCount = repeatCount;
+
+        mCallback->operator()(data);
+        mDelivered.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,155 @@
+#include "vw/commandpoolset.h"
+
+#include <cassert>
+
+#include "vw/device.h"
+#include "vw/devicedispatch.h"
+#include "vw/exception.h"
+#include "vw/queuefamily.h"
+
+namespace vw
+{
+    namespace
+    {
+        // Number of command buffers allocated at once when a pool runs dry
+        const uint32_t GrowCount = 8;
+    }
+
+    CommandPoolSet::CommandPoolSet(Device& device, const QueueFamily& family,
+        uint32_t threadCount, uint32_t framesInFlight)
+        : mDevice(device)
+        , mFamilyIndex(static_cast<uint32_t>(family.getIndex()))
+        , mThreadCount(threadCount)
+        , mFramesInFlight(framesInFlight)
+        , mFrame(0)
+        , mSlots(threadCount * framesInFlight)
+    {
+        assert(mDevice);
+        assert(mThreadCount > 0 && mFramesInFlight > 0);
+
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+
+        VkCommandPoolCreateInfo cinfo;
+        cinfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        cinfo.pNext = nullptr;
+        cinfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        cinfo.queueFamilyIndex = mFamilyIndex;
+
+        for (Slot& slot : mSlots)
+        {
+            slot.pool = VK_NULL_HANDLE;
+            slot.frame = 0;
+            slot.used[0] = 0;
+            slot.used[1] = 0;
+        }
+
+        for (Slot& slot : mSlots)
+        {
+            VkResult result = dispatch.vkCreateCommandPool(mDevice.getHandle(),
+                &cinfo, mDevice.getAllocationCallbacks(), &slot.pool);
+            if (result != VK_SUCCESS)
+            {
+                destroy();
+                throw Exception("vw::CommandPoolSet::CommandPoolSet", result);
+            }
+        }
+    }
+
+    CommandPoolSet::~CommandPoolSet()
+    {
+        destroy();
+    }
+
+    void CommandPoolSet::beginFrame()
+    {
+        mFrame.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    VkCommandBuffer CommandPoolSet::allocate(uint32_t thread, VkCommandBufferLevel level)
+    {
+        Slot& slot = getSlot(thread);
+        size_t kind = (level == VK_COMMAND_BUFFER_LEVEL_PRIMARY) ? 0 : 1;
+        std::vector<VkCommandBuffer>& buffers = slot.buffers[kind];
+
+        if (slot.used[kind] == buffers.size())
+        {
+            VkCommandBufferAllocateInfo info;
+            info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            info.pNext = nullptr;
+            info.commandPool = slot.pool;
+            info.level = level;
+            info.commandBufferCount = GrowCount;
+
+            size_t offset = buffers.size();
+            buffers.resize(offset + GrowCount, VK_NULL_HANDLE);
+
+            VkResult result = mDevice.getDispatch().vkAllocateCommandBuffers(
+                mDevice.getHandle(), &info, &buffers[offset]);
+            if (result != VK_SUCCESS)
+            {
+                buffers.resize(offset);
+                throw Exception("vw::CommandPoolSet::allocate", result);
+            }
+        }
+
+        return buffers[slot.used[kind]++];
+    }
+
+    VkCommandPool CommandPoolSet::getPool(uint32_t thread)
+    {
+        return getSlot(thread).pool;
+    }
+
+    uint32_t CommandPoolSet::getThreadCount() const
+    {
+        return mThreadCount;
+    }
+
+    uint32_t CommandPoolSet::getFramesInFlight() const
+    {
+        return mFramesInFlight;
+    }
+
+    uint32_t CommandPoolSet::getFamilyIndex() const
+    {
+        return mFamilyIndex;
+    }
+
+    void CommandPoolSet::destroy()
+    {
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+
+        // Destroying a pool frees its command buffers
+        for (Slot& slot : mSlots)
+        {
+            if (slot.pool != VK_NULL_HANDLE)
+                dispatch.vkDestroyCommandPool(mDevice.getHandle(),
+                    slot.pool, mDevice.getAllocationCallbacks());
+            slot.pool = VK_NULL_HANDLE;
+        }
+    }
+
+    CommandPoolSet::Slot& CommandPoolSet::getSlot(uint32_t thread)
+    {
+        assert(thread < mThreadCount);
+
+        uint64_t frame = mFrame.load(std::memory_order_acquire);
+        Slot& slot = mSlots[(frame % mFramesInFlight) * mThreadCount + thread];
+
+        // Reset the pool the first time it is used in a new frame. Only the
+        // owning thread touches the slot, so no locking is needed.
+        if (slot.frame != frame)
+        {
+            VkResult result = mDevice.getDispatch().vkResetCommandPool(
+                mDevice.getHandle(), slot.pool, 0);
+            if (result != VK_SUCCESS)
+                throw Exception("vw::CommandPoolSet::allocate", result);
+
+            slot.frame = frame;
+            slot.used[0] = 0;
+            slot.used[1] = 0;
+        }
+
+        return slot;
+    }
+}
@@ -0,0 +1,588 @@
+#include "vw/computecontext.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "vw/device.h"
+#include "vw/devicedispatch.h"
+#include "vw/exception.h"
+#include "vw/queue.h"
+#include "vw/shadermodulecache.h"
+
+#include "hash.h"
+
+namespace vw
+{
+    const uint32_t ComputeContext::MaxBindings;
+    const uint32_t ComputeContext::MaxPushConstantSize;
+
+    namespace
+    {
+        bool isSupported(VkDescriptorType type)
+        {
+            return type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER ||
+                type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        }
+    }
+
+    ComputeContext::Settings::Settings()
+        : batchCount(3)
+        , dispatchesPerBatch(256)
+        , pipelineCache(VK_NULL_HANDLE)
+    {
+    }
+
+    ComputeContext::ComputeContext(Device& device, const Settings& settings)
+        : mDevice(device)
+        , mQueue(device.getQueue(Device::QueueRole_Compute))
+        , mSettings(settings)
+        , mTimeline(device.getHandle(), device.getDispatch(), device.getAllocationCallbacks())
+        , mCurrentBatch(0)
+        , mRecording(false)
+        , mDispatched(false)
+        , mBoundPipeline(VK_NULL_HANDLE)
+    {
+        assert(mSettings.batchCount > 0);
+        assert(mSettings.dispatchesPerBatch > 0);
+
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+
+        Batch empty;
+        empty.commandPool = VK_NULL_HANDLE;
+        empty.commandBuffer = VK_NULL_HANDLE;
+        empty.descriptorPool = VK_NULL_HANDLE;
+        empty.value = 0;
+        empty.dispatchCount = 0;
+        mBatches.assign(mSettings.batchCount, empty);
+
+        // Every dispatch of a batch fits in its descriptor pool
+        VkDescriptorPoolSize sizes[2];
+        sizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        sizes[0].descriptorCount = mSettings.dispatchesPerBatch * MaxBindings;
+        sizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        sizes[1].descriptorCount = mSettings.dispatchesPerBatch * MaxBindings;
+
+        try
+        {
+            for (Batch& batch : mBatches)
+            {
+                VkCommandPoolCreateInfo poolInfo;
+                poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+                poolInfo.pNext = nullptr;
+                poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+                poolInfo.queueFamilyIndex = mQueue.getFamilyIndex();
+
+                VkResult result = dispatch.vkCreateCommandPool(mDevice.getHandle(),
+                    &poolInfo, mDevice.getAllocationCallbacks(), &batch.commandPool);
+                if (result != VK_SUCCESS)
+                    throw Exception("vw::ComputeContext::ComputeContext", result);
+
+                VkCommandBufferAllocateInfo bufferInfo;
+                bufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+                bufferInfo.pNext = nullptr;
+                bufferInfo.commandPool = batch.commandPool;
+                bufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+                bufferInfo.commandBufferCount = 1;
+
+                result = dispatch.vkAllocateCommandBuffers(mDevice.getHandle(),
+                    &bufferInfo, &batch.commandBuffer);
+                if (result != VK_SUCCESS)
+                    throw Exception("vw::ComputeContext::ComputeContext", result);
+
+                VkDescriptorPoolCreateInfo descriptorInfo;
+                descriptorInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+                descriptorInfo.pNext = nullptr;
+                descriptorInfo.flags = 0;
+                descriptorInfo.maxSets = mSettings.dispatchesPerBatch;
+                descriptorInfo.poolSizeCount = 2;
+                descriptorInfo.pPoolSizes = sizes;
+
+                result = dispatch.vkCreateDescriptorPool(mDevice.getHandle(),
+                    &descriptorInfo, mDevice.getAllocationCallbacks(), &batch.descriptorPool);
+                if (result != VK_SUCCESS)
+                    throw Exception("vw::ComputeContext::ComputeContext", result);
+            }
+        }
+        catch (...)
+        {
+            for (Batch& batch : mBatches)
+            {
+                if (batch.commandPool != VK_NULL_HANDLE)
+                    dispatch.vkDestroyCommandPool(mDevice.getHandle(),
+                        batch.commandPool, mDevice.getAllocationCallbacks());
+                if (batch.descriptorPool != VK_NULL_HANDLE)
+                    dispatch.vkDestroyDescriptorPool(mDevice.getHandle(),
+                        batch.descriptorPool, mDevice.getAllocationCallbacks());
+            }
+            throw;
+        }
+    }
+
+    ComputeContext::~ComputeContext()
+    {
+        if (mRecording)
+        {
+            try
+            {
+                submitBatch();
+            }
+            catch (...)
+            {
+                // The device is going away either way
+            }
+        }
+
+        try
+        {
+            mTimeline.wait(mTimeline.getLastValue());
+        }
+        catch (...)
+        {
+            // The device is lost, so nothing is pending anymore
+        }
+
+        // Destroying the pools frees their command buffers and sets
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+        for (Batch& batch : mBatches)
+        {
+            dispatch.vkDestroyCommandPool(mDevice.getHandle(),
+                batch.commandPool, mDevice.getAllocationCallbacks());
+            dispatch.vkDestroyDescriptorPool(mDevice.getHandle(),
+                batch.descriptorPool, mDevice.getAllocationCallbacks());
+        }
+
+        for (auto& kernel : mKernels)
+            destroyKernel(*kernel);
+    }
+
+    ComputeContext::KernelId ComputeContext::getKernel(const uint32_t* code,
+        size_t codeSize, uint32_t bindingCount, const Binding* bindings,
+        uint32_t pushConstantSize, const char* entryPoint)
+    {
+        assert(code && codeSize > 0 && codeSize % sizeof(uint32_t) == 0);
+        assert(bindingCount <= MaxBindings);
+        assert(pushConstantSize <= MaxPushConstantSize && pushConstantSize % 4 == 0);
+        assert(entryPoint);
+
+        Layout layout;
+        layout.reserve(bindingCount);
+        for (uint32_t i = 0; i < bindingCount; ++i)
+        {
+            assert(isSupported(bindings[i].type));
+            layout.push_back(std::make_pair(bindings[i].binding, bindings[i].type));
+        }
+        std::sort(layout.begin(), layout.end());
+
+        // Only the low half keys the index, since the code is compared on a
+        // match anyway
+        uint64_t hash;
+        uint64_t high;
+        hashWords(code, codeSize / sizeof(uint32_t), hash, high);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        return findKernel(hash, code, codeSize, layout, pushConstantSize, entryPoint);
+    }
+
+    uint64_t ComputeContext::dispatch(KernelId id, uint32_t bindingCount,
+        const Binding* bindings, const void* pushConstants, uint32_t groupCountX,
+        uint32_t groupCountY, uint32_t groupCountZ)
+    {
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        assert(id < mKernels.size());
+        const Kernel& kernel = *mKernels[id];
+        assert(bindingCount == kernel.layout.size());
+        assert(!kernel.pushConstantSize || pushConstants);
+
+        Batch& batch = beginBatch();
+
+        // The pool is sized for a full batch, so this only fails when the
+        // device is out of memory
+        VkDescriptorSetAllocateInfo setInfo;
+        setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        setInfo.pNext = nullptr;
+        setInfo.descriptorPool = batch.descriptorPool;
+        setInfo.descriptorSetCount = 1;
+        setInfo.pSetLayouts = &kernel.setLayout;
+
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        if (bindingCount > 0)
+        {
+            VkResult result = dispatch.vkAllocateDescriptorSets(mDevice.getHandle(),
+                &setInfo, &set);
+            if (result != VK_SUCCESS)
+                throw Exception("vw::ComputeContext::dispatch", result);
+
+            VkDescriptorBufferInfo bufferInfos[MaxBindings];
+            VkWriteDescriptorSet writes[MaxBindings];
+            for (uint32_t i = 0; i < bindingCount; ++i)
+            {
+                assert(std::find(kernel.layout.begin(), kernel.layout.end(),
+                    std::make_pair(bindings[i].binding, bindings[i].type)) !=
+                    kernel.layout.end());
+
+                bufferInfos[i].buffer = bindings[i].buffer;
+                bufferInfos[i].offset = bindings[i].offset;
+                bufferInfos[i].range = bindings[i].range;
+
+                writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[i].pNext = nullptr;
+                writes[i].dstSet = set;
+                writes[i].dstBinding = bindings[i].binding;
+                writes[i].dstArrayElement = 0;
+                writes[i].descriptorCount = 1;
+                writes[i].descriptorType = bindings[i].type;
+                writes[i].pImageInfo = nullptr;
+                writes[i].pBufferInfo = &bufferInfos[i];
+                writes[i].pTexelBufferView = nullptr;
+            }
+
+            dispatch.vkUpdateDescriptorSets(mDevice.getHandle(), bindingCount, writes,
+                0, nullptr);
+        }
+
+        VkCommandBuffer commandBuffer = batch.commandBuffer;
+
+        // Submission order alone does not make earlier writes visible
+        if (mDispatched)
+        {
+            VkMemoryBarrier barrier;
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.pNext = nullptr;
+            barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT |
+                VK_ACCESS_UNIFORM_READ_BIT;
+
+            dispatch.vkCmdPipelineBarrier(commandBuffer,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                0, 1, &barrier, 0, nullptr, 0, nullptr);
+        }
+
+        if (kernel.pipeline != mBoundPipeline)
+        {
+            dispatch.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                kernel.pipeline);
+            mBoundPipeline = kernel.pipeline;
+        }
+
+        if (set != VK_NULL_HANDLE)
+        {
+            dispatch.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                kernel.pipelineLayout, 0, 1, &set, 0, nullptr);
+        }
+
+        if (kernel.pushConstantSize > 0)
+        {
+            dispatch.vkCmdPushConstants(commandBuffer, kernel.pipelineLayout,
+                VK_SHADER_STAGE_COMPUTE_BIT, 0, kernel.pushConstantSize, pushConstants);
+        }
+
+        dispatch.vkCmdDispatch(commandBuffer, groupCountX, groupCountY, groupCountZ);
+        mDispatched = true;
+
+        uint64_t ticket = batch.value;
+        if (++batch.dispatchCount == mSettings.dispatchesPerBatch)
+            submitBatch();
+
+        return ticket;
+    }
+
+    uint64_t ComputeContext::dispatch(const uint32_t* code, size_t codeSize,
+        uint32_t bindingCount, const Binding* bindings, const void* pushConstants,
+        uint32_t pushConstantSize, uint32_t groupCountX, uint32_t groupCountY,
+        uint32_t groupCountZ)
+    {
+        KernelId kernel = getKernel(code, codeSize, bindingCount, bindings, pushConstantSize);
+        return dispatch(kernel, bindingCount, bindings, pushConstants, groupCountX,
+            groupCountY, groupCountZ);
+    }
+
+    uint64_t ComputeContext::flush()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mRecording)
+            submitBatch();
+
+        return mTimeline.getLastValue();
+    }
+
+    bool ComputeContext::isComplete(uint64_t ticket)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mRecording && ticket >= mBatches[mCurrentBatch].value)
+                submitBatch();
+        }
+
+        return mTimeline.isRetired(ticket);
+    }
+
+    void ComputeContext::wait(uint64_t ticket)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mRecording && ticket >= mBatches[mCurrentBatch].value)
+                submitBatch();
+        }
+
+        mTimeline.wait(ticket);
+    }
+
+    TimelineSemaphore& ComputeContext::getTimeline()
+    {
+        return mTimeline;
+    }
+
+    Queue& ComputeContext::getQueue()
+    {
+        return mQueue;
+    }
+
+    ComputeContext::KernelId ComputeContext::findKernel(uint64_t hash,
+        const uint32_t* code, size_t codeSize, const Layout& layout,
+        uint32_t pushConstantSize, const char* entryPoint)
+    {
+        // The hash only narrows the search, so a collision costs a compare
+        auto range = mKernelIndex.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            const Kernel& kernel = *mKernels[it->second];
+            if (kernel.code.size() * sizeof(uint32_t) == codeSize &&
+                kernel.pushConstantSize == pushConstantSize &&
+                kernel.layout == layout && kernel.entryPoint == entryPoint &&
+                std::memcmp(kernel.code.data(), code, codeSize) == 0)
+            {
+                return it->second;
+            }
+        }
+
+        std::unique_ptr<Kernel> kernel(new Kernel);
+        kernel->code.assign(code, code + codeSize / sizeof(uint32_t));
+        kernel->entryPoint = entryPoint;
+        kernel->layout = layout;
+        kernel->pushConstantSize = pushConstantSize;
+        buildKernel(*kernel);
+
+        KernelId id = static_cast<KernelId>(mKernels.size());
+        try
+        {
+            mKernels.push_back(std::move(kernel));
+            mKernelIndex.insert(std::make_pair(hash, id));
+        }
+        catch (...)
+        {
+            if (!kernel)
+            {
+                kernel = std::move(mKernels.back());
+                mKernels.pop_back();
+            }
+            destroyKernel(*kernel);
+            throw;
+        }
+
+        return id;
+    }
+
+    void ComputeContext::buildKernel(Kernel& kernel)
+    {
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+        VkDevice device = mDevice.getHandle();
+        const VkAllocationCallbacks* callbacks = mDevice.getAllocationCallbacks();
+
+        kernel.setLayout = VK_NULL_HANDLE;
+        kernel.pipelineLayout = VK_NULL_HANDLE;
+        kernel.pipeline = VK_NULL_HANDLE;
+
+        try
+        {
+            VkDescriptorSetLayoutBinding bindings[MaxBindings];
+            for (size_t i = 0; i < kernel.layout.size(); ++i)
+            {
+                bindings[i].binding = kernel.layout[i].first;
+                bindings[i].descriptorType = kernel.layout[i].second;
+                bindings[i].descriptorCount = 1;
+                bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+                bindings[i].pImmutableSamplers = nullptr;
+            }
+
+            VkDescriptorSetLayoutCreateInfo setInfo;
+            setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+            setInfo.pNext = nullptr;
+            setInfo.flags = 0;
+            setInfo.bindingCount = static_cast<uint32_t>(kernel.layout.size());
+            setInfo.pBindings = bindings;
+
+            VkResult result = dispatch.vkCreateDescriptorSetLayout(device, &setInfo,
+                callbacks, &kernel.setLayout);
+            if (result != VK_SUCCESS)
+                throw Exception("vw::ComputeContext::getKernel", result);
+
+            VkPushConstantRange pushRange;
+            pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+            pushRange.offset = 0;
+            pushRange.size = kernel.pushConstantSize;
+
+            VkPipelineLayoutCreateInfo layoutInfo;
+            layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+            layoutInfo.pNext = nullptr;
+            layoutInfo.flags = 0;
+            layoutInfo.setLayoutCount = 1;
+            layoutInfo.pSetLayouts = &kernel.setLayout;
+            layoutInfo.pushConstantRangeCount = (kernel.pushConstantSize > 0) ? 1 : 0;
+            layoutInfo.pPushConstantRanges = &pushRange;
+
+            result = dispatch.vkCreatePipelineLayout(device, &layoutInfo, callbacks,
+                &kernel.pipelineLayout);
+            if (result != VK_SUCCESS)
+                throw Exception("vw::ComputeContext::getKernel", result);
+
+            // Contexts building the same code share one module, and it is
+            // released once the pipeline no longer needs it
+            ShaderModuleCache::ModulePtr module = mDevice.getShaderModuleCache().acquire(
+                kernel.code.data(), kernel.code.size() * sizeof(uint32_t));
+
+            VkComputePipelineCreateInfo pipelineInfo;
+            pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+            pipelineInfo.pNext = nullptr;
+            pipelineInfo.flags = 0;
+            pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            pipelineInfo.stage.pNext = nullptr;
+            pipelineInfo.stage.flags = 0;
+            pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+            pipelineInfo.stage.module = module->getHandle();
+            pipelineInfo.stage.pName = kernel.entryPoint.c_str();
+            pipelineInfo.stage.pSpecializationInfo = nullptr;
+            pipelineInfo.layout = kernel.pipelineLayout;
+            pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+            pipelineInfo.basePipelineIndex = -1;
+
+            result = dispatch.vkCreateComputePipelines(device, mSettings.pipelineCache, 1,
+                &pipelineInfo, callbacks, &kernel.pipeline);
+            if (result != VK_SUCCESS)
+                throw Exception("vw::ComputeContext::getKernel", result);
+        }
+        catch (...)
+        {
+            destroyKernel(kernel);
+            throw;
+        }
+    }
+
+    void ComputeContext::destroyKernel(Kernel& kernel)
+    {
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+        VkDevice device = mDevice.getHandle();
+        const VkAllocationCallbacks* callbacks = mDevice.getAllocationCallbacks();
+
+        if (kernel.pipeline != VK_NULL_HANDLE)
+            dispatch.vkDestroyPipeline(device, kernel.pipeline, callbacks);
+        if (kernel.pipelineLayout != VK_NULL_HANDLE)
+            dispatch.vkDestroyPipelineLayout(device, kernel.pipelineLayout, callbacks);
+        if (kernel.setLayout != VK_NULL_HANDLE)
+            dispatch.vkDestroyDescriptorSetLayout(device, kernel.setLayout, callbacks);
+
+        kernel.pipeline = VK_NULL_HANDLE;
+        kernel.pipelineLayout = VK_NULL_HANDLE;
+        kernel.setLayout = VK_NULL_HANDLE;
+    }
+
+    ComputeContext::Batch& ComputeContext::beginBatch()
+    {
+        Batch& batch = mBatches[mCurrentBatch];
+        if (mRecording)
+            return batch;
+
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+
+        // The batch's previous submission must be done with its pools
+        if (batch.value > 0)
+            mTimeline.wait(batch.value);
+
+        VkResult result = dispatch.vkResetCommandPool(mDevice.getHandle(),
+            batch.commandPool, 0);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::ComputeContext::dispatch", result);
+
+        result = dispatch.vkResetDescriptorPool(mDevice.getHandle(), batch.descriptorPool, 0);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::ComputeContext::dispatch", result);
+
+        VkCommandBufferBeginInfo beginInfo;
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.pNext = nullptr;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        beginInfo.pInheritanceInfo = nullptr;
+
+        result = dispatch.vkBeginCommandBuffer(batch.commandBuffer, &beginInfo);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::ComputeContext::dispatch", result);
+
+        batch.value = mTimeline.advance();
+        batch.dispatchCount = 0;
+        mBoundPipeline = VK_NULL_HANDLE;
+        mRecording = true;
+        return batch;
+    }
+
+    void ComputeContext::submitBatch()
+    {
+        assert(mRecording);
+
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+        Batch& batch = mBatches[mCurrentBatch];
+
+        // Results are read back through mapped memory once the ticket is
+        // reached
+        VkMemoryBarrier barrier;
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.pNext = nullptr;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+        dispatch.vkCmdPipelineBarrier(batch.commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+            0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        mRecording = false;
+        mCurrentBatch = (mCurrentBatch + 1) % mBatches.size();
+
+        // The batch's value was handed out as a ticket when it opened, so it
+        // is signaled from the host if the work never reaches the queue
+        try
+        {
+            VkResult result = dispatch.vkEndCommandBuffer(batch.commandBuffer);
+            if (result != VK_SUCCESS)
+                throw Exception("vw::ComputeContext::flush", result);
+
+            VkSemaphore semaphore = mTimeline.getHandle();
+
+            VkTimelineSemaphoreSubmitInfo timelineInfo;
+            timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            timelineInfo.pNext = nullptr;
+            timelineInfo.waitSemaphoreValueCount = 0;
+            timelineInfo.pWaitSemaphoreValues = nullptr;
+            timelineInfo.signalSemaphoreValueCount = 1;
+            timelineInfo.pSignalSemaphoreValues = &batch.value;
+
+            VkSubmitInfo info;
+            info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            info.pNext = &timelineInfo;
+            info.waitSemaphoreCount = 0;
+            info.pWaitSemaphores = nullptr;
+            info.pWaitDstStageMask = nullptr;
+            info.commandBufferCount = 1;
+            info.pCommandBuffers = &batch.commandBuffer;
+            info.signalSemaphoreCount = 1;
+            info.pSignalSemaphores = &semaphore;
+
+            mQueue.submit(info);
+        }
+        catch (...)
+        {
+            mTimeline.trySignal(batch.value);
+            throw;
+        }
+    }
+}
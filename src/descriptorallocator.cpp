@@ -0,0 +1,205 @@
+#include "vw/descriptorallocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+#include "vw/device.h"
+#include "vw/devicedispatch.h"
+#include "vw/exception.h"
+
+namespace vw
+{
+    DescriptorAllocator::PoolRatioList DescriptorAllocator::getDefaultRatios()
+    {
+        PoolRatioList ratios;
+        ratios.push_back({ VK_DESCRIPTOR_TYPE_SAMPLER, 0.5f });
+        ratios.push_back({ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f });
+        ratios.push_back({ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 2.0f });
+        ratios.push_back({ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f });
+        ratios.push_back({ VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 0.5f });
+        ratios.push_back({ VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 0.5f });
+        ratios.push_back({ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f });
+        ratios.push_back({ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f });
+        ratios.push_back({ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f });
+        ratios.push_back({ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.0f });
+        ratios.push_back({ VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 0.5f });
+        return ratios;
+    }
+
+    DescriptorAllocator::DescriptorAllocator(Device& device, uint32_t threadCount,
+        uint32_t framesInFlight, uint32_t setsPerPool, PoolRatioList ratios)
+        : mDevice(device)
+        , mThreadCount(threadCount)
+        , mFramesInFlight(framesInFlight)
+        , mRatios(std::move(ratios))
+        , mFrame(0)
+        , mSlots(threadCount * framesInFlight)
+    {
+        assert(mDevice);
+        assert(mThreadCount > 0 && mFramesInFlight > 0);
+        assert(setsPerPool > 0 && !mRatios.empty());
+
+        for (Slot& slot : mSlots)
+        {
+            slot.current = 0;
+            slot.capacity = setsPerPool;
+            slot.setsUsed = 0;
+            slot.frame = 0;
+        }
+    }
+
+    DescriptorAllocator::~DescriptorAllocator()
+    {
+        for (Slot& slot : mSlots)
+            destroyPools(slot);
+    }
+
+    void DescriptorAllocator::beginFrame()
+    {
+        mFrame.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    VkDescriptorSet DescriptorAllocator::allocate(uint32_t thread,
+        VkDescriptorSetLayout layout)
+    {
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        allocate(thread, 1, &layout, &set);
+        return set;
+    }
+
+    void DescriptorAllocator::allocate(uint32_t thread, uint32_t count,
+        const VkDescriptorSetLayout* layouts, VkDescriptorSet* sets)
+    {
+        assert(count > 0);
+
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+        Slot& slot = getSlot(thread);
+
+        VkDescriptorSetAllocateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        info.pNext = nullptr;
+        info.descriptorSetCount = count;
+        info.pSetLayouts = layouts;
+
+        // A fresh pool failing means the sets need more descriptors than the
+        // ratios give them, so the next pool is made larger. Give up once
+        // that has not helped.
+        uint32_t freshFailures = 0;
+        for (;;)
+        {
+            bool fresh = false;
+            if (slot.current == slot.pools.size())
+            {
+                slot.capacity = std::max(slot.capacity, count);
+                slot.pools.push_back(createPool(slot.capacity));
+                fresh = true;
+            }
+
+            info.descriptorPool = slot.pools[slot.current];
+            VkResult result = dispatch.vkAllocateDescriptorSets(mDevice.getHandle(),
+                &info, sets);
+            if (result == VK_SUCCESS)
+            {
+                slot.setsUsed += count;
+                return;
+            }
+
+            if (result != VK_ERROR_FRAGMENTED_POOL && result != VK_ERROR_OUT_OF_POOL_MEMORY)
+                throw Exception("vw::DescriptorAllocator::allocate", result);
+
+            if (fresh && ++freshFailures > 2)
+                throw Exception("vw::DescriptorAllocator::allocate", result);
+
+            // Chain a larger pool behind the exhausted one
+            ++slot.current;
+            slot.capacity *= 2;
+        }
+    }
+
+    uint32_t DescriptorAllocator::getThreadCount() const
+    {
+        return mThreadCount;
+    }
+
+    uint32_t DescriptorAllocator::getFramesInFlight() const
+    {
+        return mFramesInFlight;
+    }
+
+    DescriptorAllocator::Slot& DescriptorAllocator::getSlot(uint32_t thread)
+    {
+        assert(thread < mThreadCount);
+
+        uint64_t frame = mFrame.load(std::memory_order_acquire);
+        Slot& slot = mSlots[(frame % mFramesInFlight) * mThreadCount + thread];
+
+        // Reset the pools the first time they are used in a new frame. Only
+        // the owning thread touches the slot, so no locking is needed.
+        if (slot.frame != frame)
+        {
+            if (slot.pools.size() > 1)
+            {
+                // The chain overflowed, so replace it with one pool that fits
+                // what the frame used with some headroom
+                destroyPools(slot);
+                slot.capacity = std::max(slot.capacity / 2, slot.setsUsed + slot.setsUsed / 2);
+            }
+            else if (!slot.pools.empty())
+            {
+                VkResult result = mDevice.getDispatch().vkResetDescriptorPool(
+                    mDevice.getHandle(), slot.pools.front(), 0);
+                if (result != VK_SUCCESS)
+                    throw Exception("vw::DescriptorAllocator::allocate", result);
+            }
+
+            slot.frame = frame;
+            slot.current = 0;
+            slot.setsUsed = 0;
+        }
+
+        return slot;
+    }
+
+    VkDescriptorPool DescriptorAllocator::createPool(uint32_t maxSets)
+    {
+        std::vector<VkDescriptorPoolSize> sizes;
+        sizes.reserve(mRatios.size());
+        for (const PoolRatio& ratio : mRatios)
+        {
+            VkDescriptorPoolSize size;
+            size.type = ratio.type;
+            size.descriptorCount = static_cast<uint32_t>(std::ceil(ratio.perSet * maxSets));
+            if (size.descriptorCount > 0)
+                sizes.push_back(size);
+        }
+
+        VkDescriptorPoolCreateInfo cinfo;
+        cinfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        cinfo.pNext = nullptr;
+        cinfo.flags = 0;
+        cinfo.maxSets = maxSets;
+        cinfo.poolSizeCount = static_cast<uint32_t>(sizes.size());
+        cinfo.pPoolSizes = sizes.data();
+
+        VkDescriptorPool pool = VK_NULL_HANDLE;
+        VkResult result = mDevice.getDispatch().vkCreateDescriptorPool(mDevice.getHandle(),
+            &cinfo, mDevice.getAllocationCallbacks(), &pool);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::DescriptorAllocator::allocate", result);
+
+        return pool;
+    }
+
+    void DescriptorAllocator::destroyPools(Slot& slot)
+    {
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+
+        // Destroying a pool frees its descriptor sets
+        for (VkDescriptorPool pool : slot.pools)
+            dispatch.vkDestroyDescriptorPool(mDevice.getHandle(),
+                pool, mDevice.getAllocationCallbacks());
+        slot.pools.clear();
+    }
+}
@@ -1,14 +1,69 @@
 #include "vw/device.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <mutex>
 #include <utility>
 
+#include "vw/devicedispatch.h"
 #include "vw/exception.h"
+#include "vw/hostimport.h"
+#include "vw/hostallocator.h"
+#include "vw/instance.h"
+#include "vw/memoryallocator.h"
 #include "vw/physicaldevice.h"
 #include "vw/queuefamily.h"
+#include "vw/shadermodulecache.h"
+#include "vw/syncpool.h"
 
 namespace vw
 {
+    namespace
+    {
+        void enableExtension(std::vector<const char*>& extensions, const char* name)
+        {
+            for (const char* ext : extensions)
+            {
+                if (std::strcmp(ext, name) == 0)
+                    return;
+            }
+
+            extensions.push_back(name);
+        }
+
+        // Destroys a new handle unless a Device takes it over
+        class DeviceGuard
+        {
+            public:
+
+                DeviceGuard(VkDevice handle, const VkAllocationCallbacks* callbacks)
+                    : mHandle(handle)
+                    , mCallbacks(callbacks)
+                {
+                }
+
+                ~DeviceGuard()
+                {
+                    if (mHandle != VK_NULL_HANDLE)
+                        vkDestroyDevice(mHandle, mCallbacks);
+                }
+
+                void release()
+                {
+                    mHandle = VK_NULL_HANDLE;
+                }
+
+            private:
+
+                DeviceGuard(const DeviceGuard&) = delete;
+                DeviceGuard& operator=(const DeviceGuard&) = delete;
+
+                VkDevice mHandle;
+                const VkAllocationCallbacks* mCallbacks;
+        };
+    }
+
     Device::QueueList::QueueList(Container container)
         : mContainer(std::move(container))
     {
@@ -22,6 +77,7 @@ namespace vw
     Device::QueueList& Device::QueueList::operator=(QueueList&& other)
     {
         std::swap(mContainer, other.mContainer);
+        return *this;
     }
 
     Device::QueueList::iterator Device::QueueList::begin()
@@ -61,19 +117,70 @@ namespace vw
 
     Device::Device()
         : mHandle(VK_NULL_HANDLE)
+        , mPhysicalDevice(VK_NULL_HANDLE)
+        , mEnabledFeatures()
         , mQueues(QueueList::Container())
+        , mQueueRoles()
     {
     }
 
-    Device::Device(VkDevice handle, QueueList queues)
+    Device::Device(VkDevice handle, const PhysicalDevice& physicalDevice,
+        std::unique_ptr<DeviceDispatch> dispatch, QueueList queues,
+        bool timelineSemaphores, QueueRoles roles, HostAllocatorPtr hostAllocator,
+        VkDeviceSize hostImportAlignment, const VkPhysicalDeviceFeatures* enabledFeatures)
         : mHandle(handle)
+        , mHostAllocator(std::move(hostAllocator))
+        , mPhysicalDevice(physicalDevice)
+        , mEnabledFeatures()
+        , mDispatch(std::move(dispatch))
         , mQueues(std::move(queues))
+        , mQueueRoles(roles)
     {
+        for (size_t role : mQueueRoles)
+            assert(role == 0 || role < mQueues.size());
+
+        if (enabledFeatures)
+            mEnabledFeatures = *enabledFeatures;
+
+        if (*this)
+        {
+            assert(mDispatch);
+
+            // The destructor won't run if construction fails, so the handle
+            // is destroyed here
+            try
+            {
+                mMemoryAllocator.reset(new MemoryAllocator(mHandle, *mDispatch,
+                    mPhysicalDevice, MemoryAllocator::DefaultBlockSize,
+                    getAllocationCallbacks()));
+                mSyncPool.reset(new SyncPool(mHandle, *mDispatch,
+                    QueueList::Container(mQueues.cbegin(), mQueues.cend()),
+                    timelineSemaphores, getAllocationCallbacks()));
+                mShaderModuleCache.reset(new ShaderModuleCache(mHandle, *mDispatch,
+                    getAllocationCallbacks()));
+                mHostImport.reset(new HostImport(mHandle, *mDispatch, *mMemoryAllocator,
+                    hostImportAlignment, getAllocationCallbacks()));
+            }
+            catch (...)
+            {
+                destroy();
+                throw;
+            }
+        }
     }
 
     Device::Device(Device&& other)
         : mHandle(other.mHandle)
+        , mHostAllocator(std::move(other.mHostAllocator))
+        , mPhysicalDevice(other.mPhysicalDevice)
+        , mEnabledFeatures(other.mEnabledFeatures)
+        , mDispatch(std::move(other.mDispatch))
+        , mMemoryAllocator(std::move(other.mMemoryAllocator))
         , mQueues(std::move(other.mQueues))
+        , mQueueRoles(other.mQueueRoles)
+        , mSyncPool(std::move(other.mSyncPool))
+        , mShaderModuleCache(std::move(other.mShaderModuleCache))
+        , mHostImport(std::move(other.mHostImport))
     {
         other.mHandle = VK_NULL_HANDLE;
     }
@@ -81,13 +188,23 @@ namespace vw
     Device::~Device()
     {
         if (*this)
-            vkDestroyDevice(mHandle, nullptr);
+            destroy();
     }
 
     Device& Device::operator=(Device&& other)
     {
         std::swap(mHandle, other.mHandle);
+        std::swap(mHostAllocator, other.mHostAllocator);
+        std::swap(mPhysicalDevice, other.mPhysicalDevice);
+        std::swap(mEnabledFeatures, other.mEnabledFeatures);
+        std::swap(mDispatch, other.mDispatch);
+        std::swap(mMemoryAllocator, other.mMemoryAllocator);
         std::swap(mQueues, other.mQueues);
+        std::swap(mQueueRoles, other.mQueueRoles);
+        std::swap(mSyncPool, other.mSyncPool);
+        std::swap(mShaderModuleCache, other.mShaderModuleCache);
+        std::swap(mHostImport, other.mHostImport);
+        return *this;
     }
 
     Device::operator bool() const
@@ -105,12 +222,111 @@ namespace vw
         return mQueues;
     }
 
+    Queue& Device::getQueue(QueueRole role)
+    {
+        assert(role < QueueRole_Count);
+        assert(mQueueRoles[role] < mQueues.size());
+        return *(mQueues.begin() + mQueueRoles[role]);
+    }
+
+    bool Device::hasDedicatedQueue(QueueRole role) const
+    {
+        assert(role < QueueRole_Count);
+        for (size_t other = 0; other < static_cast<size_t>(role); ++other)
+        {
+            if (mQueueRoles[other] == mQueueRoles[role])
+                return false;
+        }
+
+        return true;
+    }
+
+    void Device::waitIdle()
+    {
+        assert(*this);
+
+        // Every queue of the device must be externally synchronized. Other
+        // users only ever hold one of the locks, so taking them in order
+        // can't deadlock.
+        std::vector<std::unique_lock<std::mutex>> locks;
+        locks.reserve(mQueues.size());
+        for (const Queue& queue : mQueues)
+            locks.push_back(std::unique_lock<std::mutex>(queue.getMutex()));
+
+        VkResult result = mDispatch->vkDeviceWaitIdle(mHandle);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::Device::waitIdle", result);
+    }
+
+    const DeviceDispatch& Device::getDispatch() const
+    {
+        assert(mDispatch);
+        return *mDispatch;
+    }
+
+    const PhysicalDevice& Device::getPhysicalDevice() const
+    {
+        return mPhysicalDevice;
+    }
+
+    const VkPhysicalDeviceFeatures& Device::getEnabledFeatures() const
+    {
+        return mEnabledFeatures;
+    }
+
+    MemoryAllocator& Device::getMemoryAllocator()
+    {
+        assert(mMemoryAllocator);
+        return *mMemoryAllocator;
+    }
+
+    SyncPool& Device::getSyncPool()
+    {
+        assert(mSyncPool);
+        return *mSyncPool;
+    }
+
+    const VkAllocationCallbacks* Device::getAllocationCallbacks() const
+    {
+        return (mHostAllocator) ? mHostAllocator->getCallbacks() : nullptr;
+    }
+
+    const Device::HostAllocatorPtr& Device::getHostAllocator() const
+    {
+        return mHostAllocator;
+    }
+
+    ShaderModuleCache& Device::getShaderModuleCache()
+    {
+        assert(mShaderModuleCache);
+        return *mShaderModuleCache;
+    }
+
+    HostImport& Device::getHostImport()
+    {
+        assert(mHostImport);
+        return *mHostImport;
+    }
+
     VkDevice Device::getHandle()
     {
         return mHandle;
     }
 
+    void Device::destroy()
+    {
+        // Objects created from the device must go first
+        mHostImport.reset();
+        mShaderModuleCache.reset();
+        mSyncPool.reset();
+        mMemoryAllocator.reset();
+        mDispatch->vkDestroyDevice(mHandle, getAllocationCallbacks());
+        mHandle = VK_NULL_HANDLE;
+    }
+
     DeviceCreator::DeviceCreator()
+        : mPhysicalDevice(VK_NULL_HANDLE)
+        , mInstance(VK_NULL_HANDLE)
     {
         reset();
     }
@@ -121,7 +337,19 @@ namespace vw
 
         mQueueInfos.clear();
         mQueuePriorities.clear();
-        mPhysicalDevice = device.getHandle();
+        mPhysicalDevice = device;
+    }
+
+    void DeviceCreator::setInstance(Instance& instance)
+    {
+        assert(instance);
+
+        mInstance = instance.getHandle();
+        mInstanceApiVersion = instance.getApiVersion();
+        mInstanceProperties2 = instance.hasExtension(
+            VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+        mInstanceExternalMemory = instance.hasExtension(
+            VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME);
     }
 
     void DeviceCreator::addQueues(const QueueFamily& family, PriorityList priorities)
@@ -142,6 +370,57 @@ namespace vw
         mQueueInfos.push_back(cinfo);
     }
 
+    bool DeviceCreator::planQueues()
+    {
+        assert(mPhysicalDevice);
+        assert(mQueueInfos.empty() && "Queues were already added");
+
+        PhysicalDevice::QueueFamilyList families =
+            mPhysicalDevice.getDeviceQueueFamilies();
+
+        const QueueFamily* graphics = nullptr;
+        const QueueFamily* compute = nullptr;
+        const QueueFamily* transfer = nullptr;
+        for (const QueueFamily& family : families)
+        {
+            if (family.getQueueCount() == 0)
+                continue;
+
+            // Prefer a graphics family that can also run compute
+            if (family.hasGraphicsSupport() && (!graphics ||
+                (!graphics->hasComputeSupport() && family.hasComputeSupport())))
+            {
+                graphics = &family;
+            }
+            else if (!compute && family.hasComputeSupport() && !family.hasGraphicsSupport())
+            {
+                compute = &family;
+            }
+            else if (!transfer && family.hasTransferSupport() &&
+                !family.hasGraphicsSupport() && !family.hasComputeSupport())
+            {
+                transfer = &family;
+            }
+        }
+
+        if (!graphics)
+            return false;
+
+        // Without a compute family, a second graphics queue still lets compute
+        // work be submitted independently
+        PriorityList graphicsPriorities(1, 1.0f);
+        if (!compute && graphics->hasComputeSupport() && graphics->getQueueCount() > 1)
+            graphicsPriorities.push_back(0.5f);
+
+        addQueues(*graphics, graphicsPriorities);
+        if (compute)
+            addQueues(*compute, PriorityList(1, 0.5f));
+        if (transfer)
+            addQueues(*transfer, PriorityList(1, 0.5f));
+
+        return true;
+    }
+
     void DeviceCreator::addLayer(const std::string& name)
     {
         mLayers.push_back(name);
@@ -158,63 +437,298 @@ namespace vw
         mEnabledFeatures = features;
     }
 
+    void DeviceCreator::enableTimelineSemaphores()
+    {
+        mTimelineSemaphores = true;
+    }
+
+    void DeviceCreator::enableHostImport()
+    {
+        mHostImport = true;
+    }
+
+    void DeviceCreator::setHostAllocator(Device::HostAllocatorPtr allocator)
+    {
+        mHostAllocator = std::move(allocator);
+    }
+
     void DeviceCreator::reset()
     {
         mDefineEnabledFeatures = false;
-        mPhysicalDevice = VK_NULL_HANDLE;
+        mTimelineSemaphores = false;
+        mHostImport = false;
+        mPhysicalDevice = PhysicalDevice(VK_NULL_HANDLE);
+        mInstance = VK_NULL_HANDLE;
+        mInstanceApiVersion = VK_API_VERSION_1_0;
+        mInstanceProperties2 = false;
+        mInstanceExternalMemory = false;
         mQueueInfos.clear();
         mQueuePriorities.clear();
         mLayers.clear();
         mExtensions.clear();
+        mHostAllocator.reset();
     }
 
     Device DeviceCreator::create()
     {
-        assert(mPhysicalDevice != VK_NULL_HANDLE);
+        Result<Device> result = tryCreate();
+        if (!result.hasValue())
+            throw Exception("vw::DeviceCreator::create", result.getCode());
+
+        return result.takeValue();
+    }
+
+    Result<Device> DeviceCreator::tryCreate() noexcept
+    {
+        assert(mPhysicalDevice);
         assert(!mQueuePriorities.empty());
 
-        // Create device
-        std::vector<const char*> layers;
-        for (const std::string& layer : mLayers)
-            layers.push_back(layer.c_str());
-
-        std::vector<const char*> extensions;
-        for (const std::string& ext : extensions)
-            extensions.push_back(ext.c_str());
-
-        VkDeviceCreateInfo deviceCInfo;
-        deviceCInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-        deviceCInfo.pNext = nullptr;
-        deviceCInfo.flags = 0;
-        deviceCInfo.queueCreateInfoCount = mQueueInfos.size();
-        deviceCInfo.pQueueCreateInfos = mQueueInfos.data();
-        deviceCInfo.enabledLayerCount = layers.size();
-        deviceCInfo.ppEnabledLayerNames = layers.data();
-        deviceCInfo.enabledExtensionCount = extensions.size();
-        deviceCInfo.ppEnabledExtensionNames = extensions.data();
-        deviceCInfo.pEnabledFeatures = (mDefineEnabledFeatures) ? &mEnabledFeatures : nullptr;
-
-        VkDevice deviceHandle = VK_NULL_HANDLE;
-        VkResult result = vkCreateDevice(mPhysicalDevice, &deviceCInfo, nullptr, &deviceHandle);
-        if (result != VK_SUCCESS)
+        try
         {
-            throw Exception("vw::DeviceCreator::create", result);
+            // Priorities may have moved as queues were added
+            size_t priorityOffset = 0;
+            for (VkDeviceQueueCreateInfo& info : mQueueInfos)
+            {
+                info.pQueuePriorities = &mQueuePriorities[priorityOffset];
+                priorityOffset += info.queueCount;
+            }
+
+            // Create device
+            std::vector<const char*> layers;
+            for (const std::string& layer : mLayers)
+                layers.push_back(layer.c_str());
+
+            std::vector<const char*> extensions;
+            for (const std::string& ext : mExtensions)
+                extensions.push_back(ext.c_str());
+
+            // Core functionality is limited by the older of the instance and
+            // the device
+            uint32_t apiVersion = std::min(mInstanceApiVersion,
+                mPhysicalDevice.getApiVersion());
+
+            // Timeline semaphores are core as of Vulkan 1.2
+            VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures;
+            timelineFeatures.sType =
+                VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+            timelineFeatures.pNext = nullptr;
+            timelineFeatures.timelineSemaphore = VK_TRUE;
+
+            if (mTimelineSemaphores)
+            {
+                if (apiVersion < VK_API_VERSION_1_2)
+                {
+                    if (!mPhysicalDevice.hasExtension(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME))
+                        return VK_ERROR_FEATURE_NOT_PRESENT;
+                    enableExtension(extensions, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+                }
+
+                if (!supportsTimelineSemaphores(apiVersion))
+                    return VK_ERROR_FEATURE_NOT_PRESENT;
+            }
+
+            // Importing host memory needs external memory, core as of Vulkan
+            // 1.1
+            VkDeviceSize hostImportAlignment = 0;
+            if (mHostImport &&
+                mPhysicalDevice.hasExtension(VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME))
+            {
+                bool coreExternalMemory = apiVersion >= VK_API_VERSION_1_1;
+                bool externalMemory = coreExternalMemory || (mInstanceExternalMemory &&
+                    mPhysicalDevice.hasExtension(VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME));
+                if (externalMemory)
+                    hostImportAlignment = getHostImportAlignment(apiVersion);
+
+                if (hostImportAlignment > 0)
+                {
+                    if (!coreExternalMemory)
+                        enableExtension(extensions, VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME);
+                    enableExtension(extensions, VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME);
+                }
+            }
+
+            VkDeviceCreateInfo deviceCInfo;
+            deviceCInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+            deviceCInfo.pNext = (mTimelineSemaphores) ? &timelineFeatures : nullptr;
+            deviceCInfo.flags = 0;
+            deviceCInfo.queueCreateInfoCount = mQueueInfos.size();
+            deviceCInfo.pQueueCreateInfos = mQueueInfos.data();
+            deviceCInfo.enabledLayerCount = layers.size();
+            deviceCInfo.ppEnabledLayerNames = layers.data();
+            deviceCInfo.enabledExtensionCount = extensions.size();
+            deviceCInfo.ppEnabledExtensionNames = extensions.data();
+            deviceCInfo.pEnabledFeatures =
+                (mDefineEnabledFeatures) ? &mEnabledFeatures : nullptr;
+
+            const VkAllocationCallbacks* callbacks =
+                (mHostAllocator) ? mHostAllocator->getCallbacks() : nullptr;
+
+            VkDevice deviceHandle = VK_NULL_HANDLE;
+            VkResult result = vkCreateDevice(mPhysicalDevice.getHandle(), &deviceCInfo,
+                callbacks, &deviceHandle);
+            if (result != VK_SUCCESS)
+                return result;
+
+            // Owns the handle until the Device takes it over
+            DeviceGuard guard(deviceHandle, callbacks);
+
+            // Load device level functions
+            std::unique_ptr<DeviceDispatch> dispatch(new DeviceDispatch(deviceHandle));
+
+            // Retrieve queues
+            Device::QueueList::Container queues;
+            for (const VkDeviceQueueCreateInfo& info : mQueueInfos)
+            {
+                uint32_t family = info.queueFamilyIndex;
+                for (uint32_t index = 0; index < info.queueCount; ++index)
+                {
+
+                    VkQueue queueHandle = VK_NULL_HANDLE;
+                    dispatch->vkGetDeviceQueue(deviceHandle, family, index, &queueHandle);
+                    queues.push_back(Queue(family, index, queueHandle, dispatch.get()));
+                }
+            }
+
+            Device::QueueRoles roles = assignQueueRoles(queues);
+            Device::QueueList queueList(std::move(queues));
+            Device::HostAllocatorPtr hostAllocator(mHostAllocator);
+
+            // The Device destroys the handle itself if its construction fails
+            guard.release();
+            return Result<Device>(Device(deviceHandle, mPhysicalDevice,
+                std::move(dispatch), std::move(queueList), mTimelineSemaphores, roles,
+                std::move(hostAllocator), hostImportAlignment, deviceCInfo.pEnabledFeatures));
+        }
+        catch (const Exception& exception)
+        {
+            return exception.getErrorCode();
+        }
+        catch (...)
+        {
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
         }
+    }
+
+    bool DeviceCreator::supportsTimelineSemaphores(uint32_t apiVersion) const
+    {
+        if (mInstance == VK_NULL_HANDLE)
+            return false;
 
-        // Retrieve queues
-        Device::QueueList::Container queues;
-        for (const VkDeviceQueueCreateInfo& info : mQueueInfos)
+        // Querying extended features is core as of Vulkan 1.1
+        PFN_vkGetPhysicalDeviceFeatures2 getFeatures2 = nullptr;
+        if (apiVersion >= VK_API_VERSION_1_1)
         {
-            uint32_t family = info.queueFamilyIndex;
-            for (uint32_t index = 0; index < info.queueCount; ++index)
-            {
+            getFeatures2 = (PFN_vkGetPhysicalDeviceFeatures2)
+                vkGetInstanceProcAddr(mInstance, "vkGetPhysicalDeviceFeatures2");
+        }
+        if (!getFeatures2 && mInstanceProperties2)
+        {
+            getFeatures2 = (PFN_vkGetPhysicalDeviceFeatures2)
+                vkGetInstanceProcAddr(mInstance, "vkGetPhysicalDeviceFeatures2KHR");
+        }
+        if (!getFeatures2)
+            return false;
+
+        VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures;
+        timelineFeatures.sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+        timelineFeatures.pNext = nullptr;
+        timelineFeatures.timelineSemaphore = VK_FALSE;
+
+        VkPhysicalDeviceFeatures2 features;
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &timelineFeatures;
+        getFeatures2(mPhysicalDevice.getHandle(), &features);
 
-                VkQueue queueHandle = VK_NULL_HANDLE;
-                vkGetDeviceQueue(deviceHandle, family, index, &queueHandle);
-                queues.push_back(Queue(family, index, queueHandle));
+        return timelineFeatures.timelineSemaphore == VK_TRUE;
+    }
+
+    VkDeviceSize DeviceCreator::getHostImportAlignment(uint32_t apiVersion) const
+    {
+        if (mInstance == VK_NULL_HANDLE)
+            return 0;
+
+        // Querying extended properties is core as of Vulkan 1.1
+        PFN_vkGetPhysicalDeviceProperties2 getProperties2 = nullptr;
+        if (apiVersion >= VK_API_VERSION_1_1)
+        {
+            getProperties2 = (PFN_vkGetPhysicalDeviceProperties2)
+                vkGetInstanceProcAddr(mInstance, "vkGetPhysicalDeviceProperties2");
+        }
+        if (!getProperties2 && mInstanceProperties2)
+        {
+            getProperties2 = (PFN_vkGetPhysicalDeviceProperties2)
+                vkGetInstanceProcAddr(mInstance, "vkGetPhysicalDeviceProperties2KHR");
+        }
+        if (!getProperties2)
+            return 0;
+
+        VkPhysicalDeviceExternalMemoryHostPropertiesEXT hostProperties;
+        hostProperties.sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT;
+        hostProperties.pNext = nullptr;
+        hostProperties.minImportedHostPointerAlignment = 0;
+
+        VkPhysicalDeviceProperties2 properties;
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties.pNext = &hostProperties;
+        getProperties2(mPhysicalDevice.getHandle(), &properties);
+
+        return hostProperties.minImportedHostPointerAlignment;
+    }
+
+    Device::QueueRoles DeviceCreator::assignQueueRoles(
+        const Device::QueueList::Container& queues) const
+    {
+        PhysicalDevice::QueueFamilyList families =
+            mPhysicalDevice.getDeviceQueueFamilies();
+
+        Device::QueueRoles roles = Device::QueueRoles();
+        std::vector<bool> used(queues.size(), false);
+
+        // Each role takes the unused queue with the fewest capabilities
+        // beyond what it needs, then falls back to sharing a queue
+        for (size_t role = 0; role < Device::QueueRole_Count; ++role)
+        {
+            size_t bestScore = ~size_t(0);
+            for (size_t i = 0; i < queues.size(); ++i)
+            {
+                const QueueFamily& family = families[queues[i].getFamilyIndex()];
+                bool graphics = family.hasGraphicsSupport();
+                bool compute = family.hasComputeSupport();
+
+                size_t extra = 0;
+                if (role == Device::QueueRole_Graphics)
+                {
+                    if (!graphics)
+                        continue;
+                }
+                else if (role == Device::QueueRole_Compute)
+                {
+                    if (!compute)
+                        continue;
+                    extra = (graphics) ? 1 : 0;
+                }
+                else
+                {
+                    // Graphics and compute queues implicitly support transfers
+                    if (!family.hasTransferSupport() && !graphics && !compute)
+                        continue;
+                    extra = ((graphics) ? 1 : 0) + ((compute) ? 1 : 0);
+                }
+
+                size_t score = extra + ((used[i]) ? Device::QueueRole_Count : 0);
+                if (score < bestScore)
+                {
+                    bestScore = score;
+                    roles[role] = i;
+                }
             }
+
+            if (!queues.empty())
+                used[roles[role]] = true;
         }
 
-        return Device(deviceHandle, Device::QueueList(queues));
+        return roles;
     }
 }
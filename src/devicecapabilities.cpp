@@ -0,0 +1,378 @@
+#include "vw/devicecapabilities.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+#include "vw/exception.h"
+#include "fileutil.h"
+
+namespace vw
+{
+    namespace
+    {
+        const char FileMagic[4] = { 'V', 'W', 'D', 'C' };
+        const uint32_t FileVersion = 1;
+
+        struct FileHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint32_t entryCount;
+
+            // Structures are stored as is, so their sizes must match
+            uint32_t propertiesSize;
+            uint32_t featuresSize;
+            uint32_t memorySize;
+            uint32_t queueFamilySize;
+            uint32_t extensionSize;
+
+            uint64_t dataSize;
+            uint64_t checksum;
+        };
+
+        bool isSameDevice(const VkPhysicalDeviceProperties& a,
+            const VkPhysicalDeviceProperties& b)
+        {
+            return a.vendorID == b.vendorID && a.deviceID == b.deviceID &&
+                a.driverVersion == b.driverVersion && a.apiVersion == b.apiVersion &&
+                std::memcmp(a.pipelineCacheUUID, b.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+        }
+
+        template <typename T>
+        void append(std::vector<char>& data, const T* values, size_t count)
+        {
+            const char* bytes = reinterpret_cast<const char*>(values);
+            data.insert(data.end(), bytes, bytes + sizeof(T) * count);
+        }
+
+        // Reads values sequentially, failing once the data runs out
+        class Reader
+        {
+            public:
+
+                Reader(const char* data, size_t size)
+                    : mData(data)
+                    , mSize(size)
+                    , mOffset(0)
+                {
+                }
+
+                template <typename T>
+                bool read(T* values, size_t count)
+                {
+                    size_t size = sizeof(T) * count;
+                    if (count > mSize || size > mSize - mOffset)
+                        return false;
+
+                    std::memcpy(values, mData + mOffset, size);
+                    mOffset += size;
+                    return true;
+                }
+
+                bool isAtEnd() const { return mOffset == mSize; }
+
+            private:
+
+                const char* mData;
+                size_t mSize;
+                size_t mOffset;
+        };
+    }
+
+    DeviceCapabilities::DeviceCapabilities(VkPhysicalDevice handle)
+        : mHandle(handle)
+    {
+    }
+
+    DeviceCapabilities::DeviceCapabilities(VkPhysicalDevice handle,
+        const DeviceCapabilities& other)
+        : mHandle(handle)
+    {
+        other.populate();
+
+        std::call_once(mPropertiesFlag, [&]() { mProperties = other.mProperties; });
+        std::call_once(mFeaturesFlag, [&]() { mFeatures = other.mFeatures; });
+        std::call_once(mMemoryFlag, [&]() { mMemoryProperties = other.mMemoryProperties; });
+        std::call_once(mQueueFamiliesFlag, [&]() { mQueueFamilies = other.mQueueFamilies; });
+        std::call_once(mExtensionsFlag, [&]() { mExtensions = other.mExtensions; });
+    }
+
+    const VkPhysicalDeviceProperties& DeviceCapabilities::getProperties() const
+    {
+        std::call_once(mPropertiesFlag, [this]()
+        {
+            assert(mHandle != VK_NULL_HANDLE);
+            vkGetPhysicalDeviceProperties(mHandle, &mProperties);
+        });
+
+        return mProperties;
+    }
+
+    const VkPhysicalDeviceFeatures& DeviceCapabilities::getFeatures() const
+    {
+        std::call_once(mFeaturesFlag, [this]()
+        {
+            assert(mHandle != VK_NULL_HANDLE);
+            vkGetPhysicalDeviceFeatures(mHandle, &mFeatures);
+        });
+
+        return mFeatures;
+    }
+
+    const VkPhysicalDeviceMemoryProperties& DeviceCapabilities::getMemoryProperties() const
+    {
+        std::call_once(mMemoryFlag, [this]()
+        {
+            assert(mHandle != VK_NULL_HANDLE);
+            vkGetPhysicalDeviceMemoryProperties(mHandle, &mMemoryProperties);
+        });
+
+        return mMemoryProperties;
+    }
+
+    const DeviceCapabilities::QueueFamilyPropertiesList&
+        DeviceCapabilities::getQueueFamilyProperties() const
+    {
+        std::call_once(mQueueFamiliesFlag, [this]()
+        {
+            assert(mHandle != VK_NULL_HANDLE);
+
+            uint32_t count = 0;
+            vkGetPhysicalDeviceQueueFamilyProperties(mHandle, &count, nullptr);
+            mQueueFamilies.resize(count);
+            vkGetPhysicalDeviceQueueFamilyProperties(mHandle, &count, mQueueFamilies.data());
+            mQueueFamilies.resize(count);
+        });
+
+        return mQueueFamilies;
+    }
+
+    const DeviceCapabilities::ExtensionList& DeviceCapabilities::getExtensions() const
+    {
+        // An exception leaves the flag unset, so a later call retries
+        std::call_once(mExtensionsFlag, [this]()
+        {
+            assert(mHandle != VK_NULL_HANDLE);
+
+            ExtensionList extensions;
+            VkResult result = VK_INCOMPLETE;
+            while (result == VK_INCOMPLETE)
+            {
+                uint32_t count = 0;
+                result = vkEnumerateDeviceExtensionProperties(mHandle, nullptr, &count, nullptr);
+                if (result != VK_SUCCESS)
+                    throw Exception("vw::DeviceCapabilities::getExtensions", result);
+
+                extensions.resize(count);
+                result = vkEnumerateDeviceExtensionProperties(mHandle, nullptr, &count,
+                    extensions.data());
+                if (result != VK_SUCCESS && result != VK_INCOMPLETE)
+                    throw Exception("vw::DeviceCapabilities::getExtensions", result);
+                extensions.resize(count);
+            }
+
+            mExtensions.swap(extensions);
+        });
+
+        return mExtensions;
+    }
+
+    bool DeviceCapabilities::hasExtension(const std::string& name) const
+    {
+        for (const VkExtensionProperties& extension : getExtensions())
+        {
+            if (name == extension.extensionName)
+                return true;
+        }
+
+        return false;
+    }
+
+    void DeviceCapabilities::populate() const
+    {
+        getProperties();
+        getFeatures();
+        getMemoryProperties();
+        getQueueFamilyProperties();
+        getExtensions();
+    }
+
+    VkPhysicalDevice DeviceCapabilities::getHandle() const
+    {
+        return mHandle;
+    }
+
+    CapabilityCache::CapabilityCache()
+        : mDirty(false)
+    {
+    }
+
+    bool CapabilityCache::load(const std::string& path)
+    {
+        std::vector<char> file;
+        std::FILE* stream = std::fopen(path.c_str(), "rb");
+        if (stream)
+        {
+            char buffer[4096];
+            size_t count = 0;
+            while ((count = std::fread(buffer, 1, sizeof(buffer), stream)) > 0)
+                file.insert(file.end(), buffer, buffer + count);
+            std::fclose(stream);
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mEntries.clear();
+        mDirty = false;
+
+        FileHeader header;
+        if (file.size() < sizeof(FileHeader))
+            return false;
+        std::memcpy(&header, file.data(), sizeof(FileHeader));
+
+        const char* data = file.data() + sizeof(FileHeader);
+        size_t size = file.size() - sizeof(FileHeader);
+        if (std::memcmp(header.magic, FileMagic, sizeof(FileMagic)) != 0 ||
+            header.version != FileVersion ||
+            header.propertiesSize != sizeof(VkPhysicalDeviceProperties) ||
+            header.featuresSize != sizeof(VkPhysicalDeviceFeatures) ||
+            header.memorySize != sizeof(VkPhysicalDeviceMemoryProperties) ||
+            header.queueFamilySize != sizeof(VkQueueFamilyProperties) ||
+            header.extensionSize != sizeof(VkExtensionProperties) ||
+            header.dataSize != size || header.checksum != computeChecksum(data, size))
+        {
+            return false;
+        }
+
+        Reader reader(data, size);
+        std::vector<CapabilitiesPtr> entries;
+        for (uint32_t i = 0; i < header.entryCount; ++i)
+        {
+            std::shared_ptr<DeviceCapabilities> entry(new DeviceCapabilities(VK_NULL_HANDLE));
+
+            VkPhysicalDeviceProperties properties;
+            VkPhysicalDeviceFeatures features;
+            VkPhysicalDeviceMemoryProperties memoryProperties;
+            uint32_t familyCount = 0;
+            uint32_t extensionCount = 0;
+            if (!reader.read(&properties, 1) || !reader.read(&features, 1) ||
+                !reader.read(&memoryProperties, 1) || !reader.read(&familyCount, 1))
+            {
+                return false;
+            }
+
+            DeviceCapabilities::QueueFamilyPropertiesList families(familyCount);
+            if (!reader.read(families.data(), familyCount) || !reader.read(&extensionCount, 1))
+                return false;
+
+            DeviceCapabilities::ExtensionList extensions(extensionCount);
+            if (!reader.read(extensions.data(), extensionCount))
+                return false;
+
+            // Names are stored as is, so make sure they are terminated
+            for (VkExtensionProperties& extension : extensions)
+                extension.extensionName[VK_MAX_EXTENSION_NAME_SIZE - 1] = '\0';
+
+            std::call_once(entry->mPropertiesFlag, [&]() { entry->mProperties = properties; });
+            std::call_once(entry->mFeaturesFlag, [&]() { entry->mFeatures = features; });
+            std::call_once(entry->mMemoryFlag,
+                [&]() { entry->mMemoryProperties = memoryProperties; });
+            std::call_once(entry->mQueueFamiliesFlag,
+                [&]() { entry->mQueueFamilies.swap(families); });
+            std::call_once(entry->mExtensionsFlag,
+                [&]() { entry->mExtensions.swap(extensions); });
+            entries.push_back(entry);
+        }
+
+        if (!reader.isAtEnd())
+            return false;
+
+        mEntries.swap(entries);
+        return true;
+    }
+
+    bool CapabilityCache::save(const std::string& path) const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        std::vector<char> data(sizeof(FileHeader));
+        for (const CapabilitiesPtr& entry : mEntries)
+        {
+            entry->populate();
+
+            uint32_t familyCount = static_cast<uint32_t>(entry->mQueueFamilies.size());
+            uint32_t extensionCount = static_cast<uint32_t>(entry->mExtensions.size());
+
+            append(data, &entry->mProperties, 1);
+            append(data, &entry->mFeatures, 1);
+            append(data, &entry->mMemoryProperties, 1);
+            append(data, &familyCount, 1);
+            append(data, entry->mQueueFamilies.data(), familyCount);
+            append(data, &extensionCount, 1);
+            append(data, entry->mExtensions.data(), extensionCount);
+        }
+
+        FileHeader header;
+        std::memcpy(header.magic, FileMagic, sizeof(FileMagic));
+        header.version = FileVersion;
+        header.entryCount = static_cast<uint32_t>(mEntries.size());
+        header.propertiesSize = sizeof(VkPhysicalDeviceProperties);
+        header.featuresSize = sizeof(VkPhysicalDeviceFeatures);
+        header.memorySize = sizeof(VkPhysicalDeviceMemoryProperties);
+        header.queueFamilySize = sizeof(VkQueueFamilyProperties);
+        header.extensionSize = sizeof(VkExtensionProperties);
+        header.dataSize = data.size() - sizeof(FileHeader);
+        header.checksum = computeChecksum(data.data() + sizeof(FileHeader), header.dataSize);
+        std::memcpy(data.data(), &header, sizeof(FileHeader));
+
+        if (!writeFileAtomically(path, data.data(), data.size()))
+            return false;
+
+        mDirty = false;
+        return true;
+    }
+
+    CapabilityCache::CapabilitiesPtr CapabilityCache::find(VkPhysicalDevice handle,
+        const VkPhysicalDeviceProperties& properties) const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        for (const CapabilitiesPtr& entry : mEntries)
+        {
+            if (isSameDevice(entry->getProperties(), properties))
+                return CapabilitiesPtr(new DeviceCapabilities(handle, *entry));
+        }
+
+        return nullptr;
+    }
+
+    void CapabilityCache::add(CapabilitiesPtr capabilities)
+    {
+        assert(capabilities);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        const VkPhysicalDeviceProperties& properties = capabilities->getProperties();
+        for (CapabilitiesPtr& entry : mEntries)
+        {
+            if (isSameDevice(entry->getProperties(), properties))
+            {
+                if (entry != capabilities)
+                {
+                    entry = capabilities;
+                    mDirty = true;
+                }
+                return;
+            }
+        }
+
+        mEntries.push_back(capabilities);
+        mDirty = true;
+    }
+
+    bool CapabilityCache::isDirty() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mDirty;
+    }
+}
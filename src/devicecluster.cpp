@@ -0,0 +1,456 @@
+#include "vw/devicecluster.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "vw/instance.h"
+#include "vw/queuefamily.h"
+
+namespace vw
+{
+    namespace
+    {
+        using DeviceGroups = std::vector<std::vector<VkPhysicalDevice>>;
+
+        DeviceGroups enumerateDeviceGroups(Instance& instance)
+        {
+            // The core entry point may only be used by instances created for
+            // Vulkan 1.1, older ones need VK_KHR_device_group_creation
+            const char* name = nullptr;
+            if (instance.getApiVersion() >= VK_API_VERSION_1_1)
+                name = "vkEnumeratePhysicalDeviceGroups";
+            else if (instance.hasExtension(VK_KHR_DEVICE_GROUP_CREATION_EXTENSION_NAME))
+                name = "vkEnumeratePhysicalDeviceGroupsKHR";
+            else
+                return DeviceGroups();
+
+            PFN_vkEnumeratePhysicalDeviceGroups enumerate =
+                (PFN_vkEnumeratePhysicalDeviceGroups) vkGetInstanceProcAddr(
+                    instance.getHandle(), name);
+            if (!enumerate)
+                return DeviceGroups();
+
+            std::vector<VkPhysicalDeviceGroupProperties> properties;
+            VkResult result = VK_INCOMPLETE;
+            while (result == VK_INCOMPLETE)
+            {
+                uint32_t count = 0;
+                result = enumerate(instance.getHandle(), &count, nullptr);
+                if (result != VK_SUCCESS)
+                    return DeviceGroups();
+
+                VkPhysicalDeviceGroupProperties empty;
+                empty.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GROUP_PROPERTIES;
+                empty.pNext = nullptr;
+                properties.assign(count, empty);
+
+                result = enumerate(instance.getHandle(), &count, properties.data());
+                if (result != VK_SUCCESS && result != VK_INCOMPLETE)
+                    return DeviceGroups();
+
+                properties.resize(count);
+            }
+
+            DeviceGroups groups;
+            for (const VkPhysicalDeviceGroupProperties& group : properties)
+            {
+                groups.push_back(std::vector<VkPhysicalDevice>(group.physicalDevices,
+                    group.physicalDevices + group.physicalDeviceCount));
+            }
+
+            return groups;
+        }
+
+        Device createDevice(Instance& instance, const PhysicalDevice& physicalDevice)
+        {
+            DeviceCreator creator;
+            creator.setInstance(instance);
+            creator.setPhysicalDevice(physicalDevice);
+
+            // Compute only devices have no graphics family to plan around
+            if (!creator.planQueues())
+            {
+                for (const QueueFamily& family : physicalDevice.getDeviceQueueFamilies())
+                {
+                    if (family.hasComputeSupport())
+                    {
+                        creator.addQueues(family, DeviceCreator::PriorityList(1, 1.0f));
+                        break;
+                    }
+                }
+            }
+
+            creator.enableTimelineSemaphores();
+            return creator.create();
+        }
+    }
+
+    DeviceCluster::Settings::Settings()
+        : tasksInFlight(2)
+        , smoothing(0.25)
+    {
+    }
+
+    DeviceCluster::DeviceCluster(Instance& instance,
+        const std::vector<PhysicalDevice>& physicalDevices, const Settings& settings)
+        : mSettings(settings)
+        , mPending(0)
+        , mGeneration(0)
+        , mStopping(false)
+    {
+        assert(instance);
+        assert(!physicalDevices.empty());
+        assert(mSettings.tasksInFlight > 0);
+        assert(mSettings.smoothing > 0.0 && mSettings.smoothing <= 1.0);
+
+        DeviceGroups groups = enumerateDeviceGroups(instance);
+        std::vector<int> groupIndices(groups.size(), -1);
+        uint32_t groupCount = 0;
+
+        for (const PhysicalDevice& physicalDevice : physicalDevices)
+        {
+            std::unique_ptr<Member> member(new Member);
+            member->device = createDevice(instance, physicalDevice);
+            member->context.reset(new ComputeContext(member->device, mSettings.compute));
+            member->queuedCost = 0.0;
+            member->throughput = 0.0;
+            member->statistics = Statistics();
+
+            // Devices of a group share its index, the others get their own
+            member->group = groupCount;
+            for (size_t i = 0; i < groups.size(); ++i)
+            {
+                const std::vector<VkPhysicalDevice>& group = groups[i];
+                if (group.size() > 1 &&
+                    std::find(group.begin(), group.end(), physicalDevice.getHandle()) != group.end())
+                {
+                    if (groupIndices[i] < 0)
+                        groupIndices[i] = static_cast<int>(groupCount++);
+                    member->group = static_cast<uint32_t>(groupIndices[i]);
+                    break;
+                }
+            }
+
+            if (member->group == groupCount)
+                ++groupCount;
+
+            mMembers.push_back(std::move(member));
+        }
+
+        try
+        {
+            for (uint32_t index = 0; index < mMembers.size(); ++index)
+                mMembers[index]->thread = std::thread(&DeviceCluster::run, this, index);
+        }
+        catch (...)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mStopping = true;
+            }
+
+            mWork.notify_all();
+            for (std::unique_ptr<Member>& member : mMembers)
+            {
+                if (member->thread.joinable())
+                    member->thread.join();
+            }
+
+            throw;
+        }
+    }
+
+    DeviceCluster::~DeviceCluster()
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mIdle.wait(lock, [this]() { return mPending == 0; });
+            mStopping = true;
+        }
+
+        mWork.notify_all();
+        for (std::unique_ptr<Member>& member : mMembers)
+            member->thread.join();
+    }
+
+    void DeviceCluster::submit(Task task, double cost)
+    {
+        assert(task);
+        assert(cost > 0.0);
+
+        double fallback = getFallbackThroughput();
+
+        Member* target = nullptr;
+        double best = 0.0;
+        for (const std::unique_ptr<Member>& member : mMembers)
+        {
+            std::lock_guard<std::mutex> lock(member->mutex);
+            double time = getExpectedTime(*member, cost, fallback);
+            if (!target || time < best)
+            {
+                target = member.get();
+                best = time;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            ++mPending;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(target->mutex);
+            Queued queued;
+            queued.task = std::move(task);
+            queued.cost = cost;
+            target->tasks.push_back(std::move(queued));
+            target->queuedCost += cost;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            ++mGeneration;
+        }
+
+        mWork.notify_all();
+    }
+
+    void DeviceCluster::waitIdle()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mIdle.wait(lock, [this]() { return mPending == 0; });
+
+        if (mError)
+        {
+            std::exception_ptr error = mError;
+            mError = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    uint32_t DeviceCluster::getDeviceCount() const
+    {
+        return static_cast<uint32_t>(mMembers.size());
+    }
+
+    Device& DeviceCluster::getDevice(uint32_t device)
+    {
+        assert(device < mMembers.size());
+        return mMembers[device]->device;
+    }
+
+    ComputeContext& DeviceCluster::getComputeContext(uint32_t device)
+    {
+        assert(device < mMembers.size());
+        return *mMembers[device]->context;
+    }
+
+    uint32_t DeviceCluster::getGroup(uint32_t device) const
+    {
+        assert(device < mMembers.size());
+        return mMembers[device]->group;
+    }
+
+    DeviceCluster::Statistics DeviceCluster::getStatistics(uint32_t device) const
+    {
+        assert(device < mMembers.size());
+
+        const Member& member = *mMembers[device];
+        std::lock_guard<std::mutex> lock(member.mutex);
+        Statistics statistics = member.statistics;
+        statistics.throughput = member.throughput;
+        return statistics;
+    }
+
+    void DeviceCluster::run(uint32_t index)
+    {
+        Member& member = *mMembers[index];
+        std::deque<Submitted> submitted;
+
+        for (;;)
+        {
+            while (!submitted.empty() && member.context->isComplete(submitted.front().ticket))
+            {
+                complete(member, submitted.front());
+                submitted.pop_front();
+            }
+
+            uint64_t generation;
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                generation = mGeneration;
+            }
+
+            Queued queued;
+            if (submitted.size() < mSettings.tasksInFlight &&
+                (take(index, queued) || steal(index, queued)))
+            {
+                Submitted entry;
+                entry.cost = queued.cost;
+                entry.start = Clock::now();
+
+                try
+                {
+                    entry.ticket = queued.task(*member.context, index);
+                    member.context->flush();
+                    submitted.push_back(entry);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    if (!mError)
+                        mError = std::current_exception();
+                    if (--mPending == 0)
+                        mIdle.notify_all();
+                }
+
+                continue;
+            }
+
+            // Nothing to start, so wait for the device instead
+            if (!submitted.empty())
+            {
+                try
+                {
+                    member.context->wait(submitted.front().ticket);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    if (!mError)
+                        mError = std::current_exception();
+                }
+
+                complete(member, submitted.front());
+                submitted.pop_front();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mMutex);
+            if (mStopping)
+                return;
+
+            mWork.wait(lock, [this, generation]()
+            {
+                return mStopping || mGeneration != generation;
+            });
+        }
+    }
+
+    bool DeviceCluster::take(uint32_t index, Queued& queued)
+    {
+        Member& member = *mMembers[index];
+        std::lock_guard<std::mutex> lock(member.mutex);
+        if (member.tasks.empty())
+            return false;
+
+        queued = std::move(member.tasks.front());
+        member.tasks.pop_front();
+        member.queuedCost -= queued.cost;
+        return true;
+    }
+
+    bool DeviceCluster::steal(uint32_t index, Queued& queued)
+    {
+        Member& thief = *mMembers[index];
+        double fallback = getFallbackThroughput();
+
+        // Take from the device furthest behind, preferring the thief's group
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            bool sameGroup = (pass == 0);
+
+            Member* victim = nullptr;
+            double longest = 0.0;
+            for (uint32_t other = 0; other < mMembers.size(); ++other)
+            {
+                Member& member = *mMembers[other];
+                if (other == index || (member.group == thief.group) != sameGroup)
+                    continue;
+
+                std::lock_guard<std::mutex> lock(member.mutex);
+                if (member.tasks.empty())
+                    continue;
+
+                double time = getExpectedTime(member, 0.0, fallback);
+                if (!victim || time > longest)
+                {
+                    victim = &member;
+                    longest = time;
+                }
+            }
+
+            if (!victim)
+                continue;
+
+            {
+                std::lock_guard<std::mutex> lock(victim->mutex);
+                if (victim->tasks.empty())
+                    continue;
+
+                queued = std::move(victim->tasks.back());
+                victim->tasks.pop_back();
+                victim->queuedCost -= queued.cost;
+            }
+
+            std::lock_guard<std::mutex> lock(thief.mutex);
+            ++thief.statistics.stolenCount;
+            return true;
+        }
+
+        return false;
+    }
+
+    void DeviceCluster::complete(Member& member, const Submitted& submitted)
+    {
+        // Tasks in flight overlap, so each is only charged for the time since
+        // the one before it completed
+        Clock::time_point now = Clock::now();
+        {
+            std::lock_guard<std::mutex> lock(member.mutex);
+            Clock::time_point start = std::max(submitted.start, member.lastCompletion);
+            double seconds = std::chrono::duration<double>(now - start).count();
+            member.lastCompletion = now;
+
+            if (seconds > 0.0)
+            {
+                double sample = submitted.cost / seconds;
+                member.throughput = (member.throughput > 0.0) ?
+                    member.throughput + mSettings.smoothing * (sample - member.throughput) :
+                    sample;
+            }
+
+            ++member.statistics.taskCount;
+            member.statistics.cost += submitted.cost;
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (--mPending == 0)
+            mIdle.notify_all();
+    }
+
+    double DeviceCluster::getFallbackThroughput() const
+    {
+        // Devices yet to complete a task are assumed as fast as the average
+        double known = 0.0;
+        uint32_t knownCount = 0;
+        for (const std::unique_ptr<Member>& member : mMembers)
+        {
+            std::lock_guard<std::mutex> lock(member->mutex);
+            if (member->throughput > 0.0)
+            {
+                known += member->throughput;
+                ++knownCount;
+            }
+        }
+
+        return (knownCount > 0) ? known / knownCount : 1.0;
+    }
+
+    double DeviceCluster::getExpectedTime(const Member& member, double cost,
+        double fallback) const
+    {
+        double throughput = (member.throughput > 0.0) ? member.throughput : fallback;
+        return (member.queuedCost + cost) / throughput;
+    }
+}
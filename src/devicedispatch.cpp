@@ -0,0 +1,39 @@
+#include "vw/devicedispatch.h"
+
+#include <cassert>
+
+namespace vw
+{
+    DeviceDispatch::DeviceDispatch()
+    {
+#define VW_CLEAR_DEVICE_FUNCTION(name) name = nullptr;
+#define VW_CLEAR_PROMOTED_FUNCTION(name, suffix) name = nullptr;
+        VW_DEVICE_FUNCTIONS(VW_CLEAR_DEVICE_FUNCTION)
+        VW_DEVICE_FUNCTIONS_PROMOTED(VW_CLEAR_PROMOTED_FUNCTION)
+        VW_DEVICE_FUNCTIONS_EXTENSION(VW_CLEAR_DEVICE_FUNCTION)
+#undef VW_CLEAR_PROMOTED_FUNCTION
+#undef VW_CLEAR_DEVICE_FUNCTION
+    }
+
+    DeviceDispatch::DeviceDispatch(VkDevice device)
+    {
+        load(device);
+    }
+
+    void DeviceDispatch::load(VkDevice device)
+    {
+        assert(device != VK_NULL_HANDLE);
+
+#define VW_LOAD_DEVICE_FUNCTION(name) \
+        name = (PFN_##name) vkGetDeviceProcAddr(device, #name);
+#define VW_LOAD_PROMOTED_FUNCTION(name, suffix) \
+        name = (PFN_##name) vkGetDeviceProcAddr(device, #name); \
+        if (!name) \
+            name = (PFN_##name) vkGetDeviceProcAddr(device, #name #suffix);
+        VW_DEVICE_FUNCTIONS(VW_LOAD_DEVICE_FUNCTION)
+        VW_DEVICE_FUNCTIONS_PROMOTED(VW_LOAD_PROMOTED_FUNCTION)
+        VW_DEVICE_FUNCTIONS_EXTENSION(VW_LOAD_DEVICE_FUNCTION)
+#undef VW_LOAD_PROMOTED_FUNCTION
+#undef VW_LOAD_DEVICE_FUNCTION
+    }
+}
@@ -1,75 +1,85 @@
 #include "vw/exception.h"
 
-#include <sstream>
+#include <cstring>
+#include <memory>
+
+#include "vw/result.h"
 
 namespace vw
 {
+    Exception::Exception(const char* location, VkResult result)
+        : mErrorCode(result)
+        , mErrorMsg(nullptr)
+    {
+        setLocation(location);
+    }
+
     Exception::Exception(const std::string& location, VkResult result)
         : mErrorCode(result)
+        , mErrorMsg(nullptr)
     {
-        setup(location, getVulkanResultString(result));
+        setLocation(location.c_str());
     }
 
-    VkResult Exception::getErrorCode() const
+    Exception::Exception(const Exception& other)
+        : mErrorCode(other.mErrorCode)
+        , mErrorMsg(nullptr)
     {
-        return mErrorCode;
+        setLocation(other.mLocation);
     }
 
-    const std::string& Exception::getErrorMessage() const
+    Exception::~Exception()
     {
-        return mErrorMsg;
+        delete mErrorMsg.load(std::memory_order_acquire);
     }
 
-    void Exception::setup(const std::string& location, const std::string& msg)
+    Exception& Exception::operator=(const Exception& other)
     {
-        std::stringstream ss;
-        ss << "Unhandled event at " << location << ". " << msg;
-        mErrorMsg = ss.str();
+        if (this != &other)
+        {
+            setLocation(other.mLocation);
+            mErrorCode = other.mErrorCode;
+            delete mErrorMsg.exchange(nullptr, std::memory_order_acq_rel);
+        }
+
+        return *this;
     }
 
-    std::string Exception::getVulkanResultString(VkResult result) const
+    VkResult Exception::getErrorCode() const
     {
-        switch (result)
+        return mErrorCode;
+    }
+
+    const char* Exception::getLocation() const
+    {
+        return mLocation;
+    }
+
+    const std::string& Exception::getErrorMessage() const
+    {
+        // Formatted on first use, since most exceptions are handled by code.
+        // Threads racing to format it keep whichever copy was published first.
+        std::string* message = mErrorMsg.load(std::memory_order_acquire);
+        if (message)
+            return *message;
+
+        std::unique_ptr<std::string> formatted(new std::string("Unhandled event at "));
+        *formatted += mLocation;
+        *formatted += ". ";
+        *formatted += getResultString(mErrorCode);
+
+        if (mErrorMsg.compare_exchange_strong(message, formatted.get(),
+            std::memory_order_acq_rel, std::memory_order_acquire))
         {
-            case VK_SUCCESS:
-                return "Vulkan command completed successfully.";
-            case VK_NOT_READY:
-                return "Vulkan fence or query not ready.";
-            case VK_TIMEOUT:
-                return "Vulkan operation timed out.";
-            case VK_EVENT_SET:
-                return "Vulkan event is signaled.";
-            case VK_EVENT_RESET:
-                return "Vulkan event is unsignaled.";
-            case VK_INCOMPLETE:
-                return "Vulkan return array is too small for the result.";
-            case VK_ERROR_OUT_OF_HOST_MEMORY:
-                return "Vulkan host failed to allocate memory.";
-            case VK_ERROR_OUT_OF_DEVICE_MEMORY:
-                return "Vulkan device failed to allocate memory.";
-            case VK_ERROR_INITIALIZATION_FAILED:
-                return "Vulkan failed to create object.";
-            case VK_ERROR_DEVICE_LOST:
-                return "Vulkan physical or logical device lost.";
-            case VK_ERROR_MEMORY_MAP_FAILED:
-                return "Vulkan mapping of memory object failed.";
-            case VK_ERROR_LAYER_NOT_PRESENT:
-                return "Vulkan layer that was requested not present.";
-            case VK_ERROR_EXTENSION_NOT_PRESENT:
-                return "Vulkan extension that was requested not present.";
-            case VK_ERROR_FEATURE_NOT_PRESENT:
-                return "Vulkan feature that was requested not supported.";
-            case VK_ERROR_INCOMPATIBLE_DRIVER:
-                return "Vulkan api compatible with requested version not available.";
-            case VK_ERROR_TOO_MANY_OBJECTS:
-                return "Vulkan exceeded maximum number of allowed objects for type.";
-            case VK_ERROR_FORMAT_NOT_SUPPORTED:
-                return "Vulkan format that was requested not supported by device.";
-            case VK_ERROR_FRAGMENTED_POOL:
-                return "Vulkan pool allocation failed due to memory fragmentation.";
-            default:
-                return "Vulkan unhandled error code.";
+            return *formatted.release();
         }
+
+        return *message;
     }
-}
 
+    void Exception::setLocation(const char* location)
+    {
+        std::strncpy(mLocation, location, LocationSize - 1);
+        mLocation[LocationSize - 1] = '\0';
+    }
+}
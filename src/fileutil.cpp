@@ -0,0 +1,74 @@
+#include "fileutil.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace vw
+{
+    uint64_t computeChecksum(const char* data, size_t size)
+    {
+        // FNV-1a
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+    bool writeFileAtomically(const std::string& path, const char* data, size_t size)
+    {
+        // A unique name keeps concurrent writers from truncating each other's
+        // file, and the same directory keeps the rename on one file system
+        std::string pattern = path + ".XXXXXX";
+        std::vector<char> tempPath(pattern.begin(), pattern.end());
+        tempPath.push_back('\0');
+
+        int fd = mkstemp(tempPath.data());
+        if (fd < 0)
+            return false;
+
+        // mkstemp only lets the owner read the file
+        bool success = fchmod(fd, 0644) == 0;
+
+        size_t written = 0;
+        while (success && written < size)
+        {
+            ssize_t count = ::write(fd, data + written, size - written);
+            if (count < 0 && errno == EINTR)
+                continue;
+            if (count < 0)
+                break;
+            written += static_cast<size_t>(count);
+        }
+
+        success = success && written == size && fsync(fd) == 0;
+        success = close(fd) == 0 && success;
+        if (!success || std::rename(tempPath.data(), path.c_str()) != 0)
+        {
+            unlink(tempPath.data());
+            return false;
+        }
+
+        // The rename is only durable once the directory is synced too
+        size_t slash = path.rfind('/');
+        std::string directory = (slash == std::string::npos) ? "." :
+            (slash == 0) ? "/" : path.substr(0, slash);
+
+        int directoryFd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+        if (directoryFd < 0)
+            return false;
+
+        success = fsync(directoryFd) == 0;
+        close(directoryFd);
+        return success;
+    }
+}
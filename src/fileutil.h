@@ -0,0 +1,22 @@
+#ifndef VW_FILEUTIL_H
+#define VW_FILEUTIL_H
+
+#include <vw/common.h>
+#include <string>
+
+namespace vw
+{
+    /*! @brief Returns the FNV-1a hash of the data, stored in files to detect
+     *      ones that were corrupted or cut short.
+     */
+    uint64_t computeChecksum(const char* data, size_t size);
+
+    /*! @brief Writes the data to a new file in the directory of the path and
+     *      renames it over the path, so readers see either the old contents
+     *      or the new ones in full, even after a crash.
+     *  @return False if the data could not be written durably.
+     */
+    bool writeFileAtomically(const std::string& path, const char* data, size_t size);
+}
+
+#endif
@@ -0,0 +1,236 @@
+#include "vw/gpuprofiler.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "vw/device.h"
+#include "vw/devicedispatch.h"
+#include "vw/exception.h"
+#include "vw/queuefamily.h"
+
+namespace vw
+{
+    const GpuProfiler::Token GpuProfiler::InvalidToken;
+    const size_t GpuProfiler::Histogram::BucketCount;
+
+    namespace
+    {
+        size_t getBucket(double ns)
+        {
+            // Bucket i > 0 holds [2^(i-1), 2^i) microseconds
+            uint64_t us = static_cast<uint64_t>(ns / 1000.0);
+            size_t bucket = 0;
+            while (us > 0 && bucket + 1 < GpuProfiler::Histogram::BucketCount)
+            {
+                us >>= 1;
+                ++bucket;
+            }
+
+            return bucket;
+        }
+    }
+
+    GpuProfiler::GpuProfiler(Device& device, const QueueFamily& family,
+        uint32_t framesInFlight, uint32_t maxScopesPerFrame)
+        : mDevice(device)
+        , mPool(VK_NULL_HANDLE)
+        , mMaxScopes(maxScopesPerFrame)
+        , mMask(0)
+        , mPeriod(mDevice.getPhysicalDevice().getDeviceLimits().timestampPeriod)
+        , mFrameIndex(0)
+    {
+        assert(mDevice);
+        assert(framesInFlight > 0 && mMaxScopes > 0);
+
+        size_t validBits = family.getTimeStampPrecision();
+        if (validBits == 0)
+            return;
+
+        mMask = (validBits >= 64) ? ~0ull : (1ull << validBits) - 1;
+
+        // Each scope takes a begin and an end query
+        uint32_t queriesPerFrame = mMaxScopes * 2;
+
+        VkQueryPoolCreateInfo cinfo;
+        cinfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        cinfo.pNext = nullptr;
+        cinfo.flags = 0;
+        cinfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        cinfo.queryCount = queriesPerFrame * framesInFlight;
+        cinfo.pipelineStatistics = 0;
+
+        VkResult result = mDevice.getDispatch().vkCreateQueryPool(mDevice.getHandle(),
+            &cinfo, mDevice.getAllocationCallbacks(), &mPool);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::GpuProfiler::GpuProfiler", result);
+
+        for (uint32_t i = 0; i < framesInFlight; ++i)
+        {
+            std::unique_ptr<Frame> frame(new Frame());
+            frame->firstQuery = i * queriesPerFrame;
+            frame->scopeCount.store(0, std::memory_order_relaxed);
+            frame->scopes.reset(new ScopeId[mMaxScopes]);
+            mFrames.push_back(std::move(frame));
+        }
+
+        // Each query yields its value and its availability
+        mResults.resize(queriesPerFrame * 2);
+    }
+
+    GpuProfiler::~GpuProfiler()
+    {
+        if (mPool != VK_NULL_HANDLE)
+            mDevice.getDispatch().vkDestroyQueryPool(mDevice.getHandle(),
+                mPool, mDevice.getAllocationCallbacks());
+    }
+
+    GpuProfiler::ScopeId GpuProfiler::getScope(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(mScopeMutex);
+
+        auto it = mScopeIds.find(name);
+        if (it != mScopeIds.end())
+            return it->second;
+
+        ScopeId id = static_cast<ScopeId>(mScopeNames.size());
+        mScopeIds[name] = id;
+        mScopeNames.push_back(name);
+
+        Histogram histogram;
+        histogram.count = 0;
+        histogram.minNs = 0.0;
+        histogram.maxNs = 0.0;
+        histogram.totalNs = 0.0;
+        histogram.buckets.fill(0);
+        mHistograms.push_back(histogram);
+
+        return id;
+    }
+
+    void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer)
+    {
+        if (!isEnabled())
+            return;
+
+        ++mFrameIndex;
+        Frame& frame = *mFrames[mFrameIndex % mFrames.size()];
+
+        // The device finished this segment framesInFlight frames ago
+        if (frame.scopeCount.load(std::memory_order_relaxed) > 0)
+            resolve(frame);
+
+        mDevice.getDispatch().vkCmdResetQueryPool(commandBuffer, mPool,
+            frame.firstQuery, mMaxScopes * 2);
+        frame.scopeCount.store(0, std::memory_order_release);
+    }
+
+    GpuProfiler::Token GpuProfiler::beginScope(VkCommandBuffer commandBuffer,
+        ScopeId scope, VkPipelineStageFlagBits stage)
+    {
+        if (!isEnabled())
+            return InvalidToken;
+
+        assert(mFrameIndex > 0 && "beginFrame must be called first");
+
+        Frame& frame = *mFrames[mFrameIndex % mFrames.size()];
+        uint32_t index = frame.scopeCount.fetch_add(1, std::memory_order_acq_rel);
+        if (index >= mMaxScopes)
+            return InvalidToken;
+
+        frame.scopes[index] = scope;
+
+        Token token = frame.firstQuery + index * 2;
+        mDevice.getDispatch().vkCmdWriteTimestamp(commandBuffer, stage, mPool, token);
+        return token;
+    }
+
+    void GpuProfiler::endScope(VkCommandBuffer commandBuffer, Token token,
+        VkPipelineStageFlagBits stage)
+    {
+        if (token == InvalidToken)
+            return;
+
+        mDevice.getDispatch().vkCmdWriteTimestamp(commandBuffer, stage, mPool, token + 1);
+    }
+
+    std::vector<GpuProfiler::ScopeStatistics> GpuProfiler::getStatistics() const
+    {
+        std::lock_guard<std::mutex> lock(mScopeMutex);
+
+        std::vector<ScopeStatistics> statistics;
+        for (size_t i = 0; i < mHistograms.size(); ++i)
+        {
+            if (mHistograms[i].count == 0)
+                continue;
+
+            ScopeStatistics stats;
+            stats.name = mScopeNames[i];
+            stats.histogram = mHistograms[i];
+            statistics.push_back(stats);
+        }
+
+        return statistics;
+    }
+
+    void GpuProfiler::clearStatistics()
+    {
+        std::lock_guard<std::mutex> lock(mScopeMutex);
+
+        for (Histogram& histogram : mHistograms)
+        {
+            histogram.count = 0;
+            histogram.minNs = 0.0;
+            histogram.maxNs = 0.0;
+            histogram.totalNs = 0.0;
+            histogram.buckets.fill(0);
+        }
+    }
+
+    bool GpuProfiler::isEnabled() const
+    {
+        return mPool != VK_NULL_HANDLE;
+    }
+
+    void GpuProfiler::resolve(Frame& frame)
+    {
+        uint32_t scopeCount = std::min(frame.scopeCount.load(std::memory_order_acquire),
+            mMaxScopes);
+
+        // Never wait. Queries that are unavailable, such as those of a scope
+        // that was not ended, are skipped.
+        VkResult result = mDevice.getDispatch().vkGetQueryPoolResults(
+            mDevice.getHandle(), mPool, frame.firstQuery, scopeCount * 2,
+            mResults.size() * sizeof(uint64_t), mResults.data(), 2 * sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if (result != VK_SUCCESS && result != VK_NOT_READY)
+            throw Exception("vw::GpuProfiler::beginFrame", result);
+
+        std::lock_guard<std::mutex> lock(mScopeMutex);
+        for (uint32_t i = 0; i < scopeCount; ++i)
+        {
+            const uint64_t* begin = &mResults[i * 4];
+            const uint64_t* end = &mResults[i * 4 + 2];
+            if (begin[1] == 0 || end[1] == 0)
+                continue;
+
+            // Masking the difference also handles the counter wrapping
+            uint64_t ticks = (end[0] - begin[0]) & mMask;
+            record(frame.scopes[i], ticks * mPeriod);
+        }
+    }
+
+    void GpuProfiler::record(ScopeId scope, double ns)
+    {
+        assert(scope < mHistograms.size());
+
+        Histogram& histogram = mHistograms[scope];
+        if (histogram.count == 0 || ns < histogram.minNs)
+            histogram.minNs = ns;
+        if (histogram.count == 0 || ns > histogram.maxNs)
+            histogram.maxNs = ns;
+
+        ++histogram.count;
+        histogram.totalNs += ns;
+        ++histogram.buckets[getBucket(ns)];
+    }
+}
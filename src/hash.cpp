@@ -0,0 +1,39 @@
+#include "hash.h"
+
+#include <cstring>
+
+namespace vw
+{
+    namespace
+    {
+        uint64_t rotate(uint64_t value, unsigned bits)
+        {
+            return (value << bits) | (value >> (64 - bits));
+        }
+    }
+
+    void hashWords(const uint32_t* words, size_t wordCount, uint64_t& low, uint64_t& high)
+    {
+        uint64_t lanes[4] = { wordCount, HashPrime, ~HashPrime, rotate(HashPrime, 32) };
+
+        size_t i = 0;
+        for (; i + 8 <= wordCount; i += 8)
+        {
+            for (size_t lane = 0; lane < 4; ++lane)
+            {
+                uint64_t pair;
+                std::memcpy(&pair, words + i + lane * 2, sizeof(pair));
+                lanes[lane] = mixHash(lanes[lane] ^ pair);
+            }
+        }
+
+        for (size_t lane = 0; i < wordCount; ++i, lane = (lane + 1) % 4)
+            lanes[lane] = mixHash(lanes[lane] ^ words[i]);
+
+        // Each half folds the lanes in a different order
+        low = mixHash(lanes[0] ^ rotate(lanes[1], 17) ^ rotate(lanes[2], 31) ^
+            rotate(lanes[3], 47));
+        high = mixHash(lanes[3] ^ rotate(lanes[2], 13) ^ rotate(lanes[1], 29) ^
+            rotate(lanes[0], 43) ^ low);
+    }
+}
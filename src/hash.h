@@ -0,0 +1,29 @@
+#ifndef VW_HASH_H
+#define VW_HASH_H
+
+#include <vw/common.h>
+
+namespace vw
+{
+    /*! @brief The odd constant hashes are seeded and multiplied with.
+     */
+    const uint64_t HashPrime = 0x9e3779b97f4a7c15ull;
+
+    /*! @brief Spreads every bit of the value over the whole result.
+     */
+    inline uint64_t mixHash(uint64_t value)
+    {
+        value ^= value >> 31;
+        value *= HashPrime;
+        value ^= value >> 29;
+        return value;
+    }
+
+    /*! @brief Returns a 128-bit hash of the words, split into two halves. The
+     *      words are hashed eight at a time in four independent lanes, which
+     *      keeps the multiplies pipelined.
+     */
+    void hashWords(const uint32_t* words, size_t wordCount, uint64_t& low, uint64_t& high);
+}
+
+#endif
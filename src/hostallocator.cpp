@@ -0,0 +1,489 @@
+#include "vw/hostallocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace vw
+{
+    const size_t HostAllocator::ScopeCount;
+    const size_t HostAllocator::BlockAlignment;
+    const size_t PoolHostAllocator::MaxPooledSize;
+    const size_t ArenaHostAllocator::ArenaCount;
+    const size_t ArenaHostAllocator::MaxIdleChunks;
+
+    namespace
+    {
+        // Sits right in front of every allocation. Its size is a multiple of
+        // the block alignment, so it never adds padding of its own.
+        struct alignas(std::max_align_t) Header
+        {
+            void* block;
+            size_t blockSize;
+            size_t size;
+            VkSystemAllocationScope scope;
+        };
+
+        // Slabs are carved into blocks of a single size class
+        const size_t SlabSize = 64 * 1024;
+        const size_t MinClassSize = 16;
+
+        // Caches take this many bytes of blocks from the depot at once, and
+        // give half back when they hold twice as much
+        const size_t BatchBytes = 16 * 1024;
+        const size_t MinBatchCount = 4;
+
+        Header* getHeader(void* memory)
+        {
+            return reinterpret_cast<Header*>(memory) - 1;
+        }
+
+        size_t getBatchCount(size_t classSize)
+        {
+            return std::max(MinBatchCount, BatchBytes / classSize);
+        }
+
+        size_t getThreadIndex()
+        {
+            // Threads are spread over the caches in the order they first
+            // allocate
+            static std::atomic<size_t> nextIndex(0);
+            thread_local size_t index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+            return index;
+        }
+    }
+
+    HostAllocator::HostAllocator()
+    {
+        mCallbacks.pUserData = this;
+        mCallbacks.pfnAllocation = allocateCallback;
+        mCallbacks.pfnReallocation = reallocateCallback;
+        mCallbacks.pfnFree = freeCallback;
+        mCallbacks.pfnInternalAllocation = internalAllocationCallback;
+        mCallbacks.pfnInternalFree = internalFreeCallback;
+
+        for (Counters& counters : mCounters)
+        {
+            counters.bytes.store(0, std::memory_order_relaxed);
+            counters.allocations.store(0, std::memory_order_relaxed);
+            counters.totalAllocations.store(0, std::memory_order_relaxed);
+            counters.internalBytes.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    HostAllocator::~HostAllocator()
+    {
+    }
+
+    const VkAllocationCallbacks* HostAllocator::getCallbacks() const
+    {
+        return &mCallbacks;
+    }
+
+    HostAllocator::Statistics HostAllocator::getStatistics(VkSystemAllocationScope scope) const
+    {
+        assert(static_cast<size_t>(scope) < ScopeCount);
+
+        const Counters& counters = mCounters[scope];
+        Statistics statistics;
+        statistics.bytes = counters.bytes.load(std::memory_order_relaxed);
+        statistics.allocations = counters.allocations.load(std::memory_order_relaxed);
+        statistics.totalAllocations = counters.totalAllocations.load(std::memory_order_relaxed);
+        statistics.internalBytes = counters.internalBytes.load(std::memory_order_relaxed);
+        return statistics;
+    }
+
+    HostAllocator::Statistics HostAllocator::getTotalStatistics() const
+    {
+        Statistics total = {};
+        for (size_t scope = 0; scope < ScopeCount; ++scope)
+        {
+            Statistics statistics = getStatistics(static_cast<VkSystemAllocationScope>(scope));
+            total.bytes += statistics.bytes;
+            total.allocations += statistics.allocations;
+            total.totalAllocations += statistics.totalAllocations;
+            total.internalBytes += statistics.internalBytes;
+        }
+
+        return total;
+    }
+
+    void* HostAllocator::allocate(size_t size, size_t alignment, VkSystemAllocationScope scope)
+    {
+        assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+        assert(static_cast<size_t>(scope) < ScopeCount);
+
+        if (size == 0)
+            return nullptr;
+
+        // Blocks are already aligned enough for the header, so only larger
+        // alignments need room to shift the allocation
+        alignment = std::max(alignment, alignof(Header));
+        size_t padding = (alignment > BlockAlignment) ? alignment - BlockAlignment : 0;
+        if (size > std::numeric_limits<size_t>::max() - sizeof(Header) - padding)
+            return nullptr;
+
+        size_t blockSize = sizeof(Header) + padding + size;
+        void* block = allocateBlock(blockSize, scope);
+        if (!block)
+            return nullptr;
+
+        uintptr_t address = reinterpret_cast<uintptr_t>(block) + sizeof(Header);
+        address = (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+        void* memory = reinterpret_cast<void*>(address);
+
+        Header* header = getHeader(memory);
+        header->block = block;
+        header->blockSize = blockSize;
+        header->size = size;
+        header->scope = scope;
+
+        Counters& counters = mCounters[scope];
+        counters.bytes.fetch_add(size, std::memory_order_relaxed);
+        counters.allocations.fetch_add(1, std::memory_order_relaxed);
+        counters.totalAllocations.fetch_add(1, std::memory_order_relaxed);
+        return memory;
+    }
+
+    void* HostAllocator::reallocate(void* memory, size_t size, size_t alignment,
+        VkSystemAllocationScope scope)
+    {
+        if (!memory)
+            return allocate(size, alignment, scope);
+
+        if (size == 0)
+        {
+            free(memory);
+            return nullptr;
+        }
+
+        // Grow or shrink in place when the block has room. Blocks are taken
+        // back by the scope they were allocated with, so it can't change.
+        Header* header = getHeader(memory);
+        size_t offset = static_cast<char*>(memory) - static_cast<char*>(header->block);
+        bool aligned = (reinterpret_cast<uintptr_t>(memory) & (alignment - 1)) == 0;
+        if (aligned && scope == header->scope && size <= header->blockSize - offset)
+        {
+            Counters& counters = mCounters[scope];
+            counters.bytes.fetch_add(size, std::memory_order_relaxed);
+            counters.bytes.fetch_sub(header->size, std::memory_order_relaxed);
+
+            header->size = size;
+            return memory;
+        }
+
+        void* moved = allocate(size, alignment, scope);
+        if (!moved)
+            return nullptr;
+
+        std::memcpy(moved, memory, std::min(size, header->size));
+        free(memory);
+        return moved;
+    }
+
+    void HostAllocator::free(void* memory)
+    {
+        if (!memory)
+            return;
+
+        Header* header = getHeader(memory);
+        Counters& counters = mCounters[header->scope];
+        counters.bytes.fetch_sub(header->size, std::memory_order_relaxed);
+        counters.allocations.fetch_sub(1, std::memory_order_relaxed);
+
+        freeBlock(header->block, header->blockSize, header->scope);
+    }
+
+    VKAPI_ATTR void* VKAPI_CALL HostAllocator::allocateCallback(void* userData,
+        size_t size, size_t alignment, VkSystemAllocationScope scope)
+    {
+        return static_cast<HostAllocator*>(userData)->allocate(size, alignment, scope);
+    }
+
+    VKAPI_ATTR void* VKAPI_CALL HostAllocator::reallocateCallback(void* userData,
+        void* original, size_t size, size_t alignment, VkSystemAllocationScope scope)
+    {
+        return static_cast<HostAllocator*>(userData)->reallocate(original, size,
+            alignment, scope);
+    }
+
+    VKAPI_ATTR void VKAPI_CALL HostAllocator::freeCallback(void* userData, void* memory)
+    {
+        static_cast<HostAllocator*>(userData)->free(memory);
+    }
+
+    VKAPI_ATTR void VKAPI_CALL HostAllocator::internalAllocationCallback(void* userData,
+        size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope)
+    {
+        HostAllocator* allocator = static_cast<HostAllocator*>(userData);
+        allocator->mCounters[scope].internalBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    VKAPI_ATTR void VKAPI_CALL HostAllocator::internalFreeCallback(void* userData,
+        size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope)
+    {
+        HostAllocator* allocator = static_cast<HostAllocator*>(userData);
+        allocator->mCounters[scope].internalBytes.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    PoolHostAllocator::FreeList::FreeList()
+        : head(nullptr)
+        , count(0)
+    {
+    }
+
+    void PoolHostAllocator::FreeList::push(FreeBlock* block)
+    {
+        block->next = head;
+        head = block;
+        ++count;
+    }
+
+    PoolHostAllocator::FreeBlock* PoolHostAllocator::FreeList::pop()
+    {
+        FreeBlock* block = head;
+        if (block)
+        {
+            head = block->next;
+            --count;
+        }
+
+        return block;
+    }
+
+    PoolHostAllocator::PoolHostAllocator()
+    {
+        static_assert(MinClassSize << (ClassCount - 1) == MaxPooledSize,
+            "The largest size class must match MaxPooledSize");
+        static_assert(MinClassSize % BlockAlignment == 0,
+            "Size classes must keep blocks aligned");
+    }
+
+    PoolHostAllocator::~PoolHostAllocator()
+    {
+        // Pooled blocks live in the slabs, wherever they were cached
+        for (void* slab : mSlabs)
+            std::free(slab);
+    }
+
+    void* PoolHostAllocator::allocateBlock(size_t size, VkSystemAllocationScope scope)
+    {
+        if (size > MaxPooledSize)
+            return std::malloc(size);
+
+        size_t sizeClass = getClass(size);
+        Cache& cache = mCaches[getThreadIndex() % CacheCount];
+
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        FreeList& list = cache.lists[sizeClass];
+        if (!list.head)
+            refill(list, sizeClass);
+
+        return list.pop();
+    }
+
+    void PoolHostAllocator::freeBlock(void* block, size_t size, VkSystemAllocationScope scope)
+    {
+        if (size > MaxPooledSize)
+        {
+            std::free(block);
+            return;
+        }
+
+        // Blocks go to the freeing thread's cache, whoever allocated them
+        size_t sizeClass = getClass(size);
+        Cache& cache = mCaches[getThreadIndex() % CacheCount];
+
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        FreeList& list = cache.lists[sizeClass];
+        list.push(static_cast<FreeBlock*>(block));
+        if (list.count > 2 * getBatchCount(getClassSize(sizeClass)))
+            drain(list, sizeClass);
+    }
+
+    size_t PoolHostAllocator::getClass(size_t size)
+    {
+        assert(size <= MaxPooledSize);
+
+        size_t sizeClass = 0;
+        while (getClassSize(sizeClass) < size)
+            ++sizeClass;
+
+        return sizeClass;
+    }
+
+    size_t PoolHostAllocator::getClassSize(size_t sizeClass)
+    {
+        return MinClassSize << sizeClass;
+    }
+
+    void PoolHostAllocator::refill(FreeList& list, size_t sizeClass)
+    {
+        size_t classSize = getClassSize(sizeClass);
+        size_t batchCount = getBatchCount(classSize);
+
+        std::lock_guard<std::mutex> lock(mDepotMutex);
+        FreeList& depot = mDepot[sizeClass];
+        if (depot.count < batchCount)
+        {
+            char* slab = static_cast<char*>(std::malloc(SlabSize));
+            if (slab)
+            {
+                try
+                {
+                    mSlabs.push_back(slab);
+                }
+                catch (...)
+                {
+                    std::free(slab);
+                    slab = nullptr;
+                }
+            }
+
+            // Hand out what is left when the slab can't be had
+            if (slab)
+            {
+                for (size_t offset = SlabSize; offset >= classSize; offset -= classSize)
+                    depot.push(reinterpret_cast<FreeBlock*>(slab + offset - classSize));
+            }
+        }
+
+        for (size_t i = 0; i < batchCount && depot.head; ++i)
+            list.push(depot.pop());
+    }
+
+    void PoolHostAllocator::drain(FreeList& list, size_t sizeClass)
+    {
+        std::lock_guard<std::mutex> lock(mDepotMutex);
+        FreeList& depot = mDepot[sizeClass];
+
+        size_t keep = list.count / 2;
+        while (list.count > keep)
+            depot.push(list.pop());
+    }
+
+    ArenaHostAllocator::Arena::Arena()
+        : currentChunk(0)
+        , offset(0)
+        , liveBlocks(0)
+    {
+    }
+
+    ArenaHostAllocator::ArenaHostAllocator(size_t chunkSize)
+        : mChunkSize(chunkSize)
+        , mResetCount(0)
+    {
+        assert(chunkSize > 0);
+    }
+
+    ArenaHostAllocator::~ArenaHostAllocator()
+    {
+        for (Arena& arena : mArenas)
+        {
+            assert(arena.liveBlocks == 0);
+
+            for (Chunk& chunk : arena.chunks)
+                std::free(chunk.data);
+        }
+    }
+
+    uint64_t ArenaHostAllocator::getResetCount() const
+    {
+        return mResetCount.load(std::memory_order_relaxed);
+    }
+
+    void* ArenaHostAllocator::allocateBlock(size_t size, VkSystemAllocationScope scope)
+    {
+        if (scope != VK_SYSTEM_ALLOCATION_SCOPE_COMMAND)
+            return PoolHostAllocator::allocateBlock(size, scope);
+
+        // Blocks may be freed from another thread, so each starts with the
+        // index of its arena. Keep the next block aligned.
+        if (size > std::numeric_limits<size_t>::max() - 2 * BlockAlignment)
+            return nullptr;
+        size = (size + BlockAlignment + BlockAlignment - 1) & ~(BlockAlignment - 1);
+
+        size_t index = getThreadIndex() % ArenaCount;
+        Arena& arena = mArenas[index];
+
+        std::lock_guard<std::mutex> lock(arena.mutex);
+        if (arena.currentChunk >= arena.chunks.size() ||
+            arena.offset + size > arena.chunks[arena.currentChunk].size)
+        {
+            // Move on to the next chunk large enough, skipping the ones that
+            // are not until the arena is rewound
+            size_t next = (arena.currentChunk < arena.chunks.size()) ?
+                arena.currentChunk + 1 : arena.chunks.size();
+            while (next < arena.chunks.size() && arena.chunks[next].size < size)
+                ++next;
+
+            if (next == arena.chunks.size())
+            {
+                Chunk chunk;
+                chunk.size = std::max(mChunkSize, size);
+                chunk.data = static_cast<char*>(std::malloc(chunk.size));
+                if (!chunk.data)
+                    return nullptr;
+
+                try
+                {
+                    arena.chunks.push_back(chunk);
+                }
+                catch (...)
+                {
+                    std::free(chunk.data);
+                    return nullptr;
+                }
+            }
+
+            arena.currentChunk = next;
+            arena.offset = 0;
+        }
+
+        char* block = arena.chunks[arena.currentChunk].data + arena.offset;
+        arena.offset += size;
+        ++arena.liveBlocks;
+
+        *reinterpret_cast<size_t*>(block) = index;
+        return block + BlockAlignment;
+    }
+
+    void ArenaHostAllocator::freeBlock(void* block, size_t size, VkSystemAllocationScope scope)
+    {
+        if (scope != VK_SYSTEM_ALLOCATION_SCOPE_COMMAND)
+        {
+            PoolHostAllocator::freeBlock(block, size, scope);
+            return;
+        }
+
+        size_t index = *reinterpret_cast<size_t*>(static_cast<char*>(block) - BlockAlignment);
+        assert(index < ArenaCount);
+        Arena& arena = mArenas[index];
+
+        std::lock_guard<std::mutex> lock(arena.mutex);
+        assert(arena.liveBlocks > 0);
+        if (--arena.liveBlocks == 0)
+            rewind(arena);
+    }
+
+    void ArenaHostAllocator::rewind(Arena& arena)
+    {
+        // Chunks made for a single large allocation and the ones beyond the
+        // first few are released
+        size_t kept = 0;
+        for (Chunk& chunk : arena.chunks)
+        {
+            if (kept < MaxIdleChunks && chunk.size == mChunkSize)
+                arena.chunks[kept++] = chunk;
+            else
+                std::free(chunk.data);
+        }
+
+        arena.chunks.resize(kept);
+        arena.currentChunk = 0;
+        arena.offset = 0;
+        mResetCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,237 @@
+#include "vw/hostimport.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "vw/devicedispatch.h"
+#include "vw/exception.h"
+
+namespace vw
+{
+    namespace
+    {
+        VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    }
+
+    HostImport::Region::Region()
+        : mBuffer(VK_NULL_HANDLE)
+        , mOffset(0)
+        , mSize(0)
+        , mMemory(VK_NULL_HANDLE)
+    {
+    }
+
+    HostImport::Region::operator bool() const
+    {
+        return mBuffer != VK_NULL_HANDLE;
+    }
+
+    VkBuffer HostImport::Region::getBuffer() const
+    {
+        return mBuffer;
+    }
+
+    VkDeviceSize HostImport::Region::getOffset() const
+    {
+        return mOffset;
+    }
+
+    VkDeviceSize HostImport::Region::getSize() const
+    {
+        return mSize;
+    }
+
+    bool HostImport::Region::isImported() const
+    {
+        return mMemory != VK_NULL_HANDLE;
+    }
+
+    HostImport::HostImport(VkDevice device, const DeviceDispatch& dispatch,
+        MemoryAllocator& allocator, VkDeviceSize alignment,
+        const VkAllocationCallbacks* callbacks)
+        : mDevice(device)
+        , mDispatch(dispatch)
+        , mAllocator(allocator)
+        , mCallbacks(callbacks)
+        , mAlignment((dispatch.vkGetMemoryHostPointerPropertiesEXT) ? alignment : 0)
+        , mRegionCount(0)
+    {
+    }
+
+    HostImport::~HostImport()
+    {
+        assert(mRegionCount.load() == 0);
+    }
+
+    bool HostImport::isSupported() const
+    {
+        return mAlignment != 0;
+    }
+
+    VkDeviceSize HostImport::getAlignment() const
+    {
+        return mAlignment;
+    }
+
+    HostImport::Region HostImport::import(const void* data, VkDeviceSize size,
+        VkBufferUsageFlags usage)
+    {
+        assert(data && size > 0);
+
+        Region region;
+        if (!tryImport(data, size, usage, region))
+            copy(data, size, usage, region);
+
+        mRegionCount.fetch_add(1, std::memory_order_relaxed);
+        return region;
+    }
+
+    void HostImport::release(Region& region)
+    {
+        assert(region);
+
+        mDispatch.vkDestroyBuffer(mDevice, region.mBuffer, mCallbacks);
+        if (region.mMemory)
+            mDispatch.vkFreeMemory(mDevice, region.mMemory, mCallbacks);
+        else
+            mAllocator.free(region.mAllocation);
+
+        region = Region();
+        mRegionCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    size_t HostImport::getRegionCount() const
+    {
+        return mRegionCount.load(std::memory_order_relaxed);
+    }
+
+    VkBuffer HostImport::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
+        bool external)
+    {
+        VkExternalMemoryBufferCreateInfo externalInfo;
+        externalInfo.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO;
+        externalInfo.pNext = nullptr;
+        externalInfo.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+
+        VkBufferCreateInfo cinfo;
+        cinfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        cinfo.pNext = (external) ? &externalInfo : nullptr;
+        cinfo.flags = 0;
+        cinfo.size = size;
+        cinfo.usage = usage;
+        cinfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        cinfo.queueFamilyIndexCount = 0;
+        cinfo.pQueueFamilyIndices = nullptr;
+
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkResult result = mDispatch.vkCreateBuffer(mDevice, &cinfo, mCallbacks, &buffer);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::HostImport::import", result);
+
+        return buffer;
+    }
+
+    bool HostImport::tryImport(const void* data, VkDeviceSize size,
+        VkBufferUsageFlags usage, Region& region)
+    {
+        if (!isSupported())
+            return false;
+
+        // Import whole aligned pages and point the region at the data in them
+        uintptr_t address = reinterpret_cast<uintptr_t>(data);
+        uintptr_t begin = address / mAlignment * mAlignment;
+        VkDeviceSize importSize = alignUp(address + size, mAlignment) - begin;
+        void* pointer = reinterpret_cast<void*>(begin);
+
+        VkMemoryHostPointerPropertiesEXT pointerProperties;
+        pointerProperties.sType = VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT;
+        pointerProperties.pNext = nullptr;
+        pointerProperties.memoryTypeBits = 0;
+
+        VkResult result = mDispatch.vkGetMemoryHostPointerPropertiesEXT(mDevice,
+            VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT, pointer,
+            &pointerProperties);
+        if (result != VK_SUCCESS)
+            return false;
+
+        VkBuffer buffer = createBuffer(importSize, usage, true);
+
+        VkMemoryRequirements requirements;
+        mDispatch.vkGetBufferMemoryRequirements(mDevice, buffer, &requirements);
+
+        uint32_t typeBits = requirements.memoryTypeBits & pointerProperties.memoryTypeBits;
+        if (typeBits == 0 || requirements.size > importSize)
+        {
+            mDispatch.vkDestroyBuffer(mDevice, buffer, mCallbacks);
+            return false;
+        }
+
+        uint32_t memoryType = 0;
+        while (!(typeBits & (1u << memoryType)))
+            ++memoryType;
+
+        VkImportMemoryHostPointerInfoEXT importInfo;
+        importInfo.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT;
+        importInfo.pNext = nullptr;
+        importInfo.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+        importInfo.pHostPointer = pointer;
+
+        VkMemoryAllocateInfo allocInfo;
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.pNext = &importInfo;
+        allocInfo.allocationSize = importSize;
+        allocInfo.memoryTypeIndex = memoryType;
+
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        result = mDispatch.vkAllocateMemory(mDevice, &allocInfo, mCallbacks, &memory);
+        if (result == VK_SUCCESS)
+        {
+            result = mDispatch.vkBindBufferMemory(mDevice, buffer, memory, 0);
+            if (result != VK_SUCCESS)
+                mDispatch.vkFreeMemory(mDevice, memory, mCallbacks);
+        }
+
+        // Some drivers refuse read-only or file backed pages, which copying
+        // still handles
+        if (result != VK_SUCCESS)
+        {
+            mDispatch.vkDestroyBuffer(mDevice, buffer, mCallbacks);
+            return false;
+        }
+
+        region.mBuffer = buffer;
+        region.mOffset = address - begin;
+        region.mSize = size;
+        region.mMemory = memory;
+        return true;
+    }
+
+    void HostImport::copy(const void* data, VkDeviceSize size,
+        VkBufferUsageFlags usage, Region& region)
+    {
+        VkBuffer buffer = createBuffer(size, usage, false);
+
+        Allocation allocation;
+        try
+        {
+            allocation = mAllocator.allocateForBuffer(buffer,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        }
+        catch (...)
+        {
+            mDispatch.vkDestroyBuffer(mDevice, buffer, mCallbacks);
+            throw;
+        }
+
+        std::memcpy(allocation.getMappedData(), data, static_cast<size_t>(size));
+        mAllocator.flush(allocation);
+
+        region.mBuffer = buffer;
+        region.mOffset = 0;
+        region.mSize = size;
+        region.mAllocation = allocation;
+    }
+}
@@ -0,0 +1,337 @@
+#include "vw/imagecopyplanner.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "vw/queuefamily.h"
+
+namespace vw
+{
+    namespace
+    {
+        // A box of cells, with exclusive ends
+        struct CellBox
+        {
+            uint32_t x0, x1;
+            uint32_t y0, y1;
+            uint32_t z0, z1;
+        };
+
+        uint32_t divideUp(uint32_t value, uint32_t divisor)
+        {
+            return (value + divisor - 1) / divisor;
+        }
+
+        VkDeviceSize leastCommonMultiple(VkDeviceSize a, VkDeviceSize b)
+        {
+            VkDeviceSize x = a;
+            VkDeviceSize y = b;
+            while (y != 0)
+            {
+                VkDeviceSize t = x % y;
+                x = y;
+                y = t;
+            }
+
+            return a / x * b;
+        }
+
+        void clip(int32_t offset, uint32_t extent, uint32_t size,
+            uint32_t& begin, uint32_t& end)
+        {
+            int64_t first = std::max<int64_t>(offset, 0);
+            int64_t last = std::min<int64_t>(static_cast<int64_t>(offset) + extent, size);
+            begin = static_cast<uint32_t>(first);
+            end = static_cast<uint32_t>(std::max(first, last));
+        }
+    }
+
+    ImageCopyPlanner::ImageCopyPlanner(VkExtent3D granularity, VkExtent3D levelExtent,
+        uint32_t blockSize, VkExtent3D blockExtent)
+        : mLevelExtent(levelExtent)
+        , mBlockExtent(blockExtent)
+        , mBlockSize(blockSize)
+        , mOffsetAlignment(leastCommonMultiple(4, blockSize))
+        , mEmpty(true)
+    {
+        assert(mLevelExtent.width > 0 && mLevelExtent.height > 0 && mLevelExtent.depth > 0);
+        assert(mBlockExtent.width > 0 && mBlockExtent.height > 0 && mBlockExtent.depth > 0);
+        assert(mBlockSize > 0);
+
+        // The granularity is in blocks, and (0,0,0) means whole levels only
+        if (granularity.width == 0 || granularity.height == 0 || granularity.depth == 0)
+        {
+            mCellExtent = mLevelExtent;
+        }
+        else
+        {
+            mCellExtent.width = granularity.width * mBlockExtent.width;
+            mCellExtent.height = granularity.height * mBlockExtent.height;
+            mCellExtent.depth = granularity.depth * mBlockExtent.depth;
+        }
+
+        mGridExtent.width = divideUp(mLevelExtent.width, mCellExtent.width);
+        mGridExtent.height = divideUp(mLevelExtent.height, mCellExtent.height);
+        mGridExtent.depth = divideUp(mLevelExtent.depth, mCellExtent.depth);
+
+        mCells.resize(static_cast<size_t>(mGridExtent.width) * mGridExtent.height *
+            mGridExtent.depth, 0);
+    }
+
+    ImageCopyPlanner::ImageCopyPlanner(const QueueFamily& family, VkExtent3D levelExtent,
+        uint32_t blockSize, VkExtent3D blockExtent)
+        : ImageCopyPlanner(family.getMinImageTransferGranularity(), levelExtent,
+            blockSize, blockExtent)
+    {
+    }
+
+    void ImageCopyPlanner::addDirty(const Box& box)
+    {
+        uint32_t x0, x1, y0, y1, z0, z1;
+        clip(box.offset.x, box.extent.width, mLevelExtent.width, x0, x1);
+        clip(box.offset.y, box.extent.height, mLevelExtent.height, y0, y1);
+        clip(box.offset.z, box.extent.depth, mLevelExtent.depth, z0, z1);
+        if (x0 == x1 || y0 == y1 || z0 == z1)
+            return;
+
+        // Mark every cell the box touches
+        x0 /= mCellExtent.width;
+        y0 /= mCellExtent.height;
+        z0 /= mCellExtent.depth;
+        x1 = divideUp(x1, mCellExtent.width);
+        y1 = divideUp(y1, mCellExtent.height);
+        z1 = divideUp(z1, mCellExtent.depth);
+
+        for (uint32_t z = z0; z < z1; ++z)
+        {
+            for (uint32_t y = y0; y < y1; ++y)
+            {
+                size_t row = (static_cast<size_t>(z) * mGridExtent.height + y) *
+                    mGridExtent.width;
+                std::fill(mCells.begin() + row + x0, mCells.begin() + row + x1, 1);
+            }
+        }
+
+        mEmpty = false;
+    }
+
+    void ImageCopyPlanner::clear()
+    {
+        std::fill(mCells.begin(), mCells.end(), 0);
+        mEmpty = true;
+    }
+
+    bool ImageCopyPlanner::isEmpty() const
+    {
+        return mEmpty;
+    }
+
+    std::vector<ImageCopyPlanner::Box> ImageCopyPlanner::getRegions() const
+    {
+        if (mEmpty)
+            return std::vector<Box>();
+
+        std::vector<CellBox> boxes;
+
+        // Boxes still growing along z, from the previous slice
+        std::vector<CellBox> openSlices;
+
+        for (uint32_t z = 0; z < mGridExtent.depth; ++z)
+        {
+            std::vector<CellBox> sliceBoxes;
+
+            // Boxes still growing along y, sorted by x0
+            std::vector<CellBox> openRows;
+
+            for (uint32_t y = 0; y < mGridExtent.height; ++y)
+            {
+                const uint8_t* row = &mCells[(static_cast<size_t>(z) * mGridExtent.height + y) *
+                    mGridExtent.width];
+
+                std::vector<CellBox> nextRows;
+                size_t open = 0;
+
+                uint32_t x = 0;
+                while (x < mGridExtent.width)
+                {
+                    if (row[x] == 0)
+                    {
+                        ++x;
+                        continue;
+                    }
+
+                    uint32_t start = x;
+                    while (x < mGridExtent.width && row[x] != 0)
+                        ++x;
+
+                    // A run extends the box above it only if it spans the
+                    // same cells
+                    while (open < openRows.size() && openRows[open].x0 < start)
+                        sliceBoxes.push_back(openRows[open++]);
+
+                    if (open < openRows.size() && openRows[open].x0 == start &&
+                        openRows[open].x1 == x)
+                    {
+                        CellBox box = openRows[open++];
+                        box.y1 = y + 1;
+                        nextRows.push_back(box);
+                    }
+                    else
+                    {
+                        CellBox box = { start, x, y, y + 1, z, z + 1 };
+                        nextRows.push_back(box);
+                    }
+                }
+
+                sliceBoxes.insert(sliceBoxes.end(), openRows.begin() + open, openRows.end());
+                openRows.swap(nextRows);
+            }
+
+            sliceBoxes.insert(sliceBoxes.end(), openRows.begin(), openRows.end());
+
+            // A box extends the one in the previous slice only if it covers
+            // the same cells
+            std::vector<CellBox> nextSlices;
+            std::vector<bool> extended(openSlices.size(), false);
+            for (CellBox box : sliceBoxes)
+            {
+                for (size_t i = 0; i < openSlices.size(); ++i)
+                {
+                    const CellBox& previous = openSlices[i];
+                    if (!extended[i] && previous.x0 == box.x0 && previous.x1 == box.x1 &&
+                        previous.y0 == box.y0 && previous.y1 == box.y1)
+                    {
+                        box.z0 = previous.z0;
+                        extended[i] = true;
+                        break;
+                    }
+                }
+
+                nextSlices.push_back(box);
+            }
+
+            for (size_t i = 0; i < openSlices.size(); ++i)
+            {
+                if (!extended[i])
+                    boxes.push_back(openSlices[i]);
+            }
+
+            openSlices.swap(nextSlices);
+        }
+
+        boxes.insert(boxes.end(), openSlices.begin(), openSlices.end());
+
+        // Copies in memory order read the packed data front to back
+        std::sort(boxes.begin(), boxes.end(), [](const CellBox& a, const CellBox& b)
+        {
+            if (a.z0 != b.z0)
+                return a.z0 < b.z0;
+            if (a.y0 != b.y0)
+                return a.y0 < b.y0;
+            return a.x0 < b.x0;
+        });
+
+        // Boxes start on cell boundaries and end on one or on the level's edge
+        std::vector<Box> regions;
+        regions.reserve(boxes.size());
+        for (const CellBox& box : boxes)
+        {
+            uint32_t x = box.x0 * mCellExtent.width;
+            uint32_t y = box.y0 * mCellExtent.height;
+            uint32_t z = box.z0 * mCellExtent.depth;
+
+            Box region;
+            region.offset.x = static_cast<int32_t>(x);
+            region.offset.y = static_cast<int32_t>(y);
+            region.offset.z = static_cast<int32_t>(z);
+            region.extent.width = std::min(box.x1 * mCellExtent.width, mLevelExtent.width) - x;
+            region.extent.height = std::min(box.y1 * mCellExtent.height, mLevelExtent.height) - y;
+            region.extent.depth = std::min(box.z1 * mCellExtent.depth, mLevelExtent.depth) - z;
+            regions.push_back(region);
+        }
+
+        return regions;
+    }
+
+    VkDeviceSize ImageCopyPlanner::getPackedSize() const
+    {
+        VkDeviceSize size = 0;
+        for (const Box& region : getRegions())
+            size = alignOffset(size) + getRegionSize(region);
+
+        return size;
+    }
+
+    VkDeviceSize ImageCopyPlanner::getOffsetAlignment() const
+    {
+        return mOffsetAlignment;
+    }
+
+    std::vector<VkBufferImageCopy> ImageCopyPlanner::pack(const void* src,
+        size_t rowPitch, size_t slicePitch, const VkImageSubresourceLayers& subresource,
+        void* dst) const
+    {
+        assert(src != nullptr && dst != nullptr);
+
+        const uint8_t* source = static_cast<const uint8_t*>(src);
+        uint8_t* destination = static_cast<uint8_t*>(dst);
+
+        std::vector<VkBufferImageCopy> copies;
+        VkDeviceSize offset = 0;
+        for (const Box& region : getRegions())
+        {
+            offset = alignOffset(offset);
+
+            uint32_t blocksWide = divideUp(region.extent.width, mBlockExtent.width);
+            uint32_t blocksHigh = divideUp(region.extent.height, mBlockExtent.height);
+            uint32_t blocksDeep = divideUp(region.extent.depth, mBlockExtent.depth);
+            size_t rowSize = static_cast<size_t>(blocksWide) * mBlockSize;
+
+            size_t x = region.offset.x / mBlockExtent.width;
+            size_t y = region.offset.y / mBlockExtent.height;
+            size_t z = region.offset.z / mBlockExtent.depth;
+
+            // Rows are packed tightly, so the copy leaves the row length and
+            // image height at 0
+            uint8_t* out = destination + offset;
+            for (uint32_t k = 0; k < blocksDeep; ++k)
+            {
+                for (uint32_t j = 0; j < blocksHigh; ++j)
+                {
+                    const uint8_t* in = source + (z + k) * slicePitch + (y + j) * rowPitch +
+                        x * mBlockSize;
+                    std::memcpy(out, in, rowSize);
+                    out += rowSize;
+                }
+            }
+
+            VkBufferImageCopy copy;
+            copy.bufferOffset = offset;
+            copy.bufferRowLength = 0;
+            copy.bufferImageHeight = 0;
+            copy.imageSubresource = subresource;
+            copy.imageOffset = region.offset;
+            copy.imageExtent = region.extent;
+            copies.push_back(copy);
+
+            offset += getRegionSize(region);
+        }
+
+        return copies;
+    }
+
+    VkDeviceSize ImageCopyPlanner::getRegionSize(const Box& box) const
+    {
+        return static_cast<VkDeviceSize>(divideUp(box.extent.width, mBlockExtent.width)) *
+            divideUp(box.extent.height, mBlockExtent.height) *
+            divideUp(box.extent.depth, mBlockExtent.depth) * mBlockSize;
+    }
+
+    VkDeviceSize ImageCopyPlanner::alignOffset(VkDeviceSize offset) const
+    {
+        // Queues without graphics or compute need offsets that are multiples
+        // of 4 as well as of the block size
+        return (offset + mOffsetAlignment - 1) / mOffsetAlignment * mOffsetAlignment;
+    }
+}
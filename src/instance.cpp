@@ -1,28 +1,39 @@
 #include "vw/instance.h"
 
+#include <algorithm>
 #include <cassert>
 #include <utility>
 
 #include "vw/debugcallback.h"
+#include "vw/devicecapabilities.h"
 #include "vw/exception.h"
+#include "vw/hostallocator.h"
 #include "vw/physicaldevice.h"
 
 namespace vw
 {
     Instance::Instance()
         : mHandle(VK_NULL_HANDLE)
+        , mApiVersion(VK_API_VERSION_1_0)
         , mDebugCallback(VK_NULL_HANDLE)
     {
     }
 
-    Instance::Instance(VkInstance handle)
+    Instance::Instance(VkInstance handle, HostAllocatorPtr hostAllocator,
+        uint32_t apiVersion, std::vector<std::string> extensions)
         : mHandle(handle)
+        , mHostAllocator(std::move(hostAllocator))
+        , mApiVersion(apiVersion)
+        , mExtensions(std::move(extensions))
         , mDebugCallback(VK_NULL_HANDLE)
     {
     }
 
     Instance::Instance(Instance&& other)
         : mHandle(other.mHandle)
+        , mHostAllocator(std::move(other.mHostAllocator))
+        , mApiVersion(other.mApiVersion)
+        , mExtensions(std::move(other.mExtensions))
         , mDebugCallback(other.mDebugCallback)
         , mDebugCallbackObj(other.mDebugCallbackObj)
     {
@@ -36,15 +47,19 @@ namespace vw
         if (*this)
         {
             setDebugCallback(nullptr);
-            vkDestroyInstance(mHandle, nullptr);
+            vkDestroyInstance(mHandle, getAllocationCallbacks());
         }
     }
 
     Instance& Instance::operator=(Instance&& other)
     {
         std::swap(mHandle, other.mHandle);
+        std::swap(mHostAllocator, other.mHostAllocator);
+        std::swap(mApiVersion, other.mApiVersion);
+        std::swap(mExtensions, other.mExtensions);
         std::swap(mDebugCallback, other.mDebugCallback);
         std::swap(mDebugCallbackObj, other.mDebugCallbackObj);
+        return *this;
     }
 
     Instance::operator bool() const
@@ -52,32 +67,73 @@ namespace vw
         return mHandle != VK_NULL_HANDLE;
     }
 
-    Instance::PhysicalDeviceList Instance::enumeratePhysicalDevices()
+    Instance::PhysicalDeviceList Instance::enumeratePhysicalDevices(CapabilityCache* cache)
     {
-        assert(*this);
+        Result<PhysicalDeviceList> result = tryEnumeratePhysicalDevices(cache);
+        if (!result.hasValue())
+            throw Exception("vw::Instance::enumeratePhysicalDevices", result.getCode());
+
+        return result.takeValue();
+    }
 
-        // Retrieve handles
-        uint32_t deviceCount = 0;
-        VkResult result = VK_SUCCESS;
-        std::vector<VkPhysicalDevice> handles;
+    Result<Instance::PhysicalDeviceList> Instance::tryEnumeratePhysicalDevices(
+        CapabilityCache* cache) noexcept
+    {
+        assert(*this);
 
-        result = vkEnumeratePhysicalDevices(mHandle, &deviceCount, nullptr);
-        if (result != VK_SUCCESS)
-            throw Exception("vw::Instance::enumeratePhysicalDevices", result);
+        try
+        {
+            // Retrieve handles. Devices may appear between the two calls.
+            std::vector<VkPhysicalDevice> handles;
+            VkResult result = VK_INCOMPLETE;
+            while (result == VK_INCOMPLETE)
+            {
+                uint32_t deviceCount = 0;
+                result = vkEnumeratePhysicalDevices(mHandle, &deviceCount, nullptr);
+                if (result != VK_SUCCESS)
+                    return result;
+
+                handles.resize(deviceCount, VK_NULL_HANDLE);
+                result = vkEnumeratePhysicalDevices(mHandle, &deviceCount, handles.data());
+                if (result != VK_SUCCESS && result != VK_INCOMPLETE)
+                    return result;
+                handles.resize(deviceCount);
+            }
 
-        handles.resize(deviceCount, VK_NULL_HANDLE);
-        result = vkEnumeratePhysicalDevices(mHandle, &deviceCount, handles.data());
-        if (result != VK_SUCCESS)
-            throw Exception("vw::Instance::enumeratePhysicalDevices", result);
+            // Construct and return result
+            PhysicalDeviceList devices;
+            for (VkPhysicalDevice handle : handles)
+            {
+                if (!cache)
+                {
+                    devices.push_back(PhysicalDevice(handle));
+                    continue;
+                }
+
+                // Only the core properties are needed to find a snapshot
+                std::shared_ptr<DeviceCapabilities> capabilities =
+                    std::make_shared<DeviceCapabilities>(handle);
+                CapabilityCache::CapabilitiesPtr cached =
+                    cache->find(handle, capabilities->getProperties());
+                if (!cached)
+                {
+                    cache->add(capabilities);
+                    cached = capabilities;
+                }
+
+                devices.push_back(PhysicalDevice(cached));
+            }
 
-        // Construct and return result
-        PhysicalDeviceList devices;
-        for (VkPhysicalDevice handle : handles)
+            return Result<PhysicalDeviceList>(std::move(devices));
+        }
+        catch (const Exception& exception)
         {
-            devices.push_back(PhysicalDevice(handle));
+            return exception.getErrorCode();
+        }
+        catch (...)
+        {
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
         }
-
-        return devices;
     }
 
     VKAPI_ATTR VkBool32 instanceDebugCallback(VkDebugReportFlagsEXT flags,
@@ -91,10 +147,12 @@ namespace vw
         DebugCallback::CallbackData data;
         data.flags = flags;
         data.objectType = objectType;
+        data.object = object;
         data.location = location;
         data.messageCode = messageCode;
         data.layerPrefix = layerPrefix;
         data.message = message;
+        data.repeatCount = 0;
 
         if (callback->operator()(data))
             return VK_TRUE;
@@ -111,7 +169,7 @@ namespace vw
         {
             auto vkDestroyDebugCallback = (PFN_vkDestroyDebugReportCallbackEXT)
                 vkGetInstanceProcAddr(mHandle, "vkDestroyDebugReportCallbackEXT");
-            vkDestroyDebugCallback(mHandle, mDebugCallback, nullptr);
+            vkDestroyDebugCallback(mHandle, mDebugCallback, getAllocationCallbacks());
 
             mDebugCallback = VK_NULL_HANDLE;
             mDebugCallbackObj.reset();
@@ -136,7 +194,8 @@ namespace vw
             cinfo.pfnCallback = instanceDebugCallback;
             cinfo.pUserData = callback.get();
 
-            VkResult result = vkCreateDebugCallback(mHandle, &cinfo, nullptr, &mDebugCallback);
+            VkResult result = vkCreateDebugCallback(mHandle, &cinfo,
+                getAllocationCallbacks(), &mDebugCallback);
             if (result != VK_SUCCESS)
                 throw Exception("vw::Instance::setDebugCallback", result);
 
@@ -144,6 +203,26 @@ namespace vw
         }
     }
 
+    uint32_t Instance::getApiVersion() const
+    {
+        return mApiVersion;
+    }
+
+    bool Instance::hasExtension(const std::string& name) const
+    {
+        return std::find(mExtensions.begin(), mExtensions.end(), name) != mExtensions.end();
+    }
+
+    const VkAllocationCallbacks* Instance::getAllocationCallbacks() const
+    {
+        return (mHostAllocator) ? mHostAllocator->getCallbacks() : nullptr;
+    }
+
+    const Instance::HostAllocatorPtr& Instance::getHostAllocator() const
+    {
+        return mHostAllocator;
+    }
+
     VkInstance Instance::getHandle()
     {
         return mHandle;
@@ -195,6 +274,11 @@ namespace vw
         mExtensions.push_back(name);
     }
 
+    void InstanceCreator::setHostAllocator(Instance::HostAllocatorPtr allocator)
+    {
+        mHostAllocator = std::move(allocator);
+    }
+
     void InstanceCreator::reset()
     {
         mUseAppInfo = false;
@@ -205,49 +289,75 @@ namespace vw
         mApiVersion = 0;
         mLayers.clear();
         mExtensions.clear();
+        mHostAllocator.reset();
     }
 
     Instance InstanceCreator::create()
     {
-        // Application specific info
-        VkApplicationInfo appInfo;
-        appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
-        appInfo.pNext = nullptr;
-        appInfo.pApplicationName = mAppName.c_str();
-        appInfo.applicationVersion = mAppVersion;
-        appInfo.pEngineName = mEngineName.c_str();
-        appInfo.engineVersion = mEngineVersion;
-        appInfo.apiVersion = mApiVersion;
-
-        // Extensions and layers
-        std::vector<const char *> rawLayers;
-        for (const std::string& str : mLayers)
-            rawLayers.push_back(str.c_str());
-
-        std::vector<const char *> rawExtensions;
-        for (const std::string& str : mExtensions)
-            rawExtensions.push_back(str.c_str());
-
-        // Instance specific info
-        VkInstanceCreateInfo createInfo;
-        createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-        createInfo.pNext = nullptr;
-        createInfo.flags = 0;
-        createInfo.pApplicationInfo = (mUseAppInfo) ? &appInfo : nullptr;
-        createInfo.enabledLayerCount = rawLayers.size();
-        createInfo.ppEnabledLayerNames = rawLayers.data();
-        createInfo.enabledExtensionCount = rawExtensions.size();
-        createInfo.ppEnabledExtensionNames = rawExtensions.data();
-
-        // Actually create the instance now
-        VkInstance handle = VK_NULL_HANDLE;
-        VkResult result = vkCreateInstance(&createInfo, nullptr, &handle);
-        if (result != VK_SUCCESS)
+        Result<Instance> result = tryCreate();
+        if (!result.hasValue())
+            throw Exception("vw::InstanceCreator::create", result.getCode());
+
+        return result.takeValue();
+    }
+
+    Result<Instance> InstanceCreator::tryCreate() noexcept
+    {
+        try
         {
-            throw Exception("vw::InstanceCreator::create", result);
+            // Application specific info
+            VkApplicationInfo appInfo;
+            appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+            appInfo.pNext = nullptr;
+            appInfo.pApplicationName = mAppName.c_str();
+            appInfo.applicationVersion = mAppVersion;
+            appInfo.pEngineName = mEngineName.c_str();
+            appInfo.engineVersion = mEngineVersion;
+            appInfo.apiVersion = mApiVersion;
+
+            // Extensions and layers
+            std::vector<const char *> rawLayers;
+            for (const std::string& str : mLayers)
+                rawLayers.push_back(str.c_str());
+
+            std::vector<const char *> rawExtensions;
+            for (const std::string& str : mExtensions)
+                rawExtensions.push_back(str.c_str());
+
+            // Instance specific info
+            VkInstanceCreateInfo createInfo;
+            createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+            createInfo.pNext = nullptr;
+            createInfo.flags = 0;
+            createInfo.pApplicationInfo = (mUseAppInfo) ? &appInfo : nullptr;
+            createInfo.enabledLayerCount = rawLayers.size();
+            createInfo.ppEnabledLayerNames = rawLayers.data();
+            createInfo.enabledExtensionCount = rawExtensions.size();
+            createInfo.ppEnabledExtensionNames = rawExtensions.data();
+
+            // Copied first so nothing can throw once the handle exists
+            std::vector<std::string> extensions(mExtensions);
+
+            // Actually create the instance now
+            const VkAllocationCallbacks* callbacks =
+                (mHostAllocator) ? mHostAllocator->getCallbacks() : nullptr;
+
+            VkInstance handle = VK_NULL_HANDLE;
+            VkResult result = vkCreateInstance(&createInfo, callbacks, &handle);
+            if (result != VK_SUCCESS)
+                return result;
+
+            // Without application info, or with a zero version, the
+            // instance targets Vulkan 1.0
+            uint32_t apiVersion = (mUseAppInfo && mApiVersion != 0) ?
+                mApiVersion : VK_API_VERSION_1_0;
+            return Result<Instance>(Instance(handle, mHostAllocator, apiVersion,
+                std::move(extensions)));
+        }
+        catch (...)
+        {
+            // Only the vectors above can throw
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
         }
-
-        return Instance(handle);
     }
 }
-
@@ -0,0 +1,952 @@
+#include "vw/memoryallocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+
+#include "vw/devicedispatch.h"
+#include "vw/exception.h"
+#include "vw/physicaldevice.h"
+
+namespace vw
+{
+    namespace
+    {
+        const uint32_t NullNode = ~0u;
+
+        // Each power of two size class is split into 2^SecondLevelBits linear
+        // sub classes.
+        const uint32_t SecondLevelBits = 4;
+        const uint32_t SecondLevelCount = 1u << SecondLevelBits;
+        const uint32_t FirstLevelCount = 64 - SecondLevelBits + 1;
+
+        uint32_t findLastSet(uint64_t value)
+        {
+            assert(value != 0);
+            return 63 - __builtin_clzll(value);
+        }
+
+        uint32_t findFirstSet(uint64_t value)
+        {
+            assert(value != 0);
+            return __builtin_ctzll(value);
+        }
+
+        VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        void mapSize(VkDeviceSize size, uint32_t& fl, uint32_t& sl)
+        {
+            if (size < SecondLevelCount)
+            {
+                fl = 0;
+                sl = static_cast<uint32_t>(size);
+            }
+            else
+            {
+                uint32_t msb = findLastSet(size);
+                fl = msb - SecondLevelBits + 1;
+                sl = static_cast<uint32_t>(size >> (msb - SecondLevelBits)) - SecondLevelCount;
+            }
+        }
+    }
+
+    const VkDeviceSize MemoryAllocator::DefaultBlockSize;
+
+    /*! @brief A single VkDeviceMemory object managed with TLSF.
+     */
+    class MemoryAllocator::Block
+    {
+        public:
+
+            Block(VkDeviceMemory memory, VkDeviceSize size, void* mapped)
+                : index(0)
+                , prevAvailable(nullptr)
+                , nextAvailable(nullptr)
+                , availableFl(NullNode)
+                , availableSl(NullNode)
+                , mMemory(memory)
+                , mSize(size)
+                , mMapped(mapped)
+                , mUsedBytes(0)
+                , mAllocationCount(0)
+                , mFreeNodes(NullNode)
+                , mFirstLevelMap(0)
+            {
+                std::fill(&mSecondLevelMap[0], &mSecondLevelMap[FirstLevelCount], 0);
+                std::fill(&mHeads[0][0], &mHeads[FirstLevelCount - 1][SecondLevelCount], NullNode);
+
+                uint32_t node = createNode(0, size);
+                insertFree(node);
+            }
+
+            VkDeviceMemory getMemory() const
+            {
+                return mMemory;
+            }
+
+            void* getMapped() const
+            {
+                return mMapped;
+            }
+
+            bool isEmpty() const
+            {
+                return mAllocationCount == 0;
+            }
+
+            // Returns the size class of the largest free range, or false if
+            // the block is full
+            bool getLargestClass(uint32_t& fl, uint32_t& sl) const
+            {
+                if (mFirstLevelMap == 0)
+                    return false;
+
+                fl = findLastSet(mFirstLevelMap);
+                sl = findLastSet(mSecondLevelMap[fl]);
+                return true;
+            }
+
+            bool allocate(VkDeviceSize size, VkDeviceSize alignment,
+                VkDeviceSize& offset, uint32_t& result)
+            {
+                // Try a good fit for the plain size first, falling back to a
+                // block large enough for any alignment padding.
+                uint32_t node = findFree(size);
+                if (node == NullNode || !fits(node, size, alignment))
+                {
+                    node = findFree(size + alignment - 1);
+                    if (node == NullNode)
+                        return false;
+                }
+
+                removeFree(node);
+
+                // Split off the padding in front of the aligned offset
+                VkDeviceSize aligned = alignUp(mNodes[node].offset, alignment);
+                VkDeviceSize padding = aligned - mNodes[node].offset;
+                if (padding > 0)
+                {
+                    uint32_t front = createNode(mNodes[node].offset, padding);
+                    linkBefore(front, node);
+                    mNodes[node].offset += padding;
+                    mNodes[node].size -= padding;
+                    insertFree(front);
+                }
+
+                // Split off the unused tail
+                if (mNodes[node].size > size)
+                {
+                    uint32_t back = createNode(mNodes[node].offset + size,
+                        mNodes[node].size - size);
+                    linkAfter(back, node);
+                    mNodes[node].size = size;
+                    insertFree(back);
+                }
+
+                mUsedBytes += size;
+                ++mAllocationCount;
+
+                offset = mNodes[node].offset;
+                result = node;
+                return true;
+            }
+
+            void free(uint32_t node)
+            {
+                assert(node < mNodes.size() && !mNodes[node].free);
+
+                mUsedBytes -= mNodes[node].size;
+                --mAllocationCount;
+
+                // Coalesce with free physical neighbours
+                uint32_t prev = mNodes[node].prevPhysical;
+                if (prev != NullNode && mNodes[prev].free)
+                {
+                    removeFree(prev);
+                    mNodes[prev].size += mNodes[node].size;
+                    unlink(node);
+                    releaseNode(node);
+                    node = prev;
+                }
+
+                uint32_t next = mNodes[node].nextPhysical;
+                if (next != NullNode && mNodes[next].free)
+                {
+                    removeFree(next);
+                    mNodes[node].size += mNodes[next].size;
+                    unlink(next);
+                    releaseNode(next);
+                }
+
+                insertFree(node);
+            }
+
+            // Returns the largest free range in the block
+            VkDeviceSize addStatistics(Statistics& stats) const
+            {
+                VkDeviceSize largest = 0;
+
+                stats.blockCount += 1;
+                stats.allocationCount += mAllocationCount;
+                stats.blockBytes += mSize;
+                stats.usedBytes += mUsedBytes;
+                stats.freeBytes += mSize - mUsedBytes;
+
+                for (uint32_t fl = 0; fl < FirstLevelCount; ++fl)
+                {
+                    for (uint32_t sl = 0; sl < SecondLevelCount; ++sl)
+                    {
+                        for (uint32_t node = mHeads[fl][sl]; node != NullNode;
+                            node = mNodes[node].nextFree)
+                        {
+                            stats.freeRangeCount += 1;
+                            largest = std::max(largest, mNodes[node].size);
+                        }
+                    }
+                }
+
+                stats.largestFreeRange = std::max(stats.largestFreeRange, largest);
+                return largest;
+            }
+
+            // Owned by the Pool, which indexes its blocks by their largest
+            // free range
+            size_t index;
+            Block* prevAvailable;
+            Block* nextAvailable;
+            uint32_t availableFl;
+            uint32_t availableSl;
+
+        private:
+
+            struct Node
+            {
+                VkDeviceSize offset;
+                VkDeviceSize size;
+                uint32_t prevPhysical;
+                uint32_t nextPhysical;
+                uint32_t prevFree;
+                uint32_t nextFree;
+                bool free;
+            };
+
+            bool fits(uint32_t node, VkDeviceSize size, VkDeviceSize alignment) const
+            {
+                VkDeviceSize aligned = alignUp(mNodes[node].offset, alignment);
+                return aligned + size <= mNodes[node].offset + mNodes[node].size;
+            }
+
+            uint32_t findFree(VkDeviceSize size) const
+            {
+                // Round up to the next size class so any block found fits
+                if (size >= SecondLevelCount)
+                    size += (VkDeviceSize(1) << (findLastSet(size) - SecondLevelBits)) - 1;
+
+                uint32_t fl, sl;
+                mapSize(size, fl, sl);
+                if (fl >= FirstLevelCount)
+                    return NullNode;
+
+                uint32_t slMap = mSecondLevelMap[fl] & (~0u << sl);
+                if (slMap == 0)
+                {
+                    if (fl + 1 >= FirstLevelCount)
+                        return NullNode;
+
+                    uint64_t flMap = mFirstLevelMap & (~uint64_t(0) << (fl + 1));
+                    if (flMap == 0)
+                        return NullNode;
+
+                    fl = findFirstSet(flMap);
+                    slMap = mSecondLevelMap[fl];
+                }
+
+                sl = findFirstSet(slMap);
+                return mHeads[fl][sl];
+            }
+
+            void insertFree(uint32_t node)
+            {
+                uint32_t fl, sl;
+                mapSize(mNodes[node].size, fl, sl);
+
+                mNodes[node].free = true;
+                mNodes[node].prevFree = NullNode;
+                mNodes[node].nextFree = mHeads[fl][sl];
+                if (mHeads[fl][sl] != NullNode)
+                    mNodes[mHeads[fl][sl]].prevFree = node;
+                mHeads[fl][sl] = node;
+
+                mFirstLevelMap |= uint64_t(1) << fl;
+                mSecondLevelMap[fl] |= 1u << sl;
+            }
+
+            void removeFree(uint32_t node)
+            {
+                uint32_t fl, sl;
+                mapSize(mNodes[node].size, fl, sl);
+
+                uint32_t prev = mNodes[node].prevFree;
+                uint32_t next = mNodes[node].nextFree;
+                if (prev != NullNode)
+                    mNodes[prev].nextFree = next;
+                if (next != NullNode)
+                    mNodes[next].prevFree = prev;
+
+                if (mHeads[fl][sl] == node)
+                {
+                    mHeads[fl][sl] = next;
+                    if (next == NullNode)
+                    {
+                        mSecondLevelMap[fl] &= ~(1u << sl);
+                        if (mSecondLevelMap[fl] == 0)
+                            mFirstLevelMap &= ~(uint64_t(1) << fl);
+                    }
+                }
+
+                mNodes[node].free = false;
+            }
+
+            uint32_t createNode(VkDeviceSize offset, VkDeviceSize size)
+            {
+                uint32_t node = mFreeNodes;
+                if (node != NullNode)
+                {
+                    mFreeNodes = mNodes[node].nextFree;
+                }
+                else
+                {
+                    node = static_cast<uint32_t>(mNodes.size());
+                    mNodes.push_back(Node());
+                }
+
+                Node& data = mNodes[node];
+                data.offset = offset;
+                data.size = size;
+                data.prevPhysical = NullNode;
+                data.nextPhysical = NullNode;
+                data.prevFree = NullNode;
+                data.nextFree = NullNode;
+                data.free = false;
+                return node;
+            }
+
+            void releaseNode(uint32_t node)
+            {
+                mNodes[node].nextFree = mFreeNodes;
+                mFreeNodes = node;
+            }
+
+            void linkBefore(uint32_t node, uint32_t next)
+            {
+                uint32_t prev = mNodes[next].prevPhysical;
+                mNodes[node].prevPhysical = prev;
+                mNodes[node].nextPhysical = next;
+                mNodes[next].prevPhysical = node;
+                if (prev != NullNode)
+                    mNodes[prev].nextPhysical = node;
+            }
+
+            void linkAfter(uint32_t node, uint32_t prev)
+            {
+                uint32_t next = mNodes[prev].nextPhysical;
+                mNodes[node].prevPhysical = prev;
+                mNodes[node].nextPhysical = next;
+                mNodes[prev].nextPhysical = node;
+                if (next != NullNode)
+                    mNodes[next].prevPhysical = node;
+            }
+
+            void unlink(uint32_t node)
+            {
+                uint32_t prev = mNodes[node].prevPhysical;
+                uint32_t next = mNodes[node].nextPhysical;
+                if (prev != NullNode)
+                    mNodes[prev].nextPhysical = next;
+                if (next != NullNode)
+                    mNodes[next].prevPhysical = prev;
+            }
+
+            VkDeviceMemory mMemory;
+            VkDeviceSize mSize;
+            void* mMapped;
+            VkDeviceSize mUsedBytes;
+            size_t mAllocationCount;
+
+            std::vector<Node> mNodes;
+            uint32_t mFreeNodes;
+
+            uint64_t mFirstLevelMap;
+            uint32_t mSecondLevelMap[FirstLevelCount];
+            uint32_t mHeads[FirstLevelCount][SecondLevelCount];
+    };
+
+    /*! @brief The blocks of a single memory type and resource type.
+     *
+     *  Blocks with free space are kept in lists by the size class of their
+     *  largest free range, the same two level scheme a Block uses for its
+     *  ranges, so finding one that fits takes constant time.
+     */
+    struct MemoryAllocator::Pool
+    {
+        Pool(uint32_t type, VkDeviceSize size)
+            : memoryType(type)
+            , blockSize(size)
+            , dedicatedCount(0)
+            , dedicatedBytes(0)
+            , emptyCount(0)
+            , firstLevelMap(0)
+        {
+            std::fill(&secondLevelMap[0], &secondLevelMap[FirstLevelCount], 0);
+            std::fill(&heads[0][0], &heads[FirstLevelCount - 1][SecondLevelCount],
+                static_cast<Block*>(nullptr));
+        }
+
+        void add(std::unique_ptr<Block> block)
+        {
+            block->index = blocks.size();
+            blocks.push_back(std::move(block));
+            ++emptyCount;
+            insertAvailable(*blocks.back());
+        }
+
+        std::unique_ptr<Block> remove(Block& block)
+        {
+            assert(block.isEmpty());
+            removeAvailable(block);
+            --emptyCount;
+
+            // The last block takes the slot of the removed one
+            size_t index = block.index;
+            std::unique_ptr<Block> removed = std::move(blocks[index]);
+            if (index + 1 < blocks.size())
+            {
+                blocks[index] = std::move(blocks.back());
+                blocks[index]->index = index;
+            }
+            blocks.pop_back();
+            return removed;
+        }
+
+        // Returns a block that fits the request, or null if none is known to
+        Block* findAvailable(VkDeviceSize size, VkDeviceSize alignment) const
+        {
+            VkDeviceSize needed = size + alignment - 1;
+
+            // Any block whose largest range is in a higher class fits, so
+            // round up to the next class like Block::findFree
+            VkDeviceSize rounded = needed;
+            if (rounded >= SecondLevelCount)
+                rounded += (VkDeviceSize(1) << (findLastSet(rounded) - SecondLevelBits)) - 1;
+
+            uint32_t fl, sl;
+            mapSize(rounded, fl, sl);
+            if (fl < FirstLevelCount)
+            {
+                uint32_t slMap = secondLevelMap[fl] & (~0u << sl);
+                if (slMap == 0 && fl + 1 < FirstLevelCount)
+                {
+                    uint64_t flMap = firstLevelMap & (~uint64_t(0) << (fl + 1));
+                    if (flMap != 0)
+                    {
+                        fl = findFirstSet(flMap);
+                        slMap = secondLevelMap[fl];
+                    }
+                }
+
+                if (slMap != 0)
+                    return heads[fl][findFirstSet(slMap)];
+            }
+
+            // A block in the class of the request itself may still fit it
+            mapSize(needed, fl, sl);
+            return (fl < FirstLevelCount) ? heads[fl][sl] : nullptr;
+        }
+
+        // Blocks must be taken out of the index while their free ranges
+        // change and put back after
+        void insertAvailable(Block& block)
+        {
+            uint32_t fl, sl;
+            if (!block.getLargestClass(fl, sl))
+                return;
+
+            block.availableFl = fl;
+            block.availableSl = sl;
+            block.prevAvailable = nullptr;
+            block.nextAvailable = heads[fl][sl];
+            if (heads[fl][sl])
+                heads[fl][sl]->prevAvailable = &block;
+            heads[fl][sl] = &block;
+
+            firstLevelMap |= uint64_t(1) << fl;
+            secondLevelMap[fl] |= 1u << sl;
+        }
+
+        void removeAvailable(Block& block)
+        {
+            uint32_t fl = block.availableFl;
+            uint32_t sl = block.availableSl;
+            if (fl == NullNode)
+                return;
+
+            if (block.prevAvailable)
+                block.prevAvailable->nextAvailable = block.nextAvailable;
+            if (block.nextAvailable)
+                block.nextAvailable->prevAvailable = block.prevAvailable;
+
+            if (heads[fl][sl] == &block)
+            {
+                heads[fl][sl] = block.nextAvailable;
+                if (!heads[fl][sl])
+                {
+                    secondLevelMap[fl] &= ~(1u << sl);
+                    if (secondLevelMap[fl] == 0)
+                        firstLevelMap &= ~(uint64_t(1) << fl);
+                }
+            }
+
+            block.prevAvailable = nullptr;
+            block.nextAvailable = nullptr;
+            block.availableFl = NullNode;
+            block.availableSl = NullNode;
+        }
+
+        uint32_t memoryType;
+        VkDeviceSize blockSize;
+        mutable std::mutex mutex;
+        std::vector<std::unique_ptr<Block>> blocks;
+        size_t dedicatedCount;
+        VkDeviceSize dedicatedBytes;
+        size_t emptyCount;
+
+        uint64_t firstLevelMap;
+        uint32_t secondLevelMap[FirstLevelCount];
+        Block* heads[FirstLevelCount][SecondLevelCount];
+    };
+
+    Allocation::Allocation()
+        : mMemory(VK_NULL_HANDLE)
+        , mOffset(0)
+        , mSize(0)
+        , mMemoryType(0)
+        , mMappedData(nullptr)
+        , mBlock(nullptr)
+        , mPool(0)
+        , mNode(NullNode)
+    {
+    }
+
+    Allocation::operator bool() const
+    {
+        return mMemory != VK_NULL_HANDLE;
+    }
+
+    VkDeviceMemory Allocation::getMemory() const
+    {
+        return mMemory;
+    }
+
+    VkDeviceSize Allocation::getOffset() const
+    {
+        return mOffset;
+    }
+
+    VkDeviceSize Allocation::getSize() const
+    {
+        return mSize;
+    }
+
+    uint32_t Allocation::getMemoryType() const
+    {
+        return mMemoryType;
+    }
+
+    void* Allocation::getMappedData() const
+    {
+        return mMappedData;
+    }
+
+    MemoryAllocator::MemoryAllocator(VkDevice device, const DeviceDispatch& dispatch,
+        const PhysicalDevice& physicalDevice, VkDeviceSize blockSize,
+        const VkAllocationCallbacks* callbacks)
+        : mDevice(device)
+        , mDispatch(dispatch)
+        , mCallbacks(callbacks)
+        , mMemoryProperties(physicalDevice.getMemoryProperties())
+        , mBlockSize(blockSize)
+        , mBufferImageGranularity(physicalDevice.getDeviceLimits().bufferImageGranularity)
+        , mNonCoherentAtomSize(physicalDevice.getDeviceLimits().nonCoherentAtomSize)
+        , mMaxAllocationCount(physicalDevice.getDeviceLimits().maxMemoryAllocationCount)
+        , mAllocationCount(0)
+    {
+        assert(mDevice != VK_NULL_HANDLE);
+        assert(mBlockSize > 0);
+
+        // Two pools per memory type, for linear and optimal resources
+        for (uint32_t type = 0; type < mMemoryProperties.memoryTypeCount; ++type)
+        {
+            uint32_t heap = mMemoryProperties.memoryTypes[type].heapIndex;
+            VkDeviceSize heapSize = mMemoryProperties.memoryHeaps[heap].size;
+            VkDeviceSize size = std::min(mBlockSize, std::max<VkDeviceSize>(heapSize / 8, 1));
+
+            if (!isCoherent(type))
+                size = alignUp(size, mNonCoherentAtomSize);
+
+            mPools.emplace_back(new Pool(type, size));
+            mPools.emplace_back(new Pool(type, size));
+        }
+    }
+
+    MemoryAllocator::~MemoryAllocator()
+    {
+        for (auto& pool : mPools)
+        {
+            for (auto& block : pool->blocks)
+            {
+                assert(block->isEmpty());
+                freeMemory(block->getMemory());
+            }
+        }
+    }
+
+    Allocation MemoryAllocator::allocate(const VkMemoryRequirements& requirements,
+        VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred,
+        ResourceType type)
+    {
+        assert(requirements.size > 0);
+
+        uint32_t memoryType = findMemoryType(requirements.memoryTypeBits, required, preferred);
+        if (memoryType == NullNode)
+            throw Exception("vw::MemoryAllocator::allocate", VK_ERROR_FEATURE_NOT_PRESENT);
+
+        // Non-coherent ranges are padded to whole atoms so flushing one
+        // allocation never touches its neighbours.
+        VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+        VkDeviceSize size = requirements.size;
+        if (!isCoherent(memoryType))
+        {
+            alignment = std::max(alignment, mNonCoherentAtomSize);
+            size = alignUp(size, mNonCoherentAtomSize);
+        }
+
+        // Linear and optimal resources only need separate blocks when the
+        // granularity is coarser than the alignment already applied.
+        size_t poolIndex = memoryType * 2;
+        if (type == Resource_Optimal && mBufferImageGranularity > 1)
+            poolIndex += 1;
+
+        Pool& pool = *mPools[poolIndex];
+
+        Allocation allocation;
+        allocation.mMemoryType = memoryType;
+        allocation.mSize = size;
+        allocation.mPool = static_cast<uint32_t>(poolIndex);
+
+        // Large requests get their own memory object
+        if (size > pool.blockSize / 2)
+        {
+            void* mapped = nullptr;
+            allocation.mMemory = allocateMemory(memoryType, size, &mapped);
+            allocation.mMappedData = mapped;
+
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            pool.dedicatedCount += 1;
+            pool.dedicatedBytes += size;
+            return allocation;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            Block* block = pool.findAvailable(size, alignment);
+            if (block && allocateFromBlock(pool, *block, size, alignment, allocation))
+                return allocation;
+        }
+
+        // The driver may take a while, so other threads keep using the pool
+        void* mapped = nullptr;
+        VkDeviceMemory memory = allocateMemory(memoryType, pool.blockSize, &mapped);
+
+        std::unique_lock<std::mutex> lock(pool.mutex, std::defer_lock);
+        try
+        {
+            std::unique_ptr<Block> created(new Block(memory, pool.blockSize, mapped));
+            lock.lock();
+            pool.add(std::move(created));
+        }
+        catch (...)
+        {
+            if (lock.owns_lock())
+                lock.unlock();
+            freeMemory(memory);
+            throw;
+        }
+
+        bool success = allocateFromBlock(pool, *pool.blocks.back(), size, alignment,
+            allocation);
+        assert(success);
+        (void)success;
+        return allocation;
+    }
+
+    Allocation MemoryAllocator::allocateForBuffer(VkBuffer buffer,
+        VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred)
+    {
+        VkMemoryRequirements requirements;
+        mDispatch.vkGetBufferMemoryRequirements(mDevice, buffer, &requirements);
+
+        Allocation allocation = allocate(requirements, required, preferred, Resource_Linear);
+        VkResult result = mDispatch.vkBindBufferMemory(mDevice, buffer,
+            allocation.getMemory(), allocation.getOffset());
+        if (result != VK_SUCCESS)
+        {
+            free(allocation);
+            throw Exception("vw::MemoryAllocator::allocateForBuffer", result);
+        }
+
+        return allocation;
+    }
+
+    Allocation MemoryAllocator::allocateForImage(VkImage image,
+        VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred,
+        ResourceType type)
+    {
+        VkMemoryRequirements requirements;
+        mDispatch.vkGetImageMemoryRequirements(mDevice, image, &requirements);
+
+        Allocation allocation = allocate(requirements, required, preferred, type);
+        VkResult result = mDispatch.vkBindImageMemory(mDevice, image,
+            allocation.getMemory(), allocation.getOffset());
+        if (result != VK_SUCCESS)
+        {
+            free(allocation);
+            throw Exception("vw::MemoryAllocator::allocateForImage", result);
+        }
+
+        return allocation;
+    }
+
+    void MemoryAllocator::free(Allocation& allocation)
+    {
+        if (!allocation)
+            return;
+
+        Pool& pool = *mPools[allocation.mPool];
+
+        if (allocation.mBlock == nullptr)
+        {
+            {
+                std::lock_guard<std::mutex> lock(pool.mutex);
+                pool.dedicatedCount -= 1;
+                pool.dedicatedBytes -= allocation.mSize;
+            }
+
+            freeMemory(allocation.mMemory);
+        }
+        else
+        {
+            Block* block = static_cast<Block*>(allocation.mBlock);
+            std::unique_ptr<Block> released;
+            {
+                std::lock_guard<std::mutex> lock(pool.mutex);
+                pool.removeAvailable(*block);
+                block->free(allocation.mNode);
+                pool.insertAvailable(*block);
+
+                // Keep at most one empty block around to absorb churn
+                if (block->isEmpty() && ++pool.emptyCount > 1)
+                    released = pool.remove(*block);
+            }
+
+            if (released)
+                freeMemory(released->getMemory());
+        }
+
+        allocation = Allocation();
+    }
+
+    void MemoryAllocator::flush(const Allocation& allocation)
+    {
+        assert(allocation);
+
+        if (isCoherent(allocation.mMemoryType))
+            return;
+
+        VkMappedMemoryRange range;
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.pNext = nullptr;
+        range.memory = allocation.mMemory;
+        range.offset = allocation.mOffset;
+        range.size = allocation.mSize;
+
+        VkResult result = mDispatch.vkFlushMappedMemoryRanges(mDevice, 1, &range);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::MemoryAllocator::flush", result);
+    }
+
+    void MemoryAllocator::invalidate(const Allocation& allocation)
+    {
+        assert(allocation);
+
+        if (isCoherent(allocation.mMemoryType))
+            return;
+
+        VkMappedMemoryRange range;
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.pNext = nullptr;
+        range.memory = allocation.mMemory;
+        range.offset = allocation.mOffset;
+        range.size = allocation.mSize;
+
+        VkResult result = mDispatch.vkInvalidateMappedMemoryRanges(mDevice, 1, &range);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::MemoryAllocator::invalidate", result);
+    }
+
+    MemoryAllocator::Statistics MemoryAllocator::getStatistics() const
+    {
+        Statistics stats = Statistics();
+        VkDeviceSize contiguousBytes = 0;
+        for (auto& pool : mPools)
+            contiguousBytes += addStatistics(*pool, stats);
+
+        if (stats.freeBytes > 0)
+            stats.fragmentation = 1.0f - float(contiguousBytes) / float(stats.freeBytes);
+        return stats;
+    }
+
+    MemoryAllocator::Statistics MemoryAllocator::getStatistics(uint32_t memoryType) const
+    {
+        assert(memoryType < mMemoryProperties.memoryTypeCount);
+
+        Statistics stats = Statistics();
+        VkDeviceSize contiguousBytes = 0;
+        contiguousBytes += addStatistics(*mPools[memoryType * 2], stats);
+        contiguousBytes += addStatistics(*mPools[memoryType * 2 + 1], stats);
+
+        if (stats.freeBytes > 0)
+            stats.fragmentation = 1.0f - float(contiguousBytes) / float(stats.freeBytes);
+        return stats;
+    }
+
+    const VkPhysicalDeviceMemoryProperties& MemoryAllocator::getMemoryProperties() const
+    {
+        return mMemoryProperties;
+    }
+
+    uint32_t MemoryAllocator::findMemoryType(uint32_t typeBits,
+        VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) const
+    {
+        uint32_t best = NullNode;
+        int bestScore = -1;
+
+        for (uint32_t type = 0; type < mMemoryProperties.memoryTypeCount; ++type)
+        {
+            VkMemoryPropertyFlags flags = mMemoryProperties.memoryTypes[type].propertyFlags;
+            if (!(typeBits & (1u << type)) || (flags & required) != required)
+                continue;
+
+            int score = __builtin_popcount(flags & preferred);
+            if (score > bestScore)
+            {
+                best = type;
+                bestScore = score;
+            }
+        }
+
+        return best;
+    }
+
+    bool MemoryAllocator::allocateFromBlock(Pool& pool, Block& block, VkDeviceSize size,
+        VkDeviceSize alignment, Allocation& allocation)
+    {
+        bool wasEmpty = block.isEmpty();
+
+        pool.removeAvailable(block);
+        bool success = block.allocate(size, alignment, allocation.mOffset, allocation.mNode);
+        pool.insertAvailable(block);
+        if (!success)
+            return false;
+
+        if (wasEmpty)
+            --pool.emptyCount;
+
+        allocation.mMemory = block.getMemory();
+        allocation.mBlock = &block;
+        if (block.getMapped())
+            allocation.mMappedData = static_cast<char*>(block.getMapped()) + allocation.mOffset;
+        return true;
+    }
+
+    bool MemoryAllocator::isCoherent(uint32_t memoryType) const
+    {
+        VkMemoryPropertyFlags flags = mMemoryProperties.memoryTypes[memoryType].propertyFlags;
+        return !(flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) ||
+            (flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    }
+
+    VkDeviceMemory MemoryAllocator::allocateMemory(uint32_t memoryType,
+        VkDeviceSize size, void** mapped)
+    {
+        // Fail early rather than relying on the driver to report the limit
+        if (++mAllocationCount > mMaxAllocationCount)
+        {
+            --mAllocationCount;
+            throw Exception("vw::MemoryAllocator::allocate", VK_ERROR_TOO_MANY_OBJECTS);
+        }
+
+        VkMemoryAllocateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        info.pNext = nullptr;
+        info.allocationSize = size;
+        info.memoryTypeIndex = memoryType;
+
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkResult result = mDispatch.vkAllocateMemory(mDevice, &info, mCallbacks, &memory);
+        if (result != VK_SUCCESS)
+        {
+            --mAllocationCount;
+            throw Exception("vw::MemoryAllocator::allocate", result);
+        }
+
+        // Host visible memory stays mapped for its whole lifetime
+        *mapped = nullptr;
+        VkMemoryPropertyFlags flags = mMemoryProperties.memoryTypes[memoryType].propertyFlags;
+        if (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            result = mDispatch.vkMapMemory(mDevice, memory, 0, VK_WHOLE_SIZE, 0, mapped);
+            if (result != VK_SUCCESS)
+            {
+                freeMemory(memory);
+                throw Exception("vw::MemoryAllocator::allocate", result);
+            }
+        }
+
+        return memory;
+    }
+
+    void MemoryAllocator::freeMemory(VkDeviceMemory memory)
+    {
+        // Freeing implicitly unmaps the memory
+        mDispatch.vkFreeMemory(mDevice, memory, mCallbacks);
+        --mAllocationCount;
+    }
+
+    VkDeviceSize MemoryAllocator::addStatistics(const Pool& pool, Statistics& stats) const
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+
+        // Sum of the largest free range of each block, since a range can
+        // never span blocks.
+        VkDeviceSize contiguousBytes = 0;
+        for (auto& block : pool.blocks)
+            contiguousBytes += block->addStatistics(stats);
+
+        stats.dedicatedAllocationCount += pool.dedicatedCount;
+        stats.dedicatedBytes += pool.dedicatedBytes;
+        return contiguousBytes;
+    }
+}
@@ -0,0 +1,328 @@
+#include "vw/parallelrecorder.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "vw/device.h"
+#include "vw/devicedispatch.h"
+#include "vw/exception.h"
+#include "vw/queue.h"
+
+namespace vw
+{
+    ParallelRecorder::Settings::Settings()
+        : workerCount(std::max(1u, std::thread::hardware_concurrency()) - 1)
+        , framesInFlight(2)
+        , minChunkItems(64)
+        , chunksPerThread(4)
+        , level(VK_COMMAND_BUFFER_LEVEL_SECONDARY)
+    {
+    }
+
+    ParallelRecorder::ParallelRecorder(Device& device, const QueueFamily& family,
+        const Settings& settings)
+        : mDevice(device)
+        , mSettings(settings)
+        , mPools(device, family, settings.workerCount + 1, settings.framesInFlight)
+        , mRanges(settings.workerCount + 1)
+        , mFunction(nullptr)
+        , mInheritance(nullptr)
+        , mItemCount(0)
+        , mChunkCount(0)
+        , mRemaining(0)
+        , mGeneration(0)
+        , mBusy(0)
+        , mStopping(false)
+    {
+        assert(mSettings.minChunkItems > 0 && mSettings.chunksPerThread > 0);
+
+        for (Range& range : mRanges)
+        {
+            range.begin = 0;
+            range.end = 0;
+        }
+
+        try
+        {
+            mThreads.reserve(mSettings.workerCount);
+            for (uint32_t i = 0; i < mSettings.workerCount; ++i)
+                mThreads.push_back(std::thread(&ParallelRecorder::run, this, i));
+        }
+        catch (...)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mStopping = true;
+            }
+
+            mJobReady.notify_all();
+            for (std::thread& thread : mThreads)
+                thread.join();
+
+            throw;
+        }
+    }
+
+    ParallelRecorder::~ParallelRecorder()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopping = true;
+        }
+
+        mJobReady.notify_all();
+        for (std::thread& thread : mThreads)
+            thread.join();
+    }
+
+    void ParallelRecorder::beginFrame()
+    {
+        mPools.beginFrame();
+    }
+
+    std::vector<VkCommandBuffer> ParallelRecorder::record(uint32_t itemCount,
+        const RecordFunction& function, const VkCommandBufferInheritanceInfo* inheritance)
+    {
+        assert(function);
+        assert(inheritance || mSettings.level == VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+        std::lock_guard<std::mutex> recordLock(mRecordMutex);
+        if (itemCount == 0)
+            return std::vector<VkCommandBuffer>();
+
+        uint32_t threadCount = getThreadCount();
+        uint32_t chunkCount = std::max(1u, itemCount / mSettings.minChunkItems);
+        chunkCount = std::min(chunkCount, threadCount * mSettings.chunksPerThread);
+
+        {
+            // Workers still leaving the last job must be gone before its
+            // state is replaced
+            std::unique_lock<std::mutex> lock(mMutex);
+            mJobDone.wait(lock, [this]() { return mBusy == 0; });
+
+            mFunction = &function;
+            mInheritance = inheritance;
+            mItemCount = itemCount;
+            mChunkCount = chunkCount;
+            mResults.assign(chunkCount, VK_NULL_HANDLE);
+            mRemaining.store(chunkCount, std::memory_order_relaxed);
+            mError = nullptr;
+
+            // Each thread starts on its own contiguous run of chunks
+            for (uint32_t thread = 0; thread < threadCount; ++thread)
+            {
+                Range& range = mRanges[thread];
+                std::lock_guard<std::mutex> rangeLock(range.mutex);
+                range.begin = static_cast<uint32_t>(
+                    static_cast<uint64_t>(chunkCount) * thread / threadCount);
+                range.end = static_cast<uint32_t>(
+                    static_cast<uint64_t>(chunkCount) * (thread + 1) / threadCount);
+            }
+
+            ++mGeneration;
+        }
+
+        mJobReady.notify_all();
+
+        // The calling thread records with the last pool of the set
+        work(threadCount - 1);
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        mJobDone.wait(lock, [this]()
+        {
+            return mRemaining.load(std::memory_order_acquire) == 0;
+        });
+
+        if (mError)
+        {
+            std::exception_ptr error = mError;
+            mError = nullptr;
+            std::rethrow_exception(error);
+        }
+
+        std::vector<VkCommandBuffer> results;
+        results.swap(mResults);
+        return results;
+    }
+
+    void ParallelRecorder::execute(VkCommandBuffer primary,
+        const std::vector<VkCommandBuffer>& commandBuffers)
+    {
+        if (commandBuffers.empty())
+            return;
+
+        mDevice.getDispatch().vkCmdExecuteCommands(primary,
+            static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+    }
+
+    void ParallelRecorder::submit(Queue& queue,
+        const std::vector<VkCommandBuffer>& commandBuffers, VkFence fence)
+    {
+        VkSubmitInfo info;
+        info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        info.pNext = nullptr;
+        info.waitSemaphoreCount = 0;
+        info.pWaitSemaphores = nullptr;
+        info.pWaitDstStageMask = nullptr;
+        info.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+        info.pCommandBuffers = commandBuffers.data();
+        info.signalSemaphoreCount = 0;
+        info.pSignalSemaphores = nullptr;
+
+        queue.submit(info, fence);
+    }
+
+    uint32_t ParallelRecorder::getThreadCount() const
+    {
+        return mSettings.workerCount + 1;
+    }
+
+    void ParallelRecorder::run(uint32_t thread)
+    {
+        uint64_t generation = 0;
+
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mJobReady.wait(lock, [this, generation]()
+                {
+                    return mStopping || mGeneration != generation;
+                });
+
+                if (mStopping)
+                    return;
+
+                generation = mGeneration;
+                ++mBusy;
+            }
+
+            work(thread);
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (--mBusy == 0)
+                mJobDone.notify_all();
+        }
+    }
+
+    void ParallelRecorder::work(uint32_t thread)
+    {
+        for (;;)
+        {
+            uint32_t chunk;
+            if (take(thread, chunk))
+                recordChunk(thread, chunk);
+            else if (!steal(thread))
+                return;
+        }
+    }
+
+    bool ParallelRecorder::take(uint32_t thread, uint32_t& chunk)
+    {
+        Range& range = mRanges[thread];
+        std::lock_guard<std::mutex> lock(range.mutex);
+        if (range.begin == range.end)
+            return false;
+
+        chunk = range.begin++;
+        return true;
+    }
+
+    bool ParallelRecorder::steal(uint32_t thread)
+    {
+        for (;;)
+        {
+            // Pick the thread with the most chunks left
+            Range* victim = nullptr;
+            uint32_t most = 0;
+            for (uint32_t other = 0; other < mRanges.size(); ++other)
+            {
+                if (other == thread)
+                    continue;
+
+                Range& range = mRanges[other];
+                std::lock_guard<std::mutex> lock(range.mutex);
+                if (range.end - range.begin > most)
+                {
+                    victim = &range;
+                    most = range.end - range.begin;
+                }
+            }
+
+            if (!victim)
+                return false;
+
+            // Take the upper half, leaving the victim the chunks it is about
+            // to reach. The thief's own range is only locked after letting
+            // go of the victim's, so two thieves can't wait on each other.
+            uint32_t begin;
+            uint32_t end;
+            {
+                std::lock_guard<std::mutex> lock(victim->mutex);
+                if (victim->begin == victim->end)
+                    continue;
+
+                end = victim->end;
+                begin = victim->begin + (victim->end - victim->begin) / 2;
+                victim->end = begin;
+            }
+
+            Range& own = mRanges[thread];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            own.begin = begin;
+            own.end = end;
+            return true;
+        }
+    }
+
+    void ParallelRecorder::recordChunk(uint32_t thread, uint32_t chunk)
+    {
+        uint32_t first = static_cast<uint32_t>(
+            static_cast<uint64_t>(mItemCount) * chunk / mChunkCount);
+        uint32_t last = static_cast<uint32_t>(
+            static_cast<uint64_t>(mItemCount) * (chunk + 1) / mChunkCount);
+
+        try
+        {
+            VkCommandBuffer commandBuffer = mPools.allocate(thread, mSettings.level);
+
+            VkCommandBufferBeginInfo beginInfo;
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.pNext = nullptr;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            beginInfo.pInheritanceInfo = nullptr;
+
+            if (mSettings.level == VK_COMMAND_BUFFER_LEVEL_SECONDARY)
+            {
+                beginInfo.pInheritanceInfo = mInheritance;
+                if (mInheritance->renderPass != VK_NULL_HANDLE)
+                    beginInfo.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+            }
+
+            const DeviceDispatch& dispatch = mDevice.getDispatch();
+            VkResult result = dispatch.vkBeginCommandBuffer(commandBuffer, &beginInfo);
+            if (result != VK_SUCCESS)
+                throw Exception("vw::ParallelRecorder::record", result);
+
+            (*mFunction)(commandBuffer, first, last - first, thread);
+
+            result = dispatch.vkEndCommandBuffer(commandBuffer);
+            if (result != VK_SUCCESS)
+                throw Exception("vw::ParallelRecorder::record", result);
+
+            mResults[chunk] = commandBuffer;
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (!mError)
+                mError = std::current_exception();
+        }
+
+        if (mRemaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mJobDone.notify_all();
+        }
+    }
+}
@@ -1,60 +1,68 @@
 #include "vw/physicaldevice.h"
 
 #include <cassert>
+#include <utility>
 
+#include "vw/devicecapabilities.h"
 #include "vw/queuefamily.h"
 
 namespace vw
 {
     PhysicalDevice::PhysicalDevice(VkPhysicalDevice handle)
-        : mHandle(handle)
     {
-        if (*this)
-            vkGetPhysicalDeviceProperties(mHandle, &mProperties);
+        if (handle != VK_NULL_HANDLE)
+            mCapabilities = std::make_shared<DeviceCapabilities>(handle);
+    }
+
+    PhysicalDevice::PhysicalDevice(CapabilitiesPtr capabilities)
+        : mCapabilities(std::move(capabilities))
+    {
     }
 
     PhysicalDevice::operator bool() const
     {
-        return mHandle != VK_NULL_HANDLE;
+        return mCapabilities && mCapabilities->getHandle() != VK_NULL_HANDLE;
     }
 
     uint32_t PhysicalDevice::getApiVersion() const
     {
-        return mProperties.apiVersion;
+        return mCapabilities->getProperties().apiVersion;
     }
 
     uint32_t PhysicalDevice::getDriverVersion() const
     {
-        return mProperties.driverVersion;
+        return mCapabilities->getProperties().driverVersion;
     }
 
     uint32_t PhysicalDevice::getVendorId() const
     {
-        return mProperties.vendorID;
+        return mCapabilities->getProperties().vendorID;
     }
 
     uint32_t PhysicalDevice::getDeviceId() const
     {
-        return mProperties.deviceID;
+        return mCapabilities->getProperties().deviceID;
     }
 
     PhysicalDevice::Type PhysicalDevice::getDeviceType() const
     {
-        return static_cast<Type>(mProperties.deviceType);
+        return static_cast<Type>(mCapabilities->getProperties().deviceType);
     }
 
     std::string PhysicalDevice::getDeviceName() const
     {
-        const char* name = &mProperties.deviceName[0];
+        const char* name = &mCapabilities->getProperties().deviceName[0];
         return std::string(name, VK_MAX_PHYSICAL_DEVICE_NAME_SIZE);
     }
 
     PhysicalDevice::Uuid PhysicalDevice::getPipelineCacheUuid() const
     {
+        const VkPhysicalDeviceProperties& properties = mCapabilities->getProperties();
+
         Uuid id;
         for (size_t i = 0; i < VK_UUID_SIZE; ++i)
         {
-            id[i] = mProperties.pipelineCacheUUID[i];
+            id[i] = properties.pipelineCacheUUID[i];
         }
 
         return id;
@@ -62,30 +70,40 @@ namespace vw
 
     const VkPhysicalDeviceLimits& PhysicalDevice::getDeviceLimits() const
     {
-        return mProperties.limits;
+        return mCapabilities->getProperties().limits;
     }
 
     const VkPhysicalDeviceSparseProperties& PhysicalDevice::getDeviceSparseProperties() const
     {
-        return mProperties.sparseProperties;
+        return mCapabilities->getProperties().sparseProperties;
     }
 
-    PhysicalDevice::QueueFamilyList PhysicalDevice::getDeviceQueueFamilies() const
+    const VkPhysicalDeviceMemoryProperties& PhysicalDevice::getMemoryProperties() const
     {
         assert(*this);
+        return mCapabilities->getMemoryProperties();
+    }
 
-        // Read properties from device
-        uint32_t count = 0;
-        std::vector<VkQueueFamilyProperties> properties;
+    const VkPhysicalDeviceFeatures& PhysicalDevice::getFeatures() const
+    {
+        assert(*this);
+        return mCapabilities->getFeatures();
+    }
 
-        vkGetPhysicalDeviceQueueFamilyProperties(mHandle, &count, nullptr);
-        properties.resize(count);
-        vkGetPhysicalDeviceQueueFamilyProperties(mHandle, &count, properties.data());
+    bool PhysicalDevice::hasExtension(const std::string& name) const
+    {
+        assert(*this);
+        return mCapabilities->hasExtension(name);
+    }
+
+    PhysicalDevice::QueueFamilyList PhysicalDevice::getDeviceQueueFamilies() const
+    {
+        assert(*this);
 
         // Return list
         size_t index = 0;
         QueueFamilyList list;
-        for (auto it : properties)
+        for (const VkQueueFamilyProperties& it : mCapabilities->getQueueFamilyProperties())
         {
             list.push_back(QueueFamily(index++, it));
         }
@@ -94,6 +112,11 @@ namespace vw
 
     VkPhysicalDevice PhysicalDevice::getHandle() const
     {
-        return mHandle;
+        return (mCapabilities) ? mCapabilities->getHandle() : VK_NULL_HANDLE;
+    }
+
+    const PhysicalDevice::CapabilitiesPtr& PhysicalDevice::getCapabilities() const
+    {
+        return mCapabilities;
     }
 }
@@ -0,0 +1,282 @@
+#include "vw/pipelinecache.h"
+
+#include <cassert>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "vw/device.h"
+#include "vw/devicedispatch.h"
+#include "vw/exception.h"
+#include "fileutil.h"
+
+namespace vw
+{
+    namespace
+    {
+        const char FileMagic[4] = { 'V', 'W', 'P', 'C' };
+        const uint32_t FileVersion = 1;
+
+        // Written in front of the driver's data. The driver's own header does
+        // not include the driver version, so it is recorded here.
+        struct FileHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint32_t vendorId;
+            uint32_t deviceId;
+            uint32_t driverVersion;
+            uint8_t uuid[VK_UUID_SIZE];
+            uint64_t dataSize;
+            uint64_t checksum;
+        };
+
+        // A read only mapping of a whole file
+        class MappedFile
+        {
+            public:
+
+                explicit MappedFile(const std::string& path)
+                    : mData(nullptr)
+                    , mSize(0)
+                {
+                    int fd = open(path.c_str(), O_RDONLY);
+                    if (fd < 0)
+                        return;
+
+                    struct stat info;
+                    if (fstat(fd, &info) == 0 && info.st_size > 0)
+                    {
+                        void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                        if (data != MAP_FAILED)
+                        {
+                            mData = static_cast<const char*>(data);
+                            mSize = static_cast<size_t>(info.st_size);
+                        }
+                    }
+
+                    close(fd);
+                }
+
+                ~MappedFile()
+                {
+                    if (mData)
+                        munmap(const_cast<char*>(mData), mSize);
+                }
+
+                const char* getData() const { return mData; }
+                size_t getSize() const { return mSize; }
+
+            private:
+
+                MappedFile(const MappedFile&) = delete;
+                MappedFile& operator=(const MappedFile&) = delete;
+
+                const char* mData;
+                size_t mSize;
+        };
+    }
+
+    PipelineCache::PipelineCache(Device& device, const std::string& path,
+        uint32_t threadCount, std::chrono::seconds saveInterval)
+        : mDevice(device)
+        , mPath(path)
+        , mSaveInterval(saveInterval)
+        , mLoaded(false)
+        , mLastSave(Clock::now())
+        , mMergedCache(VK_NULL_HANDLE)
+    {
+        assert(mDevice);
+        assert(threadCount > 0);
+
+        // The driver copies the initial data, so the mapping only has to
+        // outlive cache creation
+        MappedFile file(mPath);
+        const void* data = nullptr;
+        size_t size = 0;
+        if (isValid(file.getData(), file.getSize()))
+        {
+            data = file.getData() + sizeof(FileHeader);
+            size = file.getSize() - sizeof(FileHeader);
+            mLoaded = true;
+        }
+
+        try
+        {
+            mMergedCache = createCache(data, size);
+
+            mThreadCaches.reserve(threadCount);
+            for (uint32_t i = 0; i < threadCount; ++i)
+                mThreadCaches.push_back(createCache(data, size));
+        }
+        catch (...)
+        {
+            destroy();
+            throw;
+        }
+    }
+
+    PipelineCache::~PipelineCache()
+    {
+        try
+        {
+            save();
+        }
+        catch (...)
+        {
+        }
+
+        destroy();
+    }
+
+    VkPipelineCache PipelineCache::getHandle(uint32_t thread)
+    {
+        assert(thread < mThreadCaches.size());
+        return mThreadCaches[thread];
+    }
+
+    bool PipelineCache::wasLoaded() const
+    {
+        return mLoaded;
+    }
+
+    bool PipelineCache::save()
+    {
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+        VkDevice device = mDevice.getHandle();
+        std::lock_guard<std::mutex> lock(mSaveMutex);
+
+        mLastSave = Clock::now();
+
+        // Only the destination of a merge is externally synchronized, so
+        // threads may keep compiling into their caches meanwhile
+        VkResult result = dispatch.vkMergePipelineCaches(device, mMergedCache,
+            static_cast<uint32_t>(mThreadCaches.size()), mThreadCaches.data());
+        if (result != VK_SUCCESS)
+            throw Exception("vw::PipelineCache::save", result);
+
+        size_t size = 0;
+        result = dispatch.vkGetPipelineCacheData(device, mMergedCache, &size, nullptr);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::PipelineCache::save", result);
+
+        std::vector<char> data(sizeof(FileHeader) + size);
+        result = dispatch.vkGetPipelineCacheData(device, mMergedCache, &size,
+            data.data() + sizeof(FileHeader));
+        if (result != VK_SUCCESS && result != VK_INCOMPLETE)
+            throw Exception("vw::PipelineCache::save", result);
+        data.resize(sizeof(FileHeader) + size);
+
+        const PhysicalDevice& physicalDevice = mDevice.getPhysicalDevice();
+        PhysicalDevice::Uuid uuid = physicalDevice.getPipelineCacheUuid();
+
+        FileHeader header;
+        std::memcpy(header.magic, FileMagic, sizeof(FileMagic));
+        header.version = FileVersion;
+        header.vendorId = physicalDevice.getVendorId();
+        header.deviceId = physicalDevice.getDeviceId();
+        header.driverVersion = physicalDevice.getDriverVersion();
+        std::memcpy(header.uuid, uuid.data(), VK_UUID_SIZE);
+        header.dataSize = size;
+        header.checksum = computeChecksum(data.data() + sizeof(FileHeader), size);
+        std::memcpy(data.data(), &header, sizeof(FileHeader));
+
+        return write(data);
+    }
+
+    bool PipelineCache::saveIfDue()
+    {
+        if (mSaveInterval.count() == 0)
+            return false;
+
+        {
+            std::lock_guard<std::mutex> lock(mSaveMutex);
+            if (Clock::now() - mLastSave < mSaveInterval)
+                return false;
+        }
+
+        return save();
+    }
+
+    uint32_t PipelineCache::getThreadCount() const
+    {
+        return static_cast<uint32_t>(mThreadCaches.size());
+    }
+
+    VkPipelineCache PipelineCache::createCache(const void* data, size_t size)
+    {
+        VkPipelineCacheCreateInfo cinfo;
+        cinfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cinfo.pNext = nullptr;
+        cinfo.flags = 0;
+        cinfo.initialDataSize = size;
+        cinfo.pInitialData = data;
+
+        VkPipelineCache cache = VK_NULL_HANDLE;
+        VkResult result = mDevice.getDispatch().vkCreatePipelineCache(mDevice.getHandle(),
+            &cinfo, mDevice.getAllocationCallbacks(), &cache);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::PipelineCache::PipelineCache", result);
+
+        return cache;
+    }
+
+    bool PipelineCache::isValid(const char* file, size_t size) const
+    {
+        if (!file || size < sizeof(FileHeader) + sizeof(VkPipelineCacheHeaderVersionOne))
+            return false;
+
+        FileHeader header;
+        std::memcpy(&header, file, sizeof(FileHeader));
+
+        const PhysicalDevice& physicalDevice = mDevice.getPhysicalDevice();
+        PhysicalDevice::Uuid uuid = physicalDevice.getPipelineCacheUuid();
+
+        if (std::memcmp(header.magic, FileMagic, sizeof(FileMagic)) != 0 ||
+            header.version != FileVersion ||
+            header.vendorId != physicalDevice.getVendorId() ||
+            header.deviceId != physicalDevice.getDeviceId() ||
+            header.driverVersion != physicalDevice.getDriverVersion() ||
+            std::memcmp(header.uuid, uuid.data(), VK_UUID_SIZE) != 0 ||
+            header.dataSize != size - sizeof(FileHeader))
+        {
+            return false;
+        }
+
+        const char* data = file + sizeof(FileHeader);
+        if (header.checksum != computeChecksum(data, header.dataSize))
+            return false;
+
+        // Check the driver's header as well, since a driver may not validate
+        // it thoroughly
+        VkPipelineCacheHeaderVersionOne cacheHeader;
+        std::memcpy(&cacheHeader, data, sizeof(cacheHeader));
+        return cacheHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+            cacheHeader.vendorID == header.vendorId &&
+            cacheHeader.deviceID == header.deviceId &&
+            std::memcmp(cacheHeader.pipelineCacheUUID, uuid.data(), VK_UUID_SIZE) == 0;
+    }
+
+    bool PipelineCache::write(const std::vector<char>& data)
+    {
+        return writeFileAtomically(mPath, data.data(), data.size());
+    }
+
+    void PipelineCache::destroy()
+    {
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+
+        for (VkPipelineCache cache : mThreadCaches)
+            dispatch.vkDestroyPipelineCache(mDevice.getHandle(),
+                cache, mDevice.getAllocationCallbacks());
+        mThreadCaches.clear();
+
+        if (mMergedCache != VK_NULL_HANDLE)
+            dispatch.vkDestroyPipelineCache(mDevice.getHandle(),
+                mMergedCache, mDevice.getAllocationCallbacks());
+        mMergedCache = VK_NULL_HANDLE;
+    }
+}
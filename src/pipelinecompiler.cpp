@@ -0,0 +1,174 @@
+#include "vw/pipelinecompiler.h"
+
+#include <cassert>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <utility>
+
+#include "vw/device.h"
+#include "vw/devicedispatch.h"
+#include "vw/exception.h"
+#include "vw/pipelinecache.h"
+#include "vw/threadpool.h"
+
+namespace vw
+{
+    PipelineCompiler::PipelineCompiler(Device& device, ThreadPool& pool,
+        PipelineCache* cache)
+        : mDevice(device)
+        , mPool(pool)
+        , mCache(cache)
+    {
+        assert(mDevice);
+        assert(!mCache || mCache->getThreadCount() >= mPool.getThreadCount());
+    }
+
+    PipelineCompiler::~PipelineCompiler()
+    {
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+
+        // Scheduled work refers to this object, so it must finish first
+        for (auto& pair : mEntries)
+        {
+            Entry& entry = pair.second;
+            if (!entry.scheduled)
+                continue;
+
+            try
+            {
+                VkPipeline pipeline = entry.future.get();
+                dispatch.vkDestroyPipeline(mDevice.getHandle(),
+                    pipeline, mDevice.getAllocationCallbacks());
+            }
+            catch (...)
+            {
+            }
+        }
+    }
+
+    void PipelineCompiler::add(const std::string& name, Builder builder)
+    {
+        assert(builder);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        Entry& entry = mEntries[name];
+        if (entry.scheduled)
+            return;
+
+        entry.builder = std::move(builder);
+        entry.scheduled = false;
+        entry.requested = false;
+    }
+
+    void PipelineCompiler::addCompute(const std::string& name,
+        const VkComputePipelineCreateInfo& info)
+    {
+        // Keep a copy of the entry point name, which is often a temporary
+        std::string entryPoint = info.stage.pName;
+        add(name, [info, entryPoint](Device& device, VkPipelineCache cache)
+        {
+            VkComputePipelineCreateInfo cinfo = info;
+            cinfo.stage.pName = entryPoint.c_str();
+
+            VkPipeline pipeline = VK_NULL_HANDLE;
+            VkResult result = device.getDispatch().vkCreateComputePipelines(
+                device.getHandle(), cache, 1, &cinfo, device.getAllocationCallbacks(),
+                &pipeline);
+            if (result != VK_SUCCESS)
+                throw Exception("vw::PipelineCompiler::addCompute", result);
+
+            return pipeline;
+        });
+    }
+
+    PipelineCompiler::Future PipelineCompiler::request(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        auto it = mEntries.find(name);
+        assert(it != mEntries.end() && "The pipeline was not added");
+        if (it == mEntries.end())
+            return Future();
+
+        Entry& entry = it->second;
+        if (!entry.requested)
+        {
+            entry.requested = true;
+            mTrace.push_back(name);
+        }
+
+        return entry.scheduled ? entry.future : schedule(entry);
+    }
+
+    void PipelineCompiler::prewarm(const NameList& names)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        // The pool runs tasks in order, so the first used compile first
+        for (const std::string& name : names)
+        {
+            auto it = mEntries.find(name);
+            if (it != mEntries.end() && !it->second.scheduled)
+                schedule(it->second);
+        }
+    }
+
+    PipelineCompiler::NameList PipelineCompiler::getTrace() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mTrace;
+    }
+
+    bool PipelineCompiler::saveTrace(const std::string& path) const
+    {
+        NameList trace = getTrace();
+
+        std::ofstream file(path.c_str(), std::ios::trunc);
+        for (const std::string& name : trace)
+            file << name << '\n';
+
+        file.flush();
+        return static_cast<bool>(file);
+    }
+
+    PipelineCompiler::NameList PipelineCompiler::loadTrace(const std::string& path)
+    {
+        NameList names;
+
+        std::ifstream file(path.c_str());
+        std::string name;
+        while (std::getline(file, name))
+        {
+            if (!name.empty())
+                names.push_back(name);
+        }
+
+        return names;
+    }
+
+    PipelineCompiler::Future PipelineCompiler::schedule(Entry& entry)
+    {
+        std::shared_ptr<std::promise<VkPipeline>> promise =
+            std::make_shared<std::promise<VkPipeline>>();
+
+        entry.future = promise->get_future().share();
+        entry.scheduled = true;
+
+        Builder builder = entry.builder;
+        mPool.enqueue([this, builder, promise](uint32_t thread)
+        {
+            VkPipelineCache cache = (mCache) ? mCache->getHandle(thread) : VK_NULL_HANDLE;
+            try
+            {
+                promise->set_value(builder(mDevice, cache));
+            }
+            catch (...)
+            {
+                promise->set_exception(std::current_exception());
+            }
+        });
+
+        return entry.future;
+    }
+}
@@ -1,11 +1,19 @@
 #include "vw/queue.h"
 
+#include <cassert>
+
+#include "vw/devicedispatch.h"
+#include "vw/exception.h"
+
 namespace vw
 {
-    Queue::Queue(uint32_t family, uint32_t index, VkQueue handle)
+    Queue::Queue(uint32_t family, uint32_t index, VkQueue handle,
+        const DeviceDispatch* dispatch)
         : mFamily(family)
         , mIndex(index)
         , mHandle(handle)
+        , mDispatch(dispatch)
+        , mMutex(std::make_shared<std::mutex>())
     {
     }
 
@@ -24,6 +32,42 @@ namespace vw
         return mIndex;
     }
 
+    void Queue::submit(uint32_t count, const VkSubmitInfo* infos, VkFence fence)
+    {
+        assert(*this);
+
+        std::lock_guard<std::mutex> lock(*mMutex);
+        VkResult result = mDispatch->vkQueueSubmit(mHandle, count, infos, fence);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::Queue::submit", result);
+    }
+
+    void Queue::submit(const VkSubmitInfo& info, VkFence fence)
+    {
+        submit(1, &info, fence);
+    }
+
+    void Queue::waitIdle()
+    {
+        assert(*this);
+
+        std::lock_guard<std::mutex> lock(*mMutex);
+        VkResult result = mDispatch->vkQueueWaitIdle(mHandle);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::Queue::waitIdle", result);
+    }
+
+    std::mutex& Queue::getMutex() const
+    {
+        return *mMutex;
+    }
+
+    const DeviceDispatch& Queue::getDispatch() const
+    {
+        assert(mDispatch);
+        return *mDispatch;
+    }
+
     VkQueue Queue::getHandle()
     {
         return mHandle;
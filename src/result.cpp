@@ -0,0 +1,54 @@
+#include "vw/result.h"
+
+namespace vw
+{
+    namespace
+    {
+        struct ResultString
+        {
+            VkResult result;
+            const char* string;
+        };
+
+        constexpr ResultString ResultStrings[] =
+        {
+            { VK_SUCCESS, "Vulkan command completed successfully." },
+            { VK_NOT_READY, "Vulkan fence or query not ready." },
+            { VK_TIMEOUT, "Vulkan operation timed out." },
+            { VK_EVENT_SET, "Vulkan event is signaled." },
+            { VK_EVENT_RESET, "Vulkan event is unsignaled." },
+            { VK_INCOMPLETE, "Vulkan return array is too small for the result." },
+            { VK_ERROR_OUT_OF_HOST_MEMORY, "Vulkan host failed to allocate memory." },
+            { VK_ERROR_OUT_OF_DEVICE_MEMORY, "Vulkan device failed to allocate memory." },
+            { VK_ERROR_INITIALIZATION_FAILED, "Vulkan failed to create object." },
+            { VK_ERROR_DEVICE_LOST, "Vulkan physical or logical device lost." },
+            { VK_ERROR_MEMORY_MAP_FAILED, "Vulkan mapping of memory object failed." },
+            { VK_ERROR_LAYER_NOT_PRESENT, "Vulkan layer that was requested not present." },
+            { VK_ERROR_EXTENSION_NOT_PRESENT,
+                "Vulkan extension that was requested not present." },
+            { VK_ERROR_FEATURE_NOT_PRESENT,
+                "Vulkan feature that was requested not supported." },
+            { VK_ERROR_INCOMPATIBLE_DRIVER,
+                "Vulkan api compatible with requested version not available." },
+            { VK_ERROR_TOO_MANY_OBJECTS,
+                "Vulkan exceeded maximum number of allowed objects for type." },
+            { VK_ERROR_FORMAT_NOT_SUPPORTED,
+                "Vulkan format that was requested not supported by device." },
+            { VK_ERROR_FRAGMENTED_POOL,
+                "Vulkan pool allocation failed due to memory fragmentation." },
+            { VK_ERROR_OUT_OF_POOL_MEMORY,
+                "Vulkan pool allocation failed due to lack of space in the pool." }
+        };
+    }
+
+    const char* getResultString(VkResult result) noexcept
+    {
+        for (const ResultString& entry : ResultStrings)
+        {
+            if (entry.result == result)
+                return entry.string;
+        }
+
+        return "Vulkan unhandled error code.";
+    }
+}
@@ -0,0 +1,319 @@
+#include "vw/shadermodulecache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "vw/devicedispatch.h"
+#include "vw/exception.h"
+
+#include "hash.h"
+
+namespace vw
+{
+    namespace
+    {
+        // SPIR-V opcodes of the instructions stripping looks at
+        const uint32_t OpSourceContinued = 2;
+        const uint32_t OpSource = 3;
+        const uint32_t OpSourceExtension = 4;
+        const uint32_t OpName = 5;
+        const uint32_t OpMemberName = 6;
+        const uint32_t OpString = 7;
+        const uint32_t OpLine = 8;
+        const uint32_t OpExtension = 10;
+        const uint32_t OpExtInstImport = 11;
+        const uint32_t OpExtInst = 12;
+        const uint32_t OpNoLine = 317;
+        const uint32_t OpModuleProcessed = 330;
+
+        const size_t HeaderWordCount = 5;
+        const uint32_t MagicNumber = 0x07230203;
+
+        // Compares a literal string operand, which is nul terminated and
+        // padded to whole words
+        bool startsWith(const uint32_t* words, size_t wordCount, const char* prefix)
+        {
+            size_t length = std::strlen(prefix);
+            if (length > wordCount * sizeof(uint32_t))
+                return false;
+
+            return std::memcmp(words, prefix, length) == 0;
+        }
+
+        bool isDebug(uint32_t opcode)
+        {
+            switch (opcode)
+            {
+                case OpSourceContinued:
+                case OpSource:
+                case OpSourceExtension:
+                case OpName:
+                case OpMemberName:
+                case OpString:
+                case OpLine:
+                case OpNoLine:
+                case OpModuleProcessed:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+    }
+
+    const size_t ShaderModuleCache::ShardCount;
+
+    bool ShaderModuleCache::Hash::operator==(const Hash& other) const
+    {
+        return low == other.low && high == other.high;
+    }
+
+    VkShaderModule ShaderModuleCache::Module::getHandle() const
+    {
+        return mHandle;
+    }
+
+    const ShaderModuleCache::Hash& ShaderModuleCache::Module::getHash() const
+    {
+        return mHash;
+    }
+
+    bool ShaderModuleCache::Module::isStripped() const
+    {
+        return mStripped;
+    }
+
+    size_t ShaderModuleCache::Module::getCodeSize() const
+    {
+        return mCodeSize;
+    }
+
+    bool ShaderModuleCache::Key::operator==(const Key& other) const
+    {
+        return hash == other.hash && stripped == other.stripped;
+    }
+
+    size_t ShaderModuleCache::KeyHasher::operator()(const Key& key) const
+    {
+        return static_cast<size_t>(key.hash.low ^ ((key.stripped) ? HashPrime : 0));
+    }
+
+    ShaderModuleCache::ShaderModuleCache(VkDevice device, const DeviceDispatch& dispatch,
+        const VkAllocationCallbacks* callbacks)
+        : mDevice(device)
+        , mDispatch(dispatch)
+        , mCallbacks(callbacks)
+        , mModuleCount(0)
+        , mHits(0)
+        , mMisses(0)
+        , mStrippedBytes(0)
+    {
+    }
+
+    ShaderModuleCache::~ShaderModuleCache()
+    {
+        // Handles refer back to the cache to release their module
+        assert(mModuleCount.load() == 0);
+    }
+
+    ShaderModuleCache::ModulePtr ShaderModuleCache::acquire(const uint32_t* code,
+        size_t codeSize, bool strip)
+    {
+        assert(code && codeSize > 0 && codeSize % sizeof(uint32_t) == 0);
+
+        Key key;
+        key.hash = hash(code, codeSize);
+        key.stripped = strip;
+
+        Shard& shard = getShard(key);
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.modules.find(key);
+            if (it != shard.modules.end())
+            {
+                ModulePtr module = it->second.lock();
+                if (module)
+                {
+                    mHits.fetch_add(1, std::memory_order_relaxed);
+                    return module;
+                }
+            }
+        }
+
+        // Parsing can take a while, so other lookups of the shard go on
+        ModulePtr created = create(key, code, codeSize);
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        std::weak_ptr<const Module>& entry = shard.modules[key];
+        ModulePtr existing = entry.lock();
+        if (existing)
+        {
+            // Another thread created it first. Ours is released once the
+            // lock is no longer held.
+            mHits.fetch_add(1, std::memory_order_relaxed);
+            return existing;
+        }
+
+        mMisses.fetch_add(1, std::memory_order_relaxed);
+        entry = created;
+        return created;
+    }
+
+    size_t ShaderModuleCache::getModuleCount() const
+    {
+        return mModuleCount.load(std::memory_order_relaxed);
+    }
+
+    ShaderModuleCache::Statistics ShaderModuleCache::getStatistics() const
+    {
+        Statistics statistics;
+        statistics.hits = mHits.load(std::memory_order_relaxed);
+        statistics.misses = mMisses.load(std::memory_order_relaxed);
+        statistics.strippedBytes = mStrippedBytes.load(std::memory_order_relaxed);
+        return statistics;
+    }
+
+    ShaderModuleCache::Hash ShaderModuleCache::hash(const uint32_t* code, size_t codeSize)
+    {
+        Hash result;
+        hashWords(code, codeSize / sizeof(uint32_t), result.low, result.high);
+        return result;
+    }
+
+    std::vector<uint32_t> ShaderModuleCache::strip(const uint32_t* code, size_t codeSize)
+    {
+        size_t wordCount = codeSize / sizeof(uint32_t);
+        std::vector<uint32_t> original(code, code + wordCount);
+        if (wordCount < HeaderWordCount || code[0] != MagicNumber)
+            return original;
+
+        // Find the non-semantic instruction sets, and check every
+        // instruction fits before dropping anything
+        std::vector<uint32_t> nonSemanticSets;
+        for (size_t i = HeaderWordCount; i < wordCount;)
+        {
+            uint32_t length = code[i] >> 16;
+            uint32_t opcode = code[i] & 0xffff;
+            if (length == 0 || length > wordCount - i)
+                return original;
+
+            if (opcode == OpExtInstImport && length > 2)
+            {
+                // Other debug sets such as OpenCL.DebugInfo.100 are semantic
+                // and refer to the results of OpString and OpSource
+                if (startsWith(code + i + 2, length - 2, "NonSemantic."))
+                {
+                    nonSemanticSets.push_back(code[i + 1]);
+                }
+                else if (startsWith(code + i + 2, length - 2, "OpenCL.DebugInfo.") ||
+                    startsWith(code + i + 2, length - 2, "DebugInfo"))
+                {
+                    return original;
+                }
+            }
+
+            i += length;
+        }
+
+        std::vector<uint32_t> stripped;
+        stripped.reserve(wordCount);
+        stripped.insert(stripped.end(), code, code + HeaderWordCount);
+
+        for (size_t i = HeaderWordCount; i < wordCount;)
+        {
+            uint32_t length = code[i] >> 16;
+            uint32_t opcode = code[i] & 0xffff;
+
+            bool drop = isDebug(opcode);
+            if (opcode == OpExtInstImport && length > 1)
+            {
+                drop = std::find(nonSemanticSets.begin(), nonSemanticSets.end(),
+                    code[i + 1]) != nonSemanticSets.end();
+            }
+            else if (opcode == OpExtInst && length > 3)
+            {
+                drop = std::find(nonSemanticSets.begin(), nonSemanticSets.end(),
+                    code[i + 3]) != nonSemanticSets.end();
+            }
+            else if (opcode == OpExtension && length > 1 && !nonSemanticSets.empty())
+            {
+                drop = startsWith(code + i + 1, length - 1, "SPV_KHR_non_semantic_info");
+            }
+
+            if (!drop)
+                stripped.insert(stripped.end(), code + i, code + i + length);
+
+            i += length;
+        }
+
+        return stripped;
+    }
+
+    ShaderModuleCache::Shard& ShaderModuleCache::getShard(const Key& key)
+    {
+        return mShards[key.hash.high % ShardCount];
+    }
+
+    ShaderModuleCache::ModulePtr ShaderModuleCache::create(const Key& key,
+        const uint32_t* code, size_t codeSize)
+    {
+        std::vector<uint32_t> stripped;
+        if (key.stripped)
+        {
+            stripped = strip(code, codeSize);
+            size_t strippedSize = stripped.size() * sizeof(uint32_t);
+            mStrippedBytes.fetch_add(codeSize - strippedSize, std::memory_order_relaxed);
+
+            code = stripped.data();
+            codeSize = strippedSize;
+        }
+
+        VkShaderModuleCreateInfo cinfo;
+        cinfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        cinfo.pNext = nullptr;
+        cinfo.flags = 0;
+        cinfo.codeSize = codeSize;
+        cinfo.pCode = code;
+
+        std::unique_ptr<Module> module(new Module);
+        module->mHandle = VK_NULL_HANDLE;
+        module->mHash = key.hash;
+        module->mStripped = key.stripped;
+        module->mCodeSize = codeSize;
+
+        VkResult result = mDispatch.vkCreateShaderModule(mDevice, &cinfo, mCallbacks,
+            &module->mHandle);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::ShaderModuleCache::acquire", result);
+
+        mModuleCount.fetch_add(1, std::memory_order_relaxed);
+
+        // The deleter runs when the last handle goes, even if that is the
+        // one made here because another thread won the race. Should the
+        // shared_ptr fail to allocate, it runs right away.
+        return ModulePtr(module.release(), [this](const Module* module)
+        {
+            release(const_cast<Module*>(module));
+        });
+    }
+
+    void ShaderModuleCache::release(Module* module)
+    {
+        Key key;
+        key.hash = module->mHash;
+        key.stripped = module->mStripped;
+
+        // Leave the entry alone if it was replaced by a new module
+        {
+            Shard& shard = getShard(key);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.modules.find(key);
+            if (it != shard.modules.end() && it->second.expired())
+                shard.modules.erase(it);
+        }
+
+        mDispatch.vkDestroyShaderModule(mDevice, module->mHandle, mCallbacks);
+        mModuleCount.fetch_sub(1, std::memory_order_relaxed);
+        delete module;
+    }
+}
@@ -0,0 +1,323 @@
+#include "vw/sparsebuffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <mutex>
+
+#include "vw/device.h"
+#include "vw/devicedispatch.h"
+#include "vw/exception.h"
+#include "vw/physicaldevice.h"
+#include "vw/queue.h"
+#include "vw/queuefamily.h"
+#include "vw/syncpool.h"
+
+namespace vw
+{
+    namespace
+    {
+        VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        Queue* findSparseQueue(Device& device)
+        {
+            PhysicalDevice::QueueFamilyList families =
+                device.getPhysicalDevice().getDeviceQueueFamilies();
+
+            for (Queue& queue : device.getQueues())
+            {
+                if (families[queue.getFamilyIndex()].hasSparseBindingSupport())
+                    return &queue;
+            }
+
+            return nullptr;
+        }
+    }
+
+    SparseBuffer::Settings::Settings()
+        : pageSize(0)
+        , memoryFlags(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+    {
+    }
+
+    SparseBuffer::SparseBuffer(Device& device, VkDeviceSize reservedSize,
+        VkBufferUsageFlags usage, const Settings& settings)
+        : mDevice(device)
+        , mQueue(nullptr)
+        , mBuffer(VK_NULL_HANDLE)
+        , mReservedSize(reservedSize)
+        , mPageSize(0)
+        , mMemoryFlags(settings.memoryFlags)
+        , mCommittedSize(0)
+    {
+        assert(mDevice);
+        assert(mReservedSize > 0);
+
+        // Support alone is not enough, the features must have been enabled
+        const VkPhysicalDeviceFeatures& features = mDevice.getEnabledFeatures();
+        if (!features.sparseBinding || !features.sparseResidencyBuffer)
+            throw Exception("vw::SparseBuffer::SparseBuffer", VK_ERROR_FEATURE_NOT_PRESENT);
+
+        mQueue = findSparseQueue(mDevice);
+        if (!mQueue)
+            throw Exception("vw::SparseBuffer::SparseBuffer", VK_ERROR_FEATURE_NOT_PRESENT);
+
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+
+        VkBufferCreateInfo cinfo;
+        cinfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        cinfo.pNext = nullptr;
+        cinfo.flags = VK_BUFFER_CREATE_SPARSE_BINDING_BIT | VK_BUFFER_CREATE_SPARSE_RESIDENCY_BIT;
+        cinfo.size = mReservedSize;
+        cinfo.usage = usage;
+        cinfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        cinfo.queueFamilyIndexCount = 0;
+        cinfo.pQueueFamilyIndices = nullptr;
+
+        VkResult result = dispatch.vkCreateBuffer(mDevice.getHandle(),
+            &cinfo, mDevice.getAllocationCallbacks(), &mBuffer);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::SparseBuffer::SparseBuffer", result);
+
+        // The alignment of a sparse buffer is the size of its sparse blocks
+        dispatch.vkGetBufferMemoryRequirements(mDevice.getHandle(), mBuffer, &mRequirements);
+
+        mPageSize = alignUp(std::max(settings.pageSize, mRequirements.alignment),
+            mRequirements.alignment);
+        mPages.resize(static_cast<size_t>(
+            (mRequirements.size + mPageSize - 1) / mPageSize));
+    }
+
+    SparseBuffer::~SparseBuffer()
+    {
+        // The memory may only be freed once nothing is bound to it
+        mDevice.getDispatch().vkDestroyBuffer(mDevice.getHandle(),
+            mBuffer, mDevice.getAllocationCallbacks());
+
+        MemoryAllocator& allocator = mDevice.getMemoryAllocator();
+        for (Allocation& page : mPages)
+        {
+            if (page)
+                allocator.free(page);
+        }
+    }
+
+    void SparseBuffer::commit(VkDeviceSize offset, VkDeviceSize size)
+    {
+        assert(offset + size <= mReservedSize);
+        if (size == 0)
+            return;
+
+        // Pages touching the range are committed
+        size_t firstPage = static_cast<size_t>(offset / mPageSize);
+        size_t endPage = static_cast<size_t>((offset + size + mPageSize - 1) / mPageSize);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        std::vector<Bind> binds;
+        addCommits(firstPage, endPage, binds);
+        bind(binds);
+    }
+
+    void SparseBuffer::decommit(VkDeviceSize offset, VkDeviceSize size)
+    {
+        assert(offset + size <= mReservedSize);
+
+        // Only pages inside the range are decommitted, so neighbouring data
+        // survives. The last page may be shorter than the others.
+        size_t firstPage = static_cast<size_t>((offset + mPageSize - 1) / mPageSize);
+        size_t endPage = static_cast<size_t>((offset + size) / mPageSize);
+        if (offset + size == mReservedSize)
+            endPage = mPages.size();
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        std::vector<Bind> binds;
+        addDecommits(firstPage, endPage, binds);
+        bind(binds);
+    }
+
+    void SparseBuffer::resize(VkDeviceSize size)
+    {
+        assert(size <= mReservedSize);
+
+        size_t pageCount = static_cast<size_t>((size + mPageSize - 1) / mPageSize);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        std::vector<Bind> binds;
+        addDecommits(pageCount, mPages.size(), binds);
+        addCommits(0, pageCount, binds);
+        bind(binds);
+    }
+
+    bool SparseBuffer::isCommitted(VkDeviceSize offset, VkDeviceSize size) const
+    {
+        assert(offset + size <= mReservedSize);
+
+        size_t firstPage = static_cast<size_t>(offset / mPageSize);
+        size_t endPage = static_cast<size_t>((offset + size + mPageSize - 1) / mPageSize);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (size_t page = firstPage; page < endPage; ++page)
+        {
+            if (!mPages[page])
+                return false;
+        }
+
+        return true;
+    }
+
+    VkDeviceSize SparseBuffer::getReservedSize() const
+    {
+        return mReservedSize;
+    }
+
+    VkDeviceSize SparseBuffer::getCommittedSize() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mCommittedSize;
+    }
+
+    VkDeviceSize SparseBuffer::getPageSize() const
+    {
+        return mPageSize;
+    }
+
+    Queue& SparseBuffer::getQueue()
+    {
+        return *mQueue;
+    }
+
+    VkBuffer SparseBuffer::getBuffer()
+    {
+        return mBuffer;
+    }
+
+    VkDeviceSize SparseBuffer::getPageBytes(size_t page) const
+    {
+        VkDeviceSize offset = page * mPageSize;
+        return std::min(mPageSize, mRequirements.size - offset);
+    }
+
+    void SparseBuffer::addCommits(size_t firstPage, size_t endPage, std::vector<Bind>& binds)
+    {
+        MemoryAllocator& allocator = mDevice.getMemoryAllocator();
+        size_t firstBind = binds.size();
+
+        try
+        {
+            for (size_t page = firstPage; page < endPage; ++page)
+            {
+                if (mPages[page])
+                    continue;
+
+                VkMemoryRequirements requirements = mRequirements;
+                requirements.size = getPageBytes(page);
+                binds.emplace_back(page, allocator.allocate(requirements, mMemoryFlags));
+            }
+        }
+        catch (...)
+        {
+            for (size_t i = firstBind; i < binds.size(); ++i)
+                allocator.free(binds[i].second);
+            binds.resize(firstBind);
+            throw;
+        }
+    }
+
+    void SparseBuffer::addDecommits(size_t firstPage, size_t endPage, std::vector<Bind>& binds)
+    {
+        for (size_t page = firstPage; page < endPage; ++page)
+        {
+            if (mPages[page])
+                binds.emplace_back(page, Allocation());
+        }
+    }
+
+    void SparseBuffer::bind(std::vector<Bind>& binds)
+    {
+        if (binds.empty())
+            return;
+
+        std::vector<VkSparseMemoryBind> memoryBinds(binds.size());
+        for (size_t i = 0; i < binds.size(); ++i)
+        {
+            const Allocation& allocation = binds[i].second;
+
+            VkSparseMemoryBind& memoryBind = memoryBinds[i];
+            memoryBind.resourceOffset = binds[i].first * mPageSize;
+            memoryBind.size = getPageBytes(binds[i].first);
+            memoryBind.memory = (allocation) ? allocation.getMemory() : VK_NULL_HANDLE;
+            memoryBind.memoryOffset = (allocation) ? allocation.getOffset() : 0;
+            memoryBind.flags = 0;
+        }
+
+        VkSparseBufferMemoryBindInfo bufferBind;
+        bufferBind.buffer = mBuffer;
+        bufferBind.bindCount = static_cast<uint32_t>(memoryBinds.size());
+        bufferBind.pBinds = memoryBinds.data();
+
+        VkBindSparseInfo info;
+        info.sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO;
+        info.pNext = nullptr;
+        info.waitSemaphoreCount = 0;
+        info.pWaitSemaphores = nullptr;
+        info.bufferBindCount = 1;
+        info.pBufferBinds = &bufferBind;
+        info.imageOpaqueBindCount = 0;
+        info.pImageOpaqueBinds = nullptr;
+        info.imageBindCount = 0;
+        info.pImageBinds = nullptr;
+        info.signalSemaphoreCount = 0;
+        info.pSignalSemaphores = nullptr;
+
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+        MemoryAllocator& allocator = mDevice.getMemoryAllocator();
+        SyncPool& syncPool = mDevice.getSyncPool();
+        VkFence fence = syncPool.acquireFence();
+
+        VkResult result = VK_SUCCESS;
+        {
+            std::lock_guard<std::mutex> lock(mQueue->getMutex());
+            result = dispatch.vkQueueBindSparse(mQueue->getHandle(), 1, &info, fence);
+        }
+
+        if (result == VK_SUCCESS)
+        {
+            result = dispatch.vkWaitForFences(mDevice.getHandle(), 1, &fence, VK_TRUE,
+                std::numeric_limits<uint64_t>::max());
+        }
+
+        if (result != VK_SUCCESS)
+        {
+            // A lost device is the only way waiting fails, so the fence is
+            // not in use any more either way
+            syncPool.releaseFence(fence);
+            for (Bind& bind : binds)
+            {
+                if (bind.second)
+                    allocator.free(bind.second);
+            }
+
+            throw Exception("vw::SparseBuffer::bind", result);
+        }
+
+        syncPool.releaseFence(fence);
+
+        for (Bind& bind : binds)
+        {
+            Allocation& page = mPages[bind.first];
+            if (bind.second)
+            {
+                page = bind.second;
+                mCommittedSize += getPageBytes(bind.first);
+            }
+            else
+            {
+                mCommittedSize -= getPageBytes(bind.first);
+                allocator.free(page);
+            }
+        }
+    }
+}
@@ -0,0 +1,457 @@
+#include "vw/stagingring.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+#include "vw/device.h"
+#include "vw/devicedispatch.h"
+#include "vw/exception.h"
+
+namespace vw
+{
+    namespace
+    {
+        VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        VkDeviceSize leastCommonMultiple(VkDeviceSize a, VkDeviceSize b)
+        {
+            VkDeviceSize x = a;
+            VkDeviceSize y = b;
+            while (y != 0)
+            {
+                VkDeviceSize t = x % y;
+                x = y;
+                y = t;
+            }
+
+            return a / x * b;
+        }
+    }
+
+    StagingRing::StagingRing(Device& device, VkDeviceSize capacity)
+        : mDevice(device)
+        , mCapacity(capacity)
+        , mAtomSize(1)
+        , mBuffer(VK_NULL_HANDLE)
+        , mData(nullptr)
+        , mHead(0)
+        , mTail(0)
+        , mWaiters(0)
+    {
+        assert(mDevice);
+        assert(mCapacity > 0);
+
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+
+        VkBufferCreateInfo cinfo;
+        cinfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        cinfo.pNext = nullptr;
+        cinfo.flags = 0;
+        cinfo.size = mCapacity;
+        cinfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        cinfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        cinfo.queueFamilyIndexCount = 0;
+        cinfo.pQueueFamilyIndices = nullptr;
+
+        VkResult result = dispatch.vkCreateBuffer(mDevice.getHandle(),
+            &cinfo, mDevice.getAllocationCallbacks(), &mBuffer);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::StagingRing::StagingRing", result);
+
+        MemoryAllocator& allocator = mDevice.getMemoryAllocator();
+        try
+        {
+            mAllocation = allocator.allocateForBuffer(mBuffer,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        }
+        catch (...)
+        {
+            dispatch.vkDestroyBuffer(mDevice.getHandle(),
+                mBuffer, mDevice.getAllocationCallbacks());
+            throw;
+        }
+
+        mData = static_cast<char*>(mAllocation.getMappedData());
+
+        // Flushed ranges must cover whole atoms of non-coherent memory
+        const VkPhysicalDeviceMemoryProperties& props = allocator.getMemoryProperties();
+        if (!(props.memoryTypes[mAllocation.getMemoryType()].propertyFlags &
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+        {
+            mAtomSize = mDevice.getPhysicalDevice().getDeviceLimits().nonCoherentAtomSize;
+        }
+    }
+
+    StagingRing::~StagingRing()
+    {
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+        VkDevice device = mDevice.getHandle();
+
+        // The buffer may not be destroyed while copies from it are pending.
+        // A retired submission may never have been made, so rather than wait
+        // on each mark, the device is idled once if any is still pending.
+        bool pending = false;
+        for (const Mark& mark : mMarks)
+        {
+            try
+            {
+                pending = pending || !isRetired(mark);
+            }
+            catch (...)
+            {
+                pending = true;
+            }
+        }
+
+        if (pending)
+        {
+            try
+            {
+                mDevice.waitIdle();
+            }
+            catch (...)
+            {
+                // The device is lost, so nothing is pending anymore
+            }
+        }
+
+        for (const Mark& mark : mMarks)
+        {
+            if (mark.fence != VK_NULL_HANDLE)
+                dispatch.vkDestroyFence(device, mark.fence, mDevice.getAllocationCallbacks());
+        }
+
+        mFreeFences.insert(mFreeFences.end(), mSignaledFences.begin(),
+            mSignaledFences.end());
+        for (VkFence fence : mFreeFences)
+            dispatch.vkDestroyFence(device, fence, mDevice.getAllocationCallbacks());
+
+        mDevice.getMemoryAllocator().free(mAllocation);
+        dispatch.vkDestroyBuffer(device, mBuffer, mDevice.getAllocationCallbacks());
+    }
+
+    StagingRing::Reservation StagingRing::reserve(VkDeviceSize size,
+        VkDeviceSize alignment)
+    {
+        assert(size > 0);
+
+        // Ranges never straddle the end, so anything up to the capacity fits
+        // once the ring has drained
+        if (alignUp(size, mAtomSize) > mCapacity)
+            throw Exception("vw::StagingRing::reserve", VK_ERROR_OUT_OF_DEVICE_MEMORY);
+
+        Reservation reservation;
+        while (!tryReserve(size, alignment, reservation))
+        {
+            reclaim();
+            uint64_t tail = mTail.load(std::memory_order_acquire);
+            if (tryReserve(size, alignment, reservation))
+                break;
+
+            // Genuinely full, so block on the oldest submission
+            waitOldest(tail);
+            reclaim();
+        }
+
+        return reservation;
+    }
+
+    bool StagingRing::tryReserve(VkDeviceSize size, VkDeviceSize alignment,
+        Reservation& reservation)
+    {
+        assert(size > 0 && alignment > 0);
+
+        // Positions increase monotonically and are wrapped into the buffer
+        alignment = leastCommonMultiple(alignment, mAtomSize);
+        VkDeviceSize paddedSize = alignUp(size, mAtomSize);
+
+        uint64_t head = mHead.load(std::memory_order_relaxed);
+        uint64_t start;
+        uint64_t end;
+        do
+        {
+            uint64_t lap = head - head % mCapacity;
+            start = lap + alignUp(head - lap, alignment);
+
+            // Ranges never straddle the end of the buffer
+            if (start - lap + paddedSize > mCapacity)
+                start = lap + mCapacity;
+
+            end = start + paddedSize;
+            if (end - mTail.load(std::memory_order_acquire) > mCapacity)
+                return false;
+        }
+        while (!mHead.compare_exchange_weak(head, end, std::memory_order_acq_rel,
+            std::memory_order_relaxed));
+
+        reservation.offset = start % mCapacity;
+        reservation.size = size;
+        reservation.begin = head;
+        reservation.end = end;
+        reservation.buffer = mBuffer;
+        reservation.data = mData + reservation.offset;
+        return true;
+    }
+
+    void StagingRing::flush(const Reservation& reservation)
+    {
+        if (mAtomSize == 1)
+            return;
+
+        VkMappedMemoryRange range;
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.pNext = nullptr;
+        range.memory = mAllocation.getMemory();
+        range.offset = mAllocation.getOffset() + reservation.offset;
+        range.size = alignUp(reservation.size, mAtomSize);
+
+        VkResult result = mDevice.getDispatch().vkFlushMappedMemoryRanges(
+            mDevice.getHandle(), 1, &range);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::StagingRing::flush", result);
+    }
+
+    void StagingRing::copyToBuffer(VkCommandBuffer commandBuffer,
+        const Reservation& reservation, VkBuffer dst, VkDeviceSize dstOffset)
+    {
+        VkBufferCopy region;
+        region.srcOffset = reservation.offset;
+        region.dstOffset = dstOffset;
+        region.size = reservation.size;
+
+        mDevice.getDispatch().vkCmdCopyBuffer(commandBuffer, mBuffer, dst, 1, &region);
+    }
+
+    void StagingRing::copyToImage(VkCommandBuffer commandBuffer,
+        const Reservation& reservation, VkImage dst, VkImageLayout layout,
+        const VkBufferImageCopy& region)
+    {
+        VkBufferImageCopy copy = region;
+        copy.bufferOffset += reservation.offset;
+
+        mDevice.getDispatch().vkCmdCopyBufferToImage(commandBuffer, mBuffer, dst,
+            layout, 1, &copy);
+    }
+
+    VkFence StagingRing::retire(uint32_t count, const Reservation* reservations)
+    {
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+        std::lock_guard<std::mutex> lock(mMarkMutex);
+
+        Mark mark;
+        addRanges(mark, count, reservations);
+        mark.fence = VK_NULL_HANDLE;
+        mark.timeline = VK_NULL_HANDLE;
+        mark.value = 0;
+
+        if (!mFreeFences.empty())
+        {
+            mark.fence = mFreeFences.back();
+            mFreeFences.pop_back();
+        }
+        else
+        {
+            VkFenceCreateInfo cinfo;
+            cinfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            cinfo.pNext = nullptr;
+            cinfo.flags = 0;
+
+            VkResult result = dispatch.vkCreateFence(mDevice.getHandle(), &cinfo,
+                mDevice.getAllocationCallbacks(), &mark.fence);
+            if (result != VK_SUCCESS)
+                throw Exception("vw::StagingRing::retire", result);
+        }
+
+        mMarks.push_back(std::move(mark));
+        mRetired.notify_all();
+        return mMarks.back().fence;
+    }
+
+    void StagingRing::retire(uint32_t count, const Reservation* reservations,
+        VkSemaphore timeline, uint64_t value)
+    {
+        assert(timeline != VK_NULL_HANDLE);
+        assert(mDevice.getDispatch().vkGetSemaphoreCounterValue);
+
+        std::lock_guard<std::mutex> lock(mMarkMutex);
+
+        Mark mark;
+        addRanges(mark, count, reservations);
+        mark.fence = VK_NULL_HANDLE;
+        mark.timeline = timeline;
+        mark.value = value;
+        mMarks.push_back(std::move(mark));
+        mRetired.notify_all();
+    }
+
+    void StagingRing::reclaim()
+    {
+        std::lock_guard<std::mutex> lock(mMarkMutex);
+
+        // Submissions of different producers may complete in any order
+        auto it = mMarks.begin();
+        while (it != mMarks.end())
+        {
+            if (isRetired(*it))
+            {
+                release(*it);
+                it = mMarks.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    VkDeviceSize StagingRing::getUsedBytes() const
+    {
+        return mHead.load(std::memory_order_relaxed) - mTail.load(std::memory_order_relaxed);
+    }
+
+    VkDeviceSize StagingRing::getCapacity() const
+    {
+        return mCapacity;
+    }
+
+    VkBuffer StagingRing::getBuffer()
+    {
+        return mBuffer;
+    }
+
+    void StagingRing::addRanges(Mark& mark, uint32_t count,
+        const Reservation* reservations)
+    {
+        // Reservations made one after another become a single range
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const Reservation& reservation = reservations[i];
+            assert(reservation.begin < reservation.end);
+
+            if (!mark.ranges.empty() && mark.ranges.back().second == reservation.begin)
+                mark.ranges.back().second = reservation.end;
+            else
+                mark.ranges.push_back(Range(reservation.begin, reservation.end));
+        }
+    }
+
+    bool StagingRing::isRetired(const Mark& mark) const
+    {
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+        VkDevice device = mDevice.getHandle();
+
+        if (mark.fence != VK_NULL_HANDLE)
+        {
+            VkResult result = dispatch.vkGetFenceStatus(device, mark.fence);
+            if (result == VK_NOT_READY)
+                return false;
+            if (result != VK_SUCCESS)
+                throw Exception("vw::StagingRing::reclaim", result);
+            return true;
+        }
+
+        uint64_t value = 0;
+        VkResult result = dispatch.vkGetSemaphoreCounterValue(device, mark.timeline, &value);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::StagingRing::reclaim", result);
+        return value >= mark.value;
+    }
+
+    void StagingRing::waitOldest(uint64_t tail)
+    {
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+        VkDevice device = mDevice.getHandle();
+
+        VkFence fence;
+        VkSemaphore timeline;
+        uint64_t value;
+        {
+            // When the space is held by reservations not retired yet, wait
+            // for their producers to retire them
+            std::unique_lock<std::mutex> lock(mMarkMutex);
+            mRetired.wait(lock, [&]
+                { return !mMarks.empty() || mTail.load(std::memory_order_relaxed) != tail; });
+            if (mMarks.empty())
+                return;
+
+            const Mark& mark = mMarks.front();
+            fence = mark.fence;
+            timeline = mark.timeline;
+            value = mark.value;
+            ++mWaiters;
+        }
+
+        // Other threads keep retiring and reclaiming while this one waits
+        VkResult result = VK_SUCCESS;
+        if (fence != VK_NULL_HANDLE)
+        {
+            result = dispatch.vkWaitForFences(device, 1, &fence, VK_TRUE,
+                std::numeric_limits<uint64_t>::max());
+        }
+        else
+        {
+            VkSemaphoreWaitInfo info;
+            info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+            info.pNext = nullptr;
+            info.flags = 0;
+            info.semaphoreCount = 1;
+            info.pSemaphores = &timeline;
+            info.pValues = &value;
+
+            result = dispatch.vkWaitSemaphores(device, &info,
+                std::numeric_limits<uint64_t>::max());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMarkMutex);
+            if (--mWaiters == 0)
+                recycleFences();
+        }
+
+        if (result != VK_SUCCESS)
+            throw Exception("vw::StagingRing::reserve", result);
+    }
+
+    void StagingRing::release(Mark& mark)
+    {
+        for (const Range& range : mark.ranges)
+            mCompleted[range.first] = range.second;
+
+        // Space is only reclaimed up to the first range still in use
+        uint64_t tail = mTail.load(std::memory_order_relaxed);
+        while (!mCompleted.empty() && mCompleted.begin()->first == tail)
+        {
+            tail = mCompleted.begin()->second;
+            mCompleted.erase(mCompleted.begin());
+        }
+
+        mTail.store(tail, std::memory_order_release);
+
+        if (mark.fence != VK_NULL_HANDLE)
+        {
+            mSignaledFences.push_back(mark.fence);
+            mark.fence = VK_NULL_HANDLE;
+            if (mWaiters == 0)
+                recycleFences();
+        }
+    }
+
+    void StagingRing::recycleFences()
+    {
+        if (mSignaledFences.empty())
+            return;
+
+        VkResult result = mDevice.getDispatch().vkResetFences(mDevice.getHandle(),
+            static_cast<uint32_t>(mSignaledFences.size()), mSignaledFences.data());
+        if (result != VK_SUCCESS)
+            throw Exception("vw::StagingRing::reclaim", result);
+
+        mFreeFences.insert(mFreeFences.end(), mSignaledFences.begin(),
+            mSignaledFences.end());
+        mSignaledFences.clear();
+    }
+}
@@ -0,0 +1,313 @@
+#include "vw/streamloader.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <deque>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "vw/device.h"
+
+namespace vw
+{
+    namespace
+    {
+        // Offsets in the ring are aligned to at most 256 bytes, the largest
+        // nonCoherentAtomSize a device may have
+        const VkDeviceSize MaxRingAlignment = 256;
+
+        VkDeviceSize getRingCapacity(const StreamLoader::Settings& settings)
+        {
+            // Depth copies stay in flight while the next chunk is staged, and
+            // the ring skips its end once per lap when a chunk doesn't fit
+            VkDeviceSize slotSize = (settings.chunkSize + MaxRingAlignment - 1) /
+                MaxRingAlignment * MaxRingAlignment + MaxRingAlignment;
+            return slotSize * (settings.depth + 2);
+        }
+    }
+
+    StreamLoader::Settings::Settings()
+        : chunkSize(4 * 1024 * 1024)
+        , depth(4)
+        , readThreads(2)
+    {
+    }
+
+    StreamLoader::StageClock::StageClock()
+        : mActive(0)
+        , mBytes(0)
+        , mNanoseconds(0)
+    {
+    }
+
+    void StreamLoader::StageClock::begin()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mActive++ == 0)
+            mStart = Clock::now();
+    }
+
+    void StreamLoader::StageClock::end(VkDeviceSize bytes)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        assert(mActive > 0);
+
+        mBytes += bytes;
+        if (--mActive == 0)
+        {
+            mNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now() - mStart).count();
+        }
+    }
+
+    StreamLoader::Stage StreamLoader::StageClock::get() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        Stage stage;
+        stage.bytes = mBytes;
+        stage.nanoseconds = mNanoseconds;
+        stage.bytesPerSecond = (mNanoseconds > 0) ?
+            static_cast<double>(mBytes) * 1e9 / static_cast<double>(mNanoseconds) : 0.0;
+        return stage;
+    }
+
+    StreamLoader::StreamLoader(Device& device, const Settings& settings)
+        : mSettings(settings)
+        , mEngine(device, getRingCapacity(settings))
+        , mReaders(settings.readThreads)
+        , mSlots(settings.depth)
+        , mChunkCount(0)
+    {
+        assert(mSettings.chunkSize > 0);
+        assert(mSettings.depth > 0);
+        assert(mSettings.readThreads > 0);
+
+        for (Slot& slot : mSlots)
+            slot.data.resize(static_cast<size_t>(mSettings.chunkSize));
+    }
+
+    StreamLoader::~StreamLoader()
+    {
+        mReaders.waitIdle();
+    }
+
+    bool StreamLoader::load(const std::string& path, VkBuffer dst, VkDeviceSize dstOffset,
+        const ChunkCallback& callback, uint32_t dstFamily)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat info;
+        bool success = fstat(fd, &info) == 0;
+        if (success)
+        {
+            try
+            {
+                success = load(fd, 0, static_cast<VkDeviceSize>(info.st_size), dst,
+                    dstOffset, callback, dstFamily);
+            }
+            catch (...)
+            {
+                close(fd);
+                throw;
+            }
+        }
+
+        close(fd);
+        return success;
+    }
+
+    bool StreamLoader::load(int fd, VkDeviceSize fileOffset, VkDeviceSize size, VkBuffer dst,
+        VkDeviceSize dstOffset, const ChunkCallback& callback, uint32_t dstFamily)
+    {
+        std::lock_guard<std::mutex> loadLock(mLoadMutex);
+        if (size == 0)
+            return true;
+
+#ifdef POSIX_FADV_SEQUENTIAL
+        posix_fadvise(fd, static_cast<off_t>(fileOffset), static_cast<off_t>(size),
+            POSIX_FADV_SEQUENTIAL);
+#endif
+
+        const VkDeviceSize chunkSize = mSettings.chunkSize;
+        const size_t depth = mSlots.size();
+        const size_t chunkCount = static_cast<size_t>((size + chunkSize - 1) / chunkSize);
+
+        // Chunk i always reads into slot i % depth, so a slot is free again
+        // once the chunk depth before it has been staged
+        size_t nextRead = 0;
+        auto issueRead = [&]()
+        {
+            Slot& slot = mSlots[nextRead % depth];
+            slot.offset = nextRead * chunkSize;
+            slot.size = std::min(chunkSize, size - slot.offset);
+            slot.ready = false;
+            slot.failed = false;
+
+            Slot* target = &slot;
+            mReaders.enqueue([this, fd, fileOffset, target](uint32_t)
+            {
+                read(fd, fileOffset, *target);
+            });
+            ++nextRead;
+        };
+
+        mTotal.begin();
+        std::deque<Copy> copies;
+        bool success = true;
+
+        try
+        {
+            while (nextRead < chunkCount && nextRead < depth)
+                issueRead();
+
+            for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+            {
+                Slot& slot = mSlots[chunk % depth];
+                {
+                    std::unique_lock<std::mutex> lock(mSlotMutex);
+                    mSlotReady.wait(lock, [&slot]() { return slot.ready; });
+                }
+
+                if (slot.failed)
+                {
+                    success = false;
+                    break;
+                }
+
+                // The data is in the staging ring once the upload returns, so
+                // the slot can take the next read right away
+                Copy copy;
+                copy.offset = slot.offset;
+                copy.size = slot.size;
+
+                mStaging.begin();
+                try
+                {
+                    copy.value = mEngine.uploadBuffer(slot.data.data(), slot.size, dst,
+                        dstOffset + slot.offset, dstFamily);
+                    mEngine.flush();
+                }
+                catch (...)
+                {
+                    mStaging.end(0);
+                    throw;
+                }
+
+                mStaging.end(slot.size);
+
+                mCopy.begin();
+                copies.push_back(copy);
+
+                if (nextRead < chunkCount)
+                    issueRead();
+
+                while (!copies.empty() &&
+                    (copies.size() > depth || mEngine.isComplete(copies.front().value)))
+                {
+                    mEngine.wait(copies.front().value);
+                    Copy copy = copies.front();
+                    copies.pop_front();
+                    notify(copy, callback);
+                }
+            }
+
+            // Reads may still be running if one failed
+            mReaders.waitIdle();
+
+            while (!copies.empty())
+            {
+                mEngine.wait(copies.front().value);
+                Copy copy = copies.front();
+                copies.pop_front();
+                notify(copy, callback);
+            }
+        }
+        catch (...)
+        {
+            mReaders.waitIdle();
+            for (size_t i = 0; i < copies.size(); ++i)
+                mCopy.end(0);
+            mTotal.end(0);
+            throw;
+        }
+
+        mTotal.end((success) ? size : 0);
+        return success;
+    }
+
+    StreamLoader::Statistics StreamLoader::getStatistics() const
+    {
+        Statistics statistics;
+        statistics.chunkCount = mChunkCount.load(std::memory_order_relaxed);
+        statistics.read = mRead.get();
+        statistics.staging = mStaging.get();
+        statistics.copy = mCopy.get();
+        statistics.notify = mNotify.get();
+        statistics.total = mTotal.get();
+        return statistics;
+    }
+
+    TransferEngine& StreamLoader::getTransferEngine()
+    {
+        return mEngine;
+    }
+
+    void StreamLoader::read(int fd, VkDeviceSize fileOffset, Slot& slot)
+    {
+        mRead.begin();
+
+        VkDeviceSize done = 0;
+        bool failed = false;
+        while (done < slot.size)
+        {
+            ssize_t count = pread(fd, slot.data.data() + done,
+                static_cast<size_t>(slot.size - done),
+                static_cast<off_t>(fileOffset + slot.offset + done));
+            if (count < 0 && errno == EINTR)
+                continue;
+
+            // Ending early means the file is shorter than the range
+            if (count <= 0)
+            {
+                failed = true;
+                break;
+            }
+
+            done += static_cast<VkDeviceSize>(count);
+        }
+
+        mRead.end(done);
+
+        std::lock_guard<std::mutex> lock(mSlotMutex);
+        slot.ready = true;
+        slot.failed = failed;
+        mSlotReady.notify_all();
+    }
+
+    void StreamLoader::notify(const Copy& copy, const ChunkCallback& callback)
+    {
+        mCopy.end(copy.size);
+        mChunkCount.fetch_add(1, std::memory_order_relaxed);
+
+        if (!callback)
+            return;
+
+        mNotify.begin();
+        try
+        {
+            callback(copy.offset, copy.size);
+        }
+        catch (...)
+        {
+            mNotify.end(0);
+            throw;
+        }
+
+        mNotify.end(copy.size);
+    }
+}
@@ -0,0 +1,228 @@
+#include "vw/submissioncoalescer.h"
+
+#include <cassert>
+#include <utility>
+
+#include "vw/exception.h"
+#include "vw/queue.h"
+
+namespace vw
+{
+    namespace
+    {
+        // Any other structure would be lost when the batch is rebuilt, so
+        // it is rejected rather than dropped
+        const VkTimelineSemaphoreSubmitInfo* findTimelineInfo(const VkSubmitInfo& info)
+        {
+            const VkTimelineSemaphoreSubmitInfo* timeline = nullptr;
+            const VkBaseInStructure* next = static_cast<const VkBaseInStructure*>(info.pNext);
+            for (; next; next = next->pNext)
+            {
+                if (next->sType != VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO || timeline)
+                {
+                    throw Exception("vw::SubmissionCoalescer::enqueue",
+                        VK_ERROR_FEATURE_NOT_PRESENT);
+                }
+
+                timeline = reinterpret_cast<const VkTimelineSemaphoreSubmitInfo*>(next);
+            }
+
+            return timeline;
+        }
+    }
+
+    void SubmissionCoalescer::Batch::clear()
+    {
+        ranges.clear();
+        waitSemaphores.clear();
+        waitStages.clear();
+        waitValues.clear();
+        commandBuffers.clear();
+        signalSemaphores.clear();
+        signalValues.clear();
+        infos.clear();
+        timelineInfos.clear();
+    }
+
+    SubmissionCoalescer::SubmissionCoalescer(Queue& queue, size_t maxPending,
+        std::chrono::microseconds maxDelay)
+        : mQueue(queue)
+        , mMaxPending(maxPending)
+        , mMaxDelay(maxDelay)
+    {
+        assert(mQueue);
+    }
+
+    SubmissionCoalescer::~SubmissionCoalescer()
+    {
+        try
+        {
+            if (getPendingCount() > 0)
+                flush();
+        }
+        catch (...)
+        {
+            // The submissions are lost, which the device will report again
+            // on its next use
+        }
+    }
+
+    void SubmissionCoalescer::enqueue(const VkSubmitInfo& info)
+    {
+        assert(info.sType == VK_STRUCTURE_TYPE_SUBMIT_INFO);
+
+        const VkTimelineSemaphoreSubmitInfo* timeline = findTimelineInfo(info);
+        bool due = false;
+
+        {
+            std::lock_guard<std::mutex> lock(mPendingMutex);
+            Batch& batch = mPending;
+
+            if (batch.ranges.empty())
+                batch.oldest = Clock::now();
+
+            Range range;
+            range.waitOffset = static_cast<uint32_t>(batch.waitSemaphores.size());
+            range.waitCount = info.waitSemaphoreCount;
+            range.commandBufferOffset = static_cast<uint32_t>(batch.commandBuffers.size());
+            range.commandBufferCount = info.commandBufferCount;
+            range.signalOffset = static_cast<uint32_t>(batch.signalSemaphores.size());
+            range.signalCount = info.signalSemaphoreCount;
+            range.timeline = timeline != nullptr;
+            batch.ranges.push_back(range);
+
+            batch.waitSemaphores.insert(batch.waitSemaphores.end(),
+                info.pWaitSemaphores, info.pWaitSemaphores + info.waitSemaphoreCount);
+            batch.waitStages.insert(batch.waitStages.end(),
+                info.pWaitDstStageMask, info.pWaitDstStageMask + info.waitSemaphoreCount);
+            batch.commandBuffers.insert(batch.commandBuffers.end(),
+                info.pCommandBuffers, info.pCommandBuffers + info.commandBufferCount);
+            batch.signalSemaphores.insert(batch.signalSemaphores.end(),
+                info.pSignalSemaphores, info.pSignalSemaphores + info.signalSemaphoreCount);
+
+            // Values are kept parallel to the semaphores, with zeros for
+            // submissions that did not chain any.
+            if (timeline && timeline->waitSemaphoreValueCount > 0)
+            {
+                assert(timeline->waitSemaphoreValueCount == info.waitSemaphoreCount);
+                batch.waitValues.insert(batch.waitValues.end(), timeline->pWaitSemaphoreValues,
+                    timeline->pWaitSemaphoreValues + info.waitSemaphoreCount);
+            }
+            else
+            {
+                batch.waitValues.resize(batch.waitValues.size() + info.waitSemaphoreCount, 0);
+            }
+
+            if (timeline && timeline->signalSemaphoreValueCount > 0)
+            {
+                assert(timeline->signalSemaphoreValueCount == info.signalSemaphoreCount);
+                batch.signalValues.insert(batch.signalValues.end(), timeline->pSignalSemaphoreValues,
+                    timeline->pSignalSemaphoreValues + info.signalSemaphoreCount);
+            }
+            else
+            {
+                batch.signalValues.resize(batch.signalValues.size() + info.signalSemaphoreCount, 0);
+            }
+
+            due = isDue(batch);
+        }
+
+        if (due)
+            flush();
+    }
+
+    void SubmissionCoalescer::enqueue(VkCommandBuffer commandBuffer)
+    {
+        VkSubmitInfo info;
+        info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        info.pNext = nullptr;
+        info.waitSemaphoreCount = 0;
+        info.pWaitSemaphores = nullptr;
+        info.pWaitDstStageMask = nullptr;
+        info.commandBufferCount = 1;
+        info.pCommandBuffers = &commandBuffer;
+        info.signalSemaphoreCount = 0;
+        info.pSignalSemaphores = nullptr;
+        enqueue(info);
+    }
+
+    size_t SubmissionCoalescer::flush(VkFence fence)
+    {
+        // Holding the submit lock across the swap keeps batches in order
+        std::lock_guard<std::mutex> submitLock(mSubmitMutex);
+        Batch& batch = mSubmitting;
+        batch.clear();
+
+        {
+            std::lock_guard<std::mutex> lock(mPendingMutex);
+            std::swap(mPending, mSubmitting);
+        }
+
+        if (batch.ranges.empty() && fence == VK_NULL_HANDLE)
+            return 0;
+
+        // Build the infos now that the arrays will no longer move
+        batch.infos.reserve(batch.ranges.size());
+        batch.timelineInfos.reserve(batch.ranges.size());
+        for (const Range& range : batch.ranges)
+        {
+            VkSubmitInfo info;
+            info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            info.pNext = nullptr;
+            info.waitSemaphoreCount = range.waitCount;
+            info.pWaitSemaphores = batch.waitSemaphores.data() + range.waitOffset;
+            info.pWaitDstStageMask = batch.waitStages.data() + range.waitOffset;
+            info.commandBufferCount = range.commandBufferCount;
+            info.pCommandBuffers = batch.commandBuffers.data() + range.commandBufferOffset;
+            info.signalSemaphoreCount = range.signalCount;
+            info.pSignalSemaphores = batch.signalSemaphores.data() + range.signalOffset;
+
+            if (range.timeline)
+            {
+                VkTimelineSemaphoreSubmitInfo timeline;
+                timeline.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+                timeline.pNext = nullptr;
+                timeline.waitSemaphoreValueCount = range.waitCount;
+                timeline.pWaitSemaphoreValues = batch.waitValues.data() + range.waitOffset;
+                timeline.signalSemaphoreValueCount = range.signalCount;
+                timeline.pSignalSemaphoreValues = batch.signalValues.data() + range.signalOffset;
+                batch.timelineInfos.push_back(timeline);
+                info.pNext = &batch.timelineInfos.back();
+            }
+
+            batch.infos.push_back(info);
+        }
+
+        mQueue.submit(static_cast<uint32_t>(batch.infos.size()), batch.infos.data(), fence);
+        return batch.infos.size();
+    }
+
+    bool SubmissionCoalescer::poll()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mPendingMutex);
+            if (!isDue(mPending))
+                return false;
+        }
+
+        flush();
+        return true;
+    }
+
+    size_t SubmissionCoalescer::getPendingCount() const
+    {
+        std::lock_guard<std::mutex> lock(mPendingMutex);
+        return mPending.ranges.size();
+    }
+
+    bool SubmissionCoalescer::isDue(const Batch& batch) const
+    {
+        if (batch.ranges.empty())
+            return false;
+
+        if (mMaxPending > 0 && batch.ranges.size() >= mMaxPending)
+            return true;
+
+        return mMaxDelay.count() > 0 && Clock::now() - batch.oldest >= mMaxDelay;
+    }
+}
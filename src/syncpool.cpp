@@ -0,0 +1,175 @@
+#include "vw/syncpool.h"
+
+#include <cassert>
+
+#include "vw/devicedispatch.h"
+#include "vw/exception.h"
+#include "vw/queue.h"
+#include "vw/timelinesemaphore.h"
+
+namespace vw
+{
+    SyncPool::SyncPool(VkDevice device, const DeviceDispatch& dispatch,
+        const std::vector<Queue>& queues, bool timelineSemaphores,
+        const VkAllocationCallbacks* callbacks)
+        : mDevice(device)
+        , mDispatch(dispatch)
+        , mCallbacks(callbacks)
+    {
+        if (!timelineSemaphores)
+            return;
+
+        mTimelines.reserve(queues.size());
+        for (const Queue& queue : queues)
+        {
+            QueueTimeline entry;
+            entry.family = queue.getFamilyIndex();
+            entry.index = queue.getQueueIndex();
+            entry.timeline.reset(new TimelineSemaphore(mDevice, mDispatch, mCallbacks));
+            mTimelines.push_back(std::move(entry));
+        }
+    }
+
+    SyncPool::~SyncPool()
+    {
+        for (VkFence fence : mFences)
+            mDispatch.vkDestroyFence(mDevice, fence, mCallbacks);
+
+        for (VkSemaphore semaphore : mSemaphores)
+            mDispatch.vkDestroySemaphore(mDevice, semaphore, mCallbacks);
+
+        for (VkEvent event : mEvents)
+            mDispatch.vkDestroyEvent(mDevice, event, mCallbacks);
+    }
+
+    VkFence SyncPool::acquireFence()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mFenceMutex);
+            if (!mFences.empty())
+            {
+                VkFence fence = mFences.back();
+                mFences.pop_back();
+                return fence;
+            }
+        }
+
+        VkFenceCreateInfo cinfo;
+        cinfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        cinfo.pNext = nullptr;
+        cinfo.flags = 0;
+
+        VkFence fence = VK_NULL_HANDLE;
+        VkResult result = mDispatch.vkCreateFence(mDevice, &cinfo, mCallbacks, &fence);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::SyncPool::acquireFence", result);
+
+        return fence;
+    }
+
+    void SyncPool::releaseFence(VkFence fence)
+    {
+        releaseFences(1, &fence);
+    }
+
+    void SyncPool::releaseFences(uint32_t count, const VkFence* fences)
+    {
+        if (count == 0)
+            return;
+
+        VkResult result = mDispatch.vkResetFences(mDevice, count, fences);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::SyncPool::releaseFences", result);
+
+        std::lock_guard<std::mutex> lock(mFenceMutex);
+        mFences.insert(mFences.end(), fences, fences + count);
+    }
+
+    VkSemaphore SyncPool::acquireSemaphore()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mSemaphoreMutex);
+            if (!mSemaphores.empty())
+            {
+                VkSemaphore semaphore = mSemaphores.back();
+                mSemaphores.pop_back();
+                return semaphore;
+            }
+        }
+
+        VkSemaphoreCreateInfo cinfo;
+        cinfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        cinfo.pNext = nullptr;
+        cinfo.flags = 0;
+
+        VkSemaphore semaphore = VK_NULL_HANDLE;
+        VkResult result = mDispatch.vkCreateSemaphore(mDevice, &cinfo, mCallbacks, &semaphore);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::SyncPool::acquireSemaphore", result);
+
+        return semaphore;
+    }
+
+    void SyncPool::releaseSemaphore(VkSemaphore semaphore)
+    {
+        assert(semaphore != VK_NULL_HANDLE);
+
+        std::lock_guard<std::mutex> lock(mSemaphoreMutex);
+        mSemaphores.push_back(semaphore);
+    }
+
+    VkEvent SyncPool::acquireEvent()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mEventMutex);
+            if (!mEvents.empty())
+            {
+                VkEvent event = mEvents.back();
+                mEvents.pop_back();
+                return event;
+            }
+        }
+
+        VkEventCreateInfo cinfo;
+        cinfo.sType = VK_STRUCTURE_TYPE_EVENT_CREATE_INFO;
+        cinfo.pNext = nullptr;
+        cinfo.flags = 0;
+
+        VkEvent event = VK_NULL_HANDLE;
+        VkResult result = mDispatch.vkCreateEvent(mDevice, &cinfo, mCallbacks, &event);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::SyncPool::acquireEvent", result);
+
+        return event;
+    }
+
+    void SyncPool::releaseEvent(VkEvent event)
+    {
+        VkResult result = mDispatch.vkResetEvent(mDevice, event);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::SyncPool::releaseEvent", result);
+
+        std::lock_guard<std::mutex> lock(mEventMutex);
+        mEvents.push_back(event);
+    }
+
+    bool SyncPool::hasTimelines() const
+    {
+        return !mTimelines.empty();
+    }
+
+    TimelineSemaphore& SyncPool::getTimeline(const Queue& queue)
+    {
+        assert(hasTimelines());
+
+        // The list is fixed after construction, so no locking is needed
+        for (QueueTimeline& entry : mTimelines)
+        {
+            if (entry.family == queue.getFamilyIndex() && entry.index == queue.getQueueIndex())
+                return *entry.timeline;
+        }
+
+        // The queue does not belong to the device
+        throw Exception("vw::SyncPool::getTimeline", VK_ERROR_INITIALIZATION_FAILED);
+    }
+}
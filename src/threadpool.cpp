@@ -0,0 +1,96 @@
+#include "vw/threadpool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace vw
+{
+    ThreadPool::ThreadPool(uint32_t threadCount)
+        : mActive(0)
+        , mStopping(false)
+    {
+        if (threadCount == 0)
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+        mThreads.reserve(threadCount);
+        for (uint32_t i = 0; i < threadCount; ++i)
+            mThreads.push_back(std::thread(&ThreadPool::run, this, i));
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopping = true;
+        }
+
+        mTaskReady.notify_all();
+        for (std::thread& thread : mThreads)
+            thread.join();
+    }
+
+    void ThreadPool::enqueue(Task task)
+    {
+        assert(task);
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mTasks.push_back(std::move(task));
+        }
+
+        mTaskReady.notify_one();
+    }
+
+    void ThreadPool::waitIdle()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mIdle.wait(lock, [this]() { return mTasks.empty() && mActive == 0; });
+
+        if (mError)
+        {
+            std::exception_ptr error = mError;
+            mError = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    uint32_t ThreadPool::getThreadCount() const
+    {
+        return static_cast<uint32_t>(mThreads.size());
+    }
+
+    void ThreadPool::run(uint32_t thread)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        for (;;)
+        {
+            mTaskReady.wait(lock, [this]() { return mStopping || !mTasks.empty(); });
+            if (mTasks.empty())
+                return;
+
+            Task task = std::move(mTasks.front());
+            mTasks.pop_front();
+            ++mActive;
+
+            // An escaping exception would terminate the worker's thread
+            std::exception_ptr error;
+            lock.unlock();
+            try
+            {
+                task(thread);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            lock.lock();
+
+            if (error && !mError)
+                mError = error;
+
+            if (--mActive == 0 && mTasks.empty())
+                mIdle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,157 @@
+#include "vw/timelinesemaphore.h"
+
+#include <cassert>
+
+#include "vw/devicedispatch.h"
+#include "vw/exception.h"
+
+namespace vw
+{
+    TimelineSemaphore::TimelineSemaphore(VkDevice device, const DeviceDispatch& dispatch,
+        const VkAllocationCallbacks* callbacks)
+        : mDevice(device)
+        , mDispatch(dispatch)
+        , mCallbacks(callbacks)
+        , mHandle(VK_NULL_HANDLE)
+        , mLastValue(0)
+        , mCompletedValue(0)
+    {
+        // Null when the device was created without timeline semaphores
+        if (!mDispatch.vkGetSemaphoreCounterValue || !mDispatch.vkWaitSemaphores ||
+            !mDispatch.vkSignalSemaphore)
+        {
+            throw Exception("vw::TimelineSemaphore::TimelineSemaphore",
+                VK_ERROR_FEATURE_NOT_PRESENT);
+        }
+
+        VkSemaphoreTypeCreateInfo typeInfo;
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        typeInfo.pNext = nullptr;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo cinfo;
+        cinfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        cinfo.pNext = &typeInfo;
+        cinfo.flags = 0;
+
+        VkResult result = mDispatch.vkCreateSemaphore(mDevice, &cinfo, mCallbacks, &mHandle);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::TimelineSemaphore::TimelineSemaphore", result);
+    }
+
+    TimelineSemaphore::~TimelineSemaphore()
+    {
+        mDispatch.vkDestroySemaphore(mDevice, mHandle, mCallbacks);
+    }
+
+    uint64_t TimelineSemaphore::advance()
+    {
+        return mLastValue.fetch_add(1, std::memory_order_acq_rel) + 1;
+    }
+
+    uint64_t TimelineSemaphore::getLastValue() const
+    {
+        return mLastValue.load(std::memory_order_acquire);
+    }
+
+    bool TimelineSemaphore::isRetired(uint64_t value)
+    {
+        if (value <= mCompletedValue.load(std::memory_order_acquire))
+            return true;
+
+        return value <= getCompletedValue();
+    }
+
+    bool TimelineSemaphore::wait(uint64_t value, uint64_t timeout)
+    {
+        Result<void> result = tryWait(value, timeout);
+        if (!result)
+            throw Exception("vw::TimelineSemaphore::wait", result.getCode());
+
+        return result.getCode() == VK_SUCCESS;
+    }
+
+    uint64_t TimelineSemaphore::getCompletedValue()
+    {
+        Result<uint64_t> result = tryGetCompletedValue();
+        if (!result)
+            throw Exception("vw::TimelineSemaphore::getCompletedValue", result.getCode());
+
+        return result.getValue();
+    }
+
+    void TimelineSemaphore::signal(uint64_t value)
+    {
+        Result<void> result = trySignal(value);
+        if (!result)
+            throw Exception("vw::TimelineSemaphore::signal", result.getCode());
+    }
+
+    Result<void> TimelineSemaphore::tryWait(uint64_t value, uint64_t timeout) noexcept
+    {
+        if (value <= mCompletedValue.load(std::memory_order_acquire))
+            return VK_SUCCESS;
+
+        VkSemaphoreWaitInfo info;
+        info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        info.pNext = nullptr;
+        info.flags = 0;
+        info.semaphoreCount = 1;
+        info.pSemaphores = &mHandle;
+        info.pValues = &value;
+
+        VkResult result = mDispatch.vkWaitSemaphores(mDevice, &info, timeout);
+        if (result == VK_SUCCESS)
+            updateCompleted(value);
+
+        return result;
+    }
+
+    Result<uint64_t> TimelineSemaphore::tryGetCompletedValue() noexcept
+    {
+        uint64_t value = 0;
+        VkResult result = mDispatch.vkGetSemaphoreCounterValue(mDevice, mHandle, &value);
+        if (result != VK_SUCCESS)
+            return result;
+
+        updateCompleted(value);
+        return Result<uint64_t>(value);
+    }
+
+    Result<void> TimelineSemaphore::trySignal(uint64_t value) noexcept
+    {
+        assert(value > 0 && value <= getLastValue());
+
+        Result<void> waited = tryWait(value - 1);
+        if (!waited)
+            return waited.getCode();
+
+        VkSemaphoreSignalInfo info;
+        info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO;
+        info.pNext = nullptr;
+        info.semaphore = mHandle;
+        info.value = value;
+
+        VkResult result = mDispatch.vkSignalSemaphore(mDevice, &info);
+        if (result == VK_SUCCESS)
+            updateCompleted(value);
+
+        return result;
+    }
+
+    VkSemaphore TimelineSemaphore::getHandle()
+    {
+        return mHandle;
+    }
+
+    void TimelineSemaphore::updateCompleted(uint64_t value)
+    {
+        // Threads may observe values out of order, so only ever move forward
+        uint64_t completed = mCompletedValue.load(std::memory_order_relaxed);
+        while (completed < value && !mCompletedValue.compare_exchange_weak(completed,
+            value, std::memory_order_acq_rel, std::memory_order_relaxed))
+        {
+        }
+    }
+}
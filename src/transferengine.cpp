@@ -0,0 +1,482 @@
+#include "vw/transferengine.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+#include "vw/device.h"
+#include "vw/devicedispatch.h"
+#include "vw/exception.h"
+#include "vw/imagecopyplanner.h"
+#include "vw/queue.h"
+
+namespace vw
+{
+    TransferEngine::TransferEngine(Device& device, VkDeviceSize stagingCapacity)
+        : mDevice(device)
+        , mQueue(device.getQueue(Device::QueueRole_Transfer))
+        , mFamily(mQueue.getFamilyIndex())
+        , mTimeline(device.getHandle(), device.getDispatch(), device.getAllocationCallbacks())
+        , mRing(device, stagingCapacity)
+        , mCommandPool(VK_NULL_HANDLE)
+    {
+        VkCommandPoolCreateInfo cinfo;
+        cinfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        cinfo.pNext = nullptr;
+        cinfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT |
+            VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        cinfo.queueFamilyIndex = mFamily;
+
+        VkResult result = mDevice.getDispatch().vkCreateCommandPool(mDevice.getHandle(),
+            &cinfo, mDevice.getAllocationCallbacks(), &mCommandPool);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::TransferEngine::TransferEngine", result);
+    }
+
+    TransferEngine::~TransferEngine()
+    {
+        // Destroying the pool frees its command buffers
+        try
+        {
+            mTimeline.wait(mTimeline.getLastValue());
+        }
+        catch (...)
+        {
+            // The device is lost, so nothing is pending anymore
+        }
+
+        mDevice.getDispatch().vkDestroyCommandPool(mDevice.getHandle(),
+            mCommandPool, mDevice.getAllocationCallbacks());
+    }
+
+    uint64_t TransferEngine::uploadBuffer(const void* data, VkDeviceSize size,
+        VkBuffer dst, VkDeviceSize dstOffset, uint32_t dstFamily)
+    {
+        Job job;
+        job.buffer = dst;
+        job.bufferOffset = dstOffset;
+        job.image = VK_NULL_HANDLE;
+        job.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        job.finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        job.dstFamily = dstFamily;
+        return enqueue(size, 16, [data, size](void* dst) { std::memcpy(dst, data, size); },
+            job);
+    }
+
+    uint64_t TransferEngine::uploadImage(const void* data, VkDeviceSize size,
+        VkImage dst, uint32_t regionCount, const VkBufferImageCopy* regions,
+        const VkImageSubresourceRange& range, VkImageLayout finalLayout,
+        uint32_t dstFamily)
+    {
+        assert(regionCount > 0);
+
+        Job job;
+        job.buffer = VK_NULL_HANDLE;
+        job.bufferOffset = 0;
+        job.image = dst;
+        job.regions.assign(regions, regions + regionCount);
+        job.range = range;
+        job.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        job.finalLayout = finalLayout;
+        job.dstFamily = dstFamily;
+        return enqueue(size, 16, [data, size](void* dst) { std::memcpy(dst, data, size); },
+            job);
+    }
+
+    uint64_t TransferEngine::updateImage(const ImageCopyPlanner& planner,
+        const void* data, size_t rowPitch, size_t slicePitch, VkImage dst,
+        const VkImageSubresourceLayers& subresource, VkImageLayout currentLayout,
+        VkImageLayout finalLayout, uint32_t dstFamily)
+    {
+        if (planner.isEmpty())
+            return mTimeline.getLastValue();
+
+        Job job;
+        job.buffer = VK_NULL_HANDLE;
+        job.bufferOffset = 0;
+        job.image = dst;
+        job.range.aspectMask = subresource.aspectMask;
+        job.range.baseMipLevel = subresource.mipLevel;
+        job.range.levelCount = 1;
+        job.range.baseArrayLayer = subresource.baseArrayLayer;
+        job.range.layerCount = subresource.layerCount;
+        job.initialLayout = currentLayout;
+        job.finalLayout = finalLayout;
+        job.dstFamily = dstFamily;
+
+        // The copies are only known once the regions are packed
+        std::vector<VkBufferImageCopy>& regions = job.regions;
+        auto write = [&](void* staging)
+        {
+            regions = planner.pack(data, rowPitch, slicePitch, subresource, staging);
+        };
+
+        return enqueue(planner.getPackedSize(), planner.getOffsetAlignment(), write, job);
+    }
+
+    uint64_t TransferEngine::flush()
+    {
+        std::lock_guard<std::mutex> submitLock(mSubmitMutex);
+
+        uint64_t value = 0;
+        {
+            std::lock_guard<std::mutex> lock(mJobMutex);
+            if (mJobs.empty())
+                return mTimeline.getLastValue();
+
+            std::swap(mJobs, mRecording);
+            value = mTimeline.advance();
+        }
+
+        // Nothing else will signal the value if this fails, so it's signaled
+        // from the host for waits on it to return
+        try
+        {
+            std::vector<StagingRing::Reservation> reservations;
+            reservations.reserve(mRecording.size());
+            for (const Job& job : mRecording)
+                reservations.push_back(job.reservation);
+
+            mRing.retire(static_cast<uint32_t>(reservations.size()), reservations.data(),
+                mTimeline.getHandle(), value);
+
+            VkCommandBuffer commandBuffer = getCommandBuffer();
+
+            InFlight inFlight;
+            inFlight.commandBuffer = commandBuffer;
+            inFlight.value = value;
+            mInFlight.push_back(inFlight);
+
+            record(commandBuffer, mRecording);
+
+            VkSemaphore semaphore = mTimeline.getHandle();
+
+            VkTimelineSemaphoreSubmitInfo timelineInfo;
+            timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            timelineInfo.pNext = nullptr;
+            timelineInfo.waitSemaphoreValueCount = 0;
+            timelineInfo.pWaitSemaphoreValues = nullptr;
+            timelineInfo.signalSemaphoreValueCount = 1;
+            timelineInfo.pSignalSemaphoreValues = &value;
+
+            VkSubmitInfo info;
+            info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            info.pNext = &timelineInfo;
+            info.waitSemaphoreCount = 0;
+            info.pWaitSemaphores = nullptr;
+            info.pWaitDstStageMask = nullptr;
+            info.commandBufferCount = 1;
+            info.pCommandBuffers = &commandBuffer;
+            info.signalSemaphoreCount = 1;
+            info.pSignalSemaphores = &semaphore;
+
+            mQueue.submit(info);
+        }
+        catch (...)
+        {
+            mTimeline.trySignal(value);
+            mRecording.clear();
+            throw;
+        }
+
+        // Consumers may only acquire what has been released
+        {
+            std::lock_guard<std::mutex> lock(mAcquireMutex);
+            for (Job& job : mRecording)
+            {
+                if (!needsTransfer(job))
+                    continue;
+
+                Acquire acquire;
+                acquire.value = value;
+                acquire.family = job.dstFamily;
+                acquire.job = std::move(job);
+                mAcquires.push_back(std::move(acquire));
+            }
+        }
+
+        mRecording.clear();
+        return value;
+    }
+
+    uint64_t TransferEngine::recordAcquires(VkCommandBuffer commandBuffer,
+        uint32_t family, VkPipelineStageFlags dstStages, VkAccessFlags dstAccess)
+    {
+        std::vector<VkBufferMemoryBarrier> bufferBarriers;
+        std::vector<VkImageMemoryBarrier> imageBarriers;
+        uint64_t value = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(mAcquireMutex);
+
+            auto it = std::stable_partition(mAcquires.begin(), mAcquires.end(),
+                [family](const Acquire& acquire) { return acquire.family != family; });
+
+            for (auto acquire = it; acquire != mAcquires.end(); ++acquire)
+            {
+                const Job& job = acquire->job;
+                value = std::max(value, acquire->value);
+
+                // Must match the release recorded on the transfer queue
+                if (job.image == VK_NULL_HANDLE)
+                {
+                    VkBufferMemoryBarrier barrier;
+                    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+                    barrier.pNext = nullptr;
+                    barrier.srcAccessMask = 0;
+                    barrier.dstAccessMask = dstAccess;
+                    barrier.srcQueueFamilyIndex = mFamily;
+                    barrier.dstQueueFamilyIndex = family;
+                    barrier.buffer = job.buffer;
+                    barrier.offset = job.bufferOffset;
+                    barrier.size = job.reservation.size;
+                    bufferBarriers.push_back(barrier);
+                }
+                else
+                {
+                    VkImageMemoryBarrier barrier;
+                    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                    barrier.pNext = nullptr;
+                    barrier.srcAccessMask = 0;
+                    barrier.dstAccessMask = dstAccess;
+                    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+                    barrier.newLayout = job.finalLayout;
+                    barrier.srcQueueFamilyIndex = mFamily;
+                    barrier.dstQueueFamilyIndex = family;
+                    barrier.image = job.image;
+                    barrier.subresourceRange = job.range;
+                    imageBarriers.push_back(barrier);
+                }
+            }
+
+            mAcquires.erase(it, mAcquires.end());
+        }
+
+        if (value == 0)
+            return 0;
+
+        mDevice.getDispatch().vkCmdPipelineBarrier(commandBuffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStages, 0, 0, nullptr,
+            static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+            static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+        return value;
+    }
+
+    bool TransferEngine::isComplete(uint64_t value)
+    {
+        return mTimeline.isRetired(value);
+    }
+
+    void TransferEngine::wait(uint64_t value)
+    {
+        mTimeline.wait(value);
+    }
+
+    TimelineSemaphore& TransferEngine::getTimeline()
+    {
+        return mTimeline;
+    }
+
+    Queue& TransferEngine::getQueue()
+    {
+        return mQueue;
+    }
+
+    uint64_t TransferEngine::enqueue(VkDeviceSize size, VkDeviceSize alignment,
+        const std::function<void(void*)>& write, Job& job)
+    {
+        assert(size > 0 && size <= mRing.getCapacity());
+
+        for (;;)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mJobMutex);
+                if (mRing.tryReserve(size, alignment, job.reservation))
+                {
+                    write(job.reservation.data);
+                    mRing.flush(job.reservation);
+                    mJobs.push_back(std::move(job));
+                    return mTimeline.getLastValue() + 1;
+                }
+            }
+
+            // The ring is full, so submit what is queued and wait for the
+            // oldest submission to free its space
+            flush();
+
+            uint64_t oldest = 0;
+            {
+                std::lock_guard<std::mutex> lock(mSubmitMutex);
+                retireCommandBuffers();
+                if (!mInFlight.empty())
+                    oldest = mInFlight.front().value;
+            }
+
+            if (oldest > 0)
+                mTimeline.wait(oldest);
+            mRing.reclaim();
+        }
+    }
+
+    bool TransferEngine::needsTransfer(const Job& job) const
+    {
+        return job.dstFamily != VK_QUEUE_FAMILY_IGNORED && job.dstFamily != mFamily;
+    }
+
+    VkCommandBuffer TransferEngine::getCommandBuffer()
+    {
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+
+        retireCommandBuffers();
+        if (!mFreeCommandBuffers.empty())
+        {
+            VkCommandBuffer commandBuffer = mFreeCommandBuffers.back();
+            mFreeCommandBuffers.pop_back();
+
+            VkResult result = dispatch.vkResetCommandBuffer(commandBuffer, 0);
+            if (result != VK_SUCCESS)
+                throw Exception("vw::TransferEngine::flush", result);
+            return commandBuffer;
+        }
+
+        VkCommandBufferAllocateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        info.pNext = nullptr;
+        info.commandPool = mCommandPool;
+        info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        info.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkResult result = dispatch.vkAllocateCommandBuffers(mDevice.getHandle(),
+            &info, &commandBuffer);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::TransferEngine::flush", result);
+        return commandBuffer;
+    }
+
+    void TransferEngine::retireCommandBuffers()
+    {
+        // Command buffers complete in submission order
+        while (!mInFlight.empty() && mTimeline.isRetired(mInFlight.front().value))
+        {
+            mFreeCommandBuffers.push_back(mInFlight.front().commandBuffer);
+            mInFlight.pop_front();
+        }
+    }
+
+    void TransferEngine::record(VkCommandBuffer commandBuffer, const std::vector<Job>& jobs)
+    {
+        const DeviceDispatch& dispatch = mDevice.getDispatch();
+
+        VkCommandBufferBeginInfo beginInfo;
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.pNext = nullptr;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        beginInfo.pInheritanceInfo = nullptr;
+
+        VkResult result = dispatch.vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::TransferEngine::flush", result);
+
+        // Images are made writable with one barrier for the whole batch
+        std::vector<VkImageMemoryBarrier> imageBarriers;
+        for (const Job& job : jobs)
+        {
+            if (job.image == VK_NULL_HANDLE)
+                continue;
+
+            VkImageMemoryBarrier barrier;
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.pNext = nullptr;
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.oldLayout = job.initialLayout;
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = job.image;
+            barrier.subresourceRange = job.range;
+            imageBarriers.push_back(barrier);
+        }
+
+        if (!imageBarriers.empty())
+        {
+            dispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+                static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+        }
+
+        for (const Job& job : jobs)
+        {
+            if (job.image == VK_NULL_HANDLE)
+            {
+                mRing.copyToBuffer(commandBuffer, job.reservation, job.buffer, job.bufferOffset);
+                continue;
+            }
+
+            for (const VkBufferImageCopy& region : job.regions)
+            {
+                mRing.copyToImage(commandBuffer, job.reservation, job.image,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, region);
+            }
+        }
+
+        // Release ownership to the consuming families and move images to
+        // their final layouts. Buffers used on this family need no barrier,
+        // since waiting on the timeline makes the writes visible.
+        std::vector<VkBufferMemoryBarrier> bufferBarriers;
+        imageBarriers.clear();
+        for (const Job& job : jobs)
+        {
+            bool transfer = needsTransfer(job);
+            uint32_t srcFamily = (transfer) ? mFamily : VK_QUEUE_FAMILY_IGNORED;
+            uint32_t dstFamily = (transfer) ? job.dstFamily : VK_QUEUE_FAMILY_IGNORED;
+
+            if (job.image == VK_NULL_HANDLE)
+            {
+                if (!transfer)
+                    continue;
+
+                VkBufferMemoryBarrier barrier;
+                barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+                barrier.pNext = nullptr;
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = 0;
+                barrier.srcQueueFamilyIndex = srcFamily;
+                barrier.dstQueueFamilyIndex = dstFamily;
+                barrier.buffer = job.buffer;
+                barrier.offset = job.bufferOffset;
+                barrier.size = job.reservation.size;
+                bufferBarriers.push_back(barrier);
+            }
+            else
+            {
+                VkImageMemoryBarrier barrier;
+                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                barrier.pNext = nullptr;
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = 0;
+                barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+                barrier.newLayout = job.finalLayout;
+                barrier.srcQueueFamilyIndex = srcFamily;
+                barrier.dstQueueFamilyIndex = dstFamily;
+                barrier.image = job.image;
+                barrier.subresourceRange = job.range;
+                imageBarriers.push_back(barrier);
+            }
+        }
+
+        if (!bufferBarriers.empty() || !imageBarriers.empty())
+        {
+            dispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+                static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+                static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+        }
+
+        result = dispatch.vkEndCommandBuffer(commandBuffer);
+        if (result != VK_SUCCESS)
+            throw Exception("vw::TransferEngine::flush", result);
+    }
+}
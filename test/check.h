@@ -0,0 +1,118 @@
+#ifndef VW_TEST_CHECK_H
+#define VW_TEST_CHECK_H
+
+#include "vw/vw.h"
+
+#include <iostream>
+
+// Unlike assert, checks stay in release builds and a failed one lets the
+// test go on, so one run reports every failure.
+#define VW_CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+            vwtest::fail(__FILE__, __LINE__, #condition); \
+    } while (0)
+
+// Checks that the expression throws a vw::Exception with the given code
+#define VW_CHECK_THROWS(expression, code) \
+    do \
+    { \
+        bool thrown = false; \
+        try \
+        { \
+            expression; \
+        } \
+        catch (const vw::Exception& ex) \
+        { \
+            thrown = ex.getErrorCode() == (code); \
+        } \
+        if (!thrown) \
+            vwtest::fail(__FILE__, __LINE__, #expression " throws " #code); \
+    } while (0)
+
+namespace vwtest
+{
+    inline int& getFailureCount()
+    {
+        static int count = 0;
+        return count;
+    }
+
+    inline void fail(const char* file, int line, const char* what)
+    {
+        std::cerr << file << ":" << line << ": check failed: " << what << "\n";
+        ++getFailureCount();
+    }
+
+    // Returns the exit code of the test
+    inline int report(const char* name)
+    {
+        int failures = getFailureCount();
+        std::cerr << name << ": " << failures << " failed\n";
+        return (failures > 0) ? 1 : 0;
+    }
+
+    // Creates an instance targeting Vulkan 1.2 and lists its physical
+    // devices. Tests needing a device pass when there is none, so point
+    // VK_ICD_FILENAMES at lavapipe to run them.
+    inline bool createInstance(vw::Instance& instance,
+        vw::Instance::PhysicalDeviceList& physicalDevices)
+    {
+        try
+        {
+            vw::InstanceCreator instanceCtor;
+            instanceCtor.setApplicationName("vwTest");
+            instanceCtor.setApiVersion(1, 2, 0);
+            instance = instanceCtor.create();
+
+            physicalDevices = instance.enumeratePhysicalDevices();
+            if (physicalDevices.empty())
+            {
+                std::cerr << "No Vulkan device was found, skipping.\n";
+                return false;
+            }
+
+            return true;
+        }
+        catch (const vw::Exception& ex)
+        {
+            std::cerr << "No Vulkan instance, skipping: " << ex.getErrorMessage() << "\n";
+            return false;
+        }
+    }
+
+    // Creates a device on the first physical device with a queue per role
+    inline bool createDevice(vw::Instance& instance, vw::Device& device,
+        bool timelineSemaphores = false)
+    {
+        vw::Instance::PhysicalDeviceList physicalDevices;
+        if (!createInstance(instance, physicalDevices))
+            return false;
+
+        try
+        {
+            vw::DeviceCreator deviceCtor;
+            deviceCtor.setInstance(instance);
+            deviceCtor.setPhysicalDevice(physicalDevices.front());
+            if (!deviceCtor.planQueues())
+            {
+                deviceCtor.addQueues(physicalDevices.front().getDeviceQueueFamilies().front(),
+                    { 1.0f });
+            }
+
+            if (timelineSemaphores)
+                deviceCtor.enableTimelineSemaphores();
+
+            device = deviceCtor.create();
+            return true;
+        }
+        catch (const vw::Exception& ex)
+        {
+            std::cerr << "No usable Vulkan device, skipping: " << ex.getErrorMessage() << "\n";
+            return false;
+        }
+    }
+}
+
+#endif
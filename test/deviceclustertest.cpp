@@ -0,0 +1,193 @@
+#include "check.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace
+{
+    const uint32_t DeviceCount = 3;
+
+    // Tasks only run on the host, so their ticket is reached right away
+    uint64_t sleepFor(int microseconds)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(microseconds));
+        return 0;
+    }
+
+    uint64_t getStolenCount(vw::DeviceCluster& cluster)
+    {
+        uint64_t count = 0;
+        for (uint32_t device = 0; device < cluster.getDeviceCount(); ++device)
+            count += cluster.getStatistics(device).stolenCount;
+        return count;
+    }
+
+    void checkStealing(vw::DeviceCluster& cluster)
+    {
+        // The first task on device 0 holds its worker until the others have
+        // run dry and stolen from its queue
+        std::atomic<bool> blocked(false);
+        std::atomic<int> ran(0);
+        for (int i = 0; i < 12; ++i)
+        {
+            cluster.submit([&](vw::ComputeContext&, uint32_t device)
+            {
+                ++ran;
+                if (device == 0 && !blocked.exchange(true))
+                {
+                    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+                    while (getStolenCount(cluster) == 0 &&
+                        std::chrono::steady_clock::now() < deadline)
+                    {
+                        sleepFor(1000);
+                    }
+                }
+
+                return uint64_t(0);
+            });
+        }
+
+        cluster.waitIdle();
+        VW_CHECK(ran == 12);
+        VW_CHECK(getStolenCount(cluster) > 0);
+    }
+
+    void checkPlacement(vw::DeviceCluster& cluster)
+    {
+        // Device 0 is made slow, so once throughput is measured it gets
+        // fewer tasks than the others
+        auto task = [](vw::ComputeContext&, uint32_t device)
+        {
+            return sleepFor((device == 0) ? 4000 : 200);
+        };
+
+        for (int round = 0; round < 4; ++round)
+        {
+            for (uint32_t i = 0; i < DeviceCount * 4; ++i)
+                cluster.submit(task, 1.0);
+            cluster.waitIdle();
+        }
+
+        uint64_t before[DeviceCount];
+        for (uint32_t device = 0; device < DeviceCount; ++device)
+            before[device] = cluster.getStatistics(device).taskCount;
+
+        for (int i = 0; i < 60; ++i)
+            cluster.submit(task, 1.0);
+        cluster.waitIdle();
+
+        uint64_t slow = cluster.getStatistics(0).taskCount - before[0];
+        for (uint32_t device = 1; device < DeviceCount; ++device)
+        {
+            vw::DeviceCluster::Statistics stats = cluster.getStatistics(device);
+            VW_CHECK(stats.taskCount - before[device] > slow);
+            VW_CHECK(stats.throughput > cluster.getStatistics(0).throughput);
+        }
+    }
+
+    void checkStatistics(vw::DeviceCluster& cluster, uint64_t taskCount, double cost)
+    {
+        uint64_t tasks = 0;
+        double total = 0.0;
+        for (uint32_t device = 0; device < cluster.getDeviceCount(); ++device)
+        {
+            vw::DeviceCluster::Statistics stats = cluster.getStatistics(device);
+            VW_CHECK(stats.stolenCount <= stats.taskCount);
+            VW_CHECK(stats.taskCount == 0 || stats.throughput > 0.0);
+            tasks += stats.taskCount;
+            total += stats.cost;
+        }
+
+        VW_CHECK(tasks == taskCount);
+        VW_CHECK(total == cost);
+    }
+
+    void checkErrors(vw::DeviceCluster& cluster)
+    {
+        std::atomic<int> ran(0);
+        cluster.submit([](vw::ComputeContext&, uint32_t) -> uint64_t
+        {
+            throw std::runtime_error("task failed");
+        });
+        for (int i = 0; i < 8; ++i)
+        {
+            cluster.submit([&](vw::ComputeContext&, uint32_t)
+            {
+                ++ran;
+                return uint64_t(0);
+            });
+        }
+
+        // The other tasks still run, and the error is only reported once
+        bool rethrown = false;
+        try
+        {
+            cluster.waitIdle();
+        }
+        catch (const std::runtime_error& ex)
+        {
+            rethrown = std::string(ex.what()) == "task failed";
+        }
+
+        VW_CHECK(rethrown);
+        VW_CHECK(ran == 8);
+
+        bool thrown = false;
+        try
+        {
+            cluster.waitIdle();
+        }
+        catch (...)
+        {
+            thrown = true;
+        }
+
+        VW_CHECK(!thrown);
+    }
+}
+
+int main()
+{
+    vw::Instance instance;
+    vw::Instance::PhysicalDeviceList physicalDevices;
+    if (!vwtest::createInstance(instance, physicalDevices))
+        return 0;
+
+    // Every member gets a device of its own, so one physical device can stand
+    // in for several
+    std::vector<vw::PhysicalDevice> members(DeviceCount, physicalDevices.front());
+
+    std::unique_ptr<vw::DeviceCluster> cluster;
+    try
+    {
+        cluster.reset(new vw::DeviceCluster(instance, members));
+    }
+    catch (const vw::Exception& ex)
+    {
+        // Devices without timeline semaphores can't be clustered
+        std::cerr << "No usable Vulkan device, skipping: " << ex.getErrorMessage() << "\n";
+        return 0;
+    }
+
+    VW_CHECK(cluster->getDeviceCount() == DeviceCount);
+    for (uint32_t device = 0; device < DeviceCount; ++device)
+    {
+        VW_CHECK(cluster->getGroup(device) < DeviceCount);
+        VW_CHECK(cluster->getDevice(device));
+        VW_CHECK(cluster->getStatistics(device).taskCount == 0);
+    }
+
+    const uint64_t placementCount = 4 * DeviceCount * 4 + 60;
+    checkStealing(*cluster);
+    checkStatistics(*cluster, 12, 12.0);
+    checkPlacement(*cluster);
+    checkStatistics(*cluster, 12 + placementCount, 12.0 + placementCount);
+    checkErrors(*cluster);
+    checkStatistics(*cluster, 12 + placementCount + 8, 12.0 + placementCount + 8);
+
+    return vwtest::report("deviceclustertest");
+}
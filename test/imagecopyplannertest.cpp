@@ -0,0 +1,152 @@
+#include "check.h"
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    const VkImageSubresourceLayers Subresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+
+    vw::ImageCopyPlanner::Box makeBox(int32_t x, int32_t y, int32_t z,
+        uint32_t width, uint32_t height, uint32_t depth)
+    {
+        vw::ImageCopyPlanner::Box box;
+        box.offset = VkOffset3D{ x, y, z };
+        box.extent = VkExtent3D{ width, height, depth };
+        return box;
+    }
+
+    bool isBox(const vw::ImageCopyPlanner::Box& box, int32_t x, int32_t y, int32_t z,
+        uint32_t width, uint32_t height, uint32_t depth)
+    {
+        return box.offset.x == x && box.offset.y == y && box.offset.z == z &&
+            box.extent.width == width && box.extent.height == height &&
+            box.extent.depth == depth;
+    }
+
+    void checkMerging()
+    {
+        // 8x8 cells on a 30x20 level
+        vw::ImageCopyPlanner planner(VkExtent3D{ 8, 8, 1 }, VkExtent3D{ 30, 20, 1 }, 4);
+        VW_CHECK(planner.isEmpty());
+        VW_CHECK(planner.getRegions().empty());
+
+        planner.addDirty(makeBox(1, 1, 0, 2, 2, 1));
+        planner.addDirty(makeBox(9, 3, 0, 3, 3, 1));
+        planner.addDirty(makeBox(2, 9, 0, 10, 2, 1));
+        planner.addDirty(makeBox(28, 18, 0, 10, 10, 1));
+
+        // The first three merge along the row and then across rows, the last
+        // is clipped to the level
+        std::vector<vw::ImageCopyPlanner::Box> regions = planner.getRegions();
+        VW_CHECK(regions.size() == 2);
+        if (regions.size() == 2)
+        {
+            VW_CHECK(isBox(regions[0], 0, 0, 0, 16, 16, 1));
+            VW_CHECK(isBox(regions[1], 24, 16, 0, 6, 4, 1));
+        }
+
+        // Runs of different widths are not merged across rows
+        vw::ImageCopyPlanner shape(VkExtent3D{ 1, 1, 1 }, VkExtent3D{ 4, 4, 1 }, 4);
+        shape.addDirty(makeBox(0, 0, 0, 1, 4, 1));
+        shape.addDirty(makeBox(0, 3, 0, 4, 1, 1));
+        regions = shape.getRegions();
+        VW_CHECK(regions.size() == 2);
+        if (regions.size() == 2)
+        {
+            VW_CHECK(isBox(regions[0], 0, 0, 0, 1, 3, 1));
+            VW_CHECK(isBox(regions[1], 0, 3, 0, 4, 1, 1));
+        }
+
+        // Equal boxes merge across slices
+        vw::ImageCopyPlanner volume(VkExtent3D{ 2, 2, 1 }, VkExtent3D{ 8, 8, 4 }, 4);
+        for (int32_t z = 0; z < 4; ++z)
+            volume.addDirty(makeBox(2, 2, z, 3, 1, 1));
+        regions = volume.getRegions();
+        VW_CHECK(regions.size() == 1);
+        if (regions.size() == 1)
+            VW_CHECK(isBox(regions[0], 2, 2, 0, 4, 2, 4));
+
+        // A granularity of (0,0,0) only allows whole levels
+        vw::ImageCopyPlanner whole(VkExtent3D{ 0, 0, 0 }, VkExtent3D{ 30, 20, 1 }, 4);
+        whole.addDirty(makeBox(5, 5, 0, 1, 1, 1));
+        regions = whole.getRegions();
+        VW_CHECK(regions.size() == 1);
+        if (regions.size() == 1)
+            VW_CHECK(isBox(regions[0], 0, 0, 0, 30, 20, 1));
+
+        planner.clear();
+        VW_CHECK(planner.isEmpty());
+        VW_CHECK(planner.getRegions().empty());
+    }
+
+    void checkCompressedGranularity()
+    {
+        // BC1 has 4x4 blocks of 8 bytes, and the granularity is in blocks, so
+        // cells are 8x8 texels
+        vw::ImageCopyPlanner planner(VkExtent3D{ 2, 2, 1 }, VkExtent3D{ 18, 18, 1 }, 8,
+            VkExtent3D{ 4, 4, 1 });
+        planner.addDirty(makeBox(9, 9, 0, 1, 1, 1));
+
+        std::vector<vw::ImageCopyPlanner::Box> regions = planner.getRegions();
+        VW_CHECK(regions.size() == 1);
+        if (regions.size() == 1)
+            VW_CHECK(isBox(regions[0], 8, 8, 0, 8, 8, 1));
+        VW_CHECK(planner.getPackedSize() == 2 * 2 * 8);
+
+        // A region reaching the edge of the level ends there, and a partial
+        // block still takes a whole block
+        planner.clear();
+        planner.addDirty(makeBox(17, 17, 0, 1, 1, 1));
+        regions = planner.getRegions();
+        VW_CHECK(regions.size() == 1);
+        if (regions.size() == 1)
+            VW_CHECK(isBox(regions[0], 16, 16, 0, 2, 2, 1));
+        VW_CHECK(planner.getPackedSize() == 8);
+    }
+
+    void checkOffsetAlignment()
+    {
+        // Offsets are multiples of both 4 and the block size
+        VW_CHECK(vw::ImageCopyPlanner(VkExtent3D{ 1, 1, 1 }, VkExtent3D{ 4, 4, 1 }, 1)
+            .getOffsetAlignment() == 4);
+        VW_CHECK(vw::ImageCopyPlanner(VkExtent3D{ 1, 1, 1 }, VkExtent3D{ 4, 4, 1 }, 8)
+            .getOffsetAlignment() == 8);
+        VW_CHECK(vw::ImageCopyPlanner(VkExtent3D{ 1, 1, 1 }, VkExtent3D{ 4, 4, 1 }, 6)
+            .getOffsetAlignment() == 12);
+
+        vw::ImageCopyPlanner planner(VkExtent3D{ 1, 1, 1 }, VkExtent3D{ 4, 4, 1 }, 3);
+        VW_CHECK(planner.getOffsetAlignment() == 12);
+        planner.addDirty(makeBox(0, 0, 0, 1, 1, 1));
+        planner.addDirty(makeBox(2, 2, 0, 1, 1, 1));
+
+        // The second region starts after the 3 bytes of the first, rounded up
+        VW_CHECK(planner.getPackedSize() == 12 + 3);
+
+        std::vector<uint8_t> level(4 * 4 * 3);
+        for (size_t i = 0; i < level.size(); ++i)
+            level[i] = static_cast<uint8_t>(i);
+
+        std::vector<uint8_t> packed(planner.getPackedSize());
+        std::vector<VkBufferImageCopy> copies = planner.pack(level.data(), 4 * 3, level.size(),
+            Subresource, packed.data());
+        VW_CHECK(copies.size() == 2);
+        if (copies.size() == 2)
+        {
+            VW_CHECK(copies[0].bufferOffset == 0);
+            VW_CHECK(copies[1].bufferOffset == 12);
+            VW_CHECK(copies[1].bufferRowLength == 0 && copies[1].bufferImageHeight == 0);
+            VW_CHECK(std::memcmp(&packed[0], &level[0], 3) == 0);
+            VW_CHECK(std::memcmp(&packed[12], &level[(2 * 4 + 2) * 3], 3) == 0);
+        }
+    }
+}
+
+int main()
+{
+    checkMerging();
+    checkCompressedGranularity();
+    checkOffsetAlignment();
+
+    return vwtest::report("imagecopyplannertest");
+}
@@ -0,0 +1,124 @@
+#include "check.h"
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    const VkDeviceSize BlockSize = 1024 * 1024;
+
+    VkMemoryRequirements getRequirements(VkDeviceSize size, VkDeviceSize alignment)
+    {
+        VkMemoryRequirements requirements;
+        requirements.size = size;
+        requirements.alignment = alignment;
+        requirements.memoryTypeBits = ~0u;
+        return requirements;
+    }
+
+    bool isBefore(const vw::Allocation& a, const vw::Allocation& b)
+    {
+        if (a.getMemory() != b.getMemory())
+            return a.getMemory() < b.getMemory();
+        return a.getOffset() < b.getOffset();
+    }
+
+    void checkRandomAllocations(vw::MemoryAllocator& allocator)
+    {
+        std::mt19937 random(1);
+        std::vector<vw::Allocation> allocations;
+
+        for (int i = 0; i < 500; ++i)
+        {
+            VkDeviceSize size = std::uniform_int_distribution<VkDeviceSize>(1, 64 * 1024)(random);
+            VkDeviceSize alignment = VkDeviceSize(1) << std::uniform_int_distribution<int>(0, 12)(random);
+
+            vw::Allocation allocation = allocator.allocate(getRequirements(size, alignment),
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+            VW_CHECK(allocation);
+            VW_CHECK(allocation.getOffset() % alignment == 0);
+            VW_CHECK(allocation.getSize() >= size);
+            VW_CHECK(allocation.getMappedData() != nullptr);
+            allocations.push_back(allocation);
+        }
+
+        std::vector<vw::Allocation> sorted = allocations;
+        std::sort(sorted.begin(), sorted.end(), isBefore);
+        for (size_t i = 1; i < sorted.size(); ++i)
+        {
+            if (sorted[i].getMemory() == sorted[i - 1].getMemory())
+                VW_CHECK(sorted[i - 1].getOffset() + sorted[i - 1].getSize() <= sorted[i].getOffset());
+        }
+
+        vw::MemoryAllocator::Statistics stats = allocator.getStatistics();
+        VW_CHECK(stats.allocationCount == allocations.size());
+        VW_CHECK(stats.dedicatedAllocationCount == 0);
+        VW_CHECK(stats.blockCount > 1);
+
+        // Free in random order, every block must merge back into one range and
+        // at most one empty block is kept around.
+        std::shuffle(allocations.begin(), allocations.end(), random);
+        for (vw::Allocation& allocation : allocations)
+        {
+            allocator.free(allocation);
+            VW_CHECK(!allocation);
+        }
+
+        stats = allocator.getStatistics();
+        VW_CHECK(stats.allocationCount == 0);
+        VW_CHECK(stats.usedBytes == 0);
+        VW_CHECK(stats.blockCount == 1);
+        VW_CHECK(stats.freeRangeCount == stats.blockCount);
+        VW_CHECK(stats.largestFreeRange == stats.blockBytes);
+        VW_CHECK(stats.fragmentation == 0.0f);
+    }
+
+    void checkBlockReuse(vw::MemoryAllocator& allocator)
+    {
+        vw::Allocation first = allocator.allocate(getRequirements(4096, 256),
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        size_t blockCount = allocator.getStatistics().blockCount;
+        VkDeviceMemory memory = first.getMemory();
+        allocator.free(first);
+
+        vw::Allocation second = allocator.allocate(getRequirements(4096, 256),
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        VW_CHECK(second.getMemory() == memory);
+        VW_CHECK(allocator.getStatistics().blockCount == blockCount);
+        allocator.free(second);
+    }
+
+    void checkDedicated(vw::MemoryAllocator& allocator)
+    {
+        vw::Allocation allocation = allocator.allocate(getRequirements(BlockSize, 256),
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        VW_CHECK(allocation.getOffset() == 0);
+
+        vw::MemoryAllocator::Statistics stats = allocator.getStatistics();
+        VW_CHECK(stats.dedicatedAllocationCount == 1);
+        VW_CHECK(stats.dedicatedBytes == BlockSize);
+
+        allocator.free(allocation);
+        VW_CHECK(allocator.getStatistics().dedicatedAllocationCount == 0);
+    }
+}
+
+int main()
+{
+    vw::Instance instance;
+    vw::Device device;
+    if (!vwtest::createDevice(instance, device))
+        return 0;
+
+    {
+        vw::MemoryAllocator allocator(device.getHandle(), device.getDispatch(),
+            device.getPhysicalDevice(), BlockSize, device.getAllocationCallbacks());
+        checkRandomAllocations(allocator);
+        checkBlockReuse(allocator);
+        checkDedicated(allocator);
+    }
+
+    return vwtest::report("memoryallocatortest");
+}
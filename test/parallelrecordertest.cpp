@@ -0,0 +1,116 @@
+#include "check.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    using Chunk = std::pair<uint32_t, uint32_t>;
+
+    void checkOrder(vw::ParallelRecorder& recorder, uint32_t itemCount)
+    {
+        std::mutex mutex;
+        std::map<VkCommandBuffer, Chunk> chunks;
+        std::vector<std::atomic<int>> recorded(itemCount);
+        std::atomic<bool> threadsValid(true);
+
+        recorder.beginFrame();
+        std::vector<VkCommandBuffer> commandBuffers = recorder.record(itemCount,
+            [&](VkCommandBuffer commandBuffer, uint32_t first, uint32_t count, uint32_t thread)
+            {
+                if (thread >= recorder.getThreadCount())
+                    threadsValid = false;
+                for (uint32_t i = first; i < first + count; ++i)
+                    ++recorded[i];
+
+                std::lock_guard<std::mutex> lock(mutex);
+                chunks[commandBuffer] = Chunk(first, count);
+            });
+
+        VW_CHECK(threadsValid);
+        VW_CHECK(commandBuffers.size() == chunks.size());
+
+        // The command buffers come back in item order whoever recorded them
+        uint32_t next = 0;
+        for (VkCommandBuffer commandBuffer : commandBuffers)
+        {
+            auto chunk = chunks.find(commandBuffer);
+            VW_CHECK(chunk != chunks.end());
+            if (chunk == chunks.end())
+                return;
+
+            VW_CHECK(chunk->second.first == next);
+            VW_CHECK(chunk->second.second > 0);
+            next += chunk->second.second;
+        }
+
+        VW_CHECK(next == itemCount);
+        for (const std::atomic<int>& count : recorded)
+            VW_CHECK(count == 1);
+    }
+
+    void checkErrors(vw::ParallelRecorder& recorder)
+    {
+        // Every chunk is still recorded before the first error is rethrown
+        std::atomic<uint32_t> items(0);
+        bool rethrown = false;
+        recorder.beginFrame();
+        try
+        {
+            recorder.record(1000, [&](VkCommandBuffer, uint32_t first, uint32_t count, uint32_t)
+            {
+                items += count;
+                if (first >= 500)
+                    throw std::runtime_error("record failed");
+            });
+        }
+        catch (const std::runtime_error& ex)
+        {
+            rethrown = std::string(ex.what()) == "record failed";
+        }
+
+        VW_CHECK(rethrown);
+        VW_CHECK(items == 1000);
+
+        // The recorder is still usable afterwards
+        checkOrder(recorder, 100);
+    }
+}
+
+int main()
+{
+    vw::Instance instance;
+    vw::Device device;
+    if (!vwtest::createDevice(instance, device))
+        return 0;
+
+    vw::Queue& queue = device.getQueue(vw::Device::QueueRole_Graphics);
+    vw::PhysicalDevice::QueueFamilyList families =
+        device.getPhysicalDevice().getDeviceQueueFamilies();
+
+    for (uint32_t workerCount : { 0u, 1u, 3u })
+    {
+        vw::ParallelRecorder::Settings settings;
+        settings.workerCount = workerCount;
+        settings.minChunkItems = 16;
+        settings.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+
+        vw::ParallelRecorder recorder(device, families[queue.getFamilyIndex()], settings);
+        VW_CHECK(recorder.getThreadCount() == workerCount + 1);
+
+        recorder.beginFrame();
+        VW_CHECK(recorder.record(0, [](VkCommandBuffer, uint32_t, uint32_t, uint32_t) {}).empty());
+
+        for (uint32_t itemCount : { 1u, 15u, 16u, 17u, 1000u, 4099u })
+            checkOrder(recorder, itemCount);
+
+        checkErrors(recorder);
+    }
+
+    return vwtest::report("parallelrecordertest");
+}
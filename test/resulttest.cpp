@@ -0,0 +1,134 @@
+#include "check.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+namespace
+{
+    // Counts live instances to check that values are destroyed exactly once
+    struct Counted
+    {
+        static int liveCount;
+
+        explicit Counted(int value)
+            : value(value)
+        {
+            ++liveCount;
+        }
+
+        Counted(Counted&& other)
+            : value(other.value)
+        {
+            ++liveCount;
+        }
+
+        ~Counted()
+        {
+            --liveCount;
+        }
+
+        int value;
+    };
+
+    int Counted::liveCount = 0;
+
+    void checkCodes()
+    {
+        vw::Result<int> timeout(VK_TIMEOUT);
+        VW_CHECK(timeout);
+        VW_CHECK(!timeout.hasValue());
+        VW_CHECK(timeout.getCode() == VK_TIMEOUT);
+
+        vw::Result<int> lost(VK_ERROR_DEVICE_LOST);
+        VW_CHECK(!lost);
+        VW_CHECK(std::strcmp(lost.getMessage(), "Vulkan physical or logical device lost.") == 0);
+
+        vw::Result<void> success(VK_SUCCESS);
+        VW_CHECK(success);
+        vw::Result<void> failure(VK_ERROR_OUT_OF_HOST_MEMORY);
+        VW_CHECK(!failure);
+        VW_CHECK(failure.getCode() == VK_ERROR_OUT_OF_HOST_MEMORY);
+
+        VW_CHECK(std::strcmp(vw::getResultString(static_cast<VkResult>(12345)),
+            "Vulkan unhandled error code.") == 0);
+
+        vw::Exception ex("vw::Test::checkCodes", VK_ERROR_DEVICE_LOST);
+        VW_CHECK(ex.getErrorCode() == VK_ERROR_DEVICE_LOST);
+        VW_CHECK(ex.getErrorMessage() ==
+            "Unhandled event at vw::Test::checkCodes. Vulkan physical or logical device lost.");
+    }
+
+    void checkValues()
+    {
+        {
+            // A value can come with a success code other than VK_SUCCESS
+            vw::Result<std::string> partial(std::string("partial"), VK_INCOMPLETE);
+            VW_CHECK(partial);
+            VW_CHECK(partial.hasValue());
+            VW_CHECK(partial.getCode() == VK_INCOMPLETE);
+            VW_CHECK(partial.takeValue() == "partial");
+        }
+
+        {
+            vw::Result<std::unique_ptr<int>> owner(std::unique_ptr<int>(new int(7)));
+            vw::Result<std::unique_ptr<int>> moved(std::move(owner));
+            VW_CHECK(moved.hasValue() && *moved.getValue() == 7);
+            VW_CHECK(owner.hasValue() && !owner.getValue());
+        }
+
+        {
+            vw::Result<Counted> counted(Counted(3));
+            VW_CHECK(Counted::liveCount == 1);
+            vw::Result<Counted> moved(std::move(counted));
+            VW_CHECK(Counted::liveCount == 2);
+            VW_CHECK(moved.getValue().value == 3);
+
+            vw::Result<Counted> empty(VK_ERROR_INITIALIZATION_FAILED);
+            VW_CHECK(Counted::liveCount == 2);
+        }
+        VW_CHECK(Counted::liveCount == 0);
+    }
+
+    void checkDevice()
+    {
+        // The non-throwing calls report the same outcome the throwing ones do
+        vw::InstanceCreator instanceCtor;
+        instanceCtor.setApplicationName("vwTest");
+        instanceCtor.setApiVersion(1, 2, 0);
+        vw::Result<vw::Instance> instance = instanceCtor.tryCreate();
+        if (!instance)
+        {
+            std::cerr << "No Vulkan instance, skipping: " << instance.getMessage() << "\n";
+            return;
+        }
+        VW_CHECK(instance.hasValue());
+
+        vw::Result<vw::Instance::PhysicalDeviceList> physicalDevices =
+            instance.getValue().tryEnumeratePhysicalDevices();
+        VW_CHECK(physicalDevices.getCode() == VK_SUCCESS);
+        if (!physicalDevices.hasValue() || physicalDevices.getValue().empty())
+            return;
+
+        vw::DeviceCreator deviceCtor;
+        deviceCtor.setInstance(instance.getValue());
+        deviceCtor.setPhysicalDevice(physicalDevices.getValue().front());
+        deviceCtor.addQueues(physicalDevices.getValue().front().getDeviceQueueFamilies().front(),
+            { 1.0f });
+        deviceCtor.addExtension("VK_vw_missing_extension");
+
+        vw::Result<vw::Device> device = deviceCtor.tryCreate();
+        VW_CHECK(!device);
+        VW_CHECK(!device.hasValue());
+        VW_CHECK(device.getCode() == VK_ERROR_EXTENSION_NOT_PRESENT);
+    }
+}
+
+int main()
+{
+    checkCodes();
+    checkValues();
+    checkDevice();
+
+    return vwtest::report("resulttest");
+}
@@ -0,0 +1,180 @@
+#include "check.h"
+
+#include <cstring>
+#include <vector>
+
+#include "hash.h"
+
+namespace
+{
+    using Code = std::vector<uint32_t>;
+
+    const uint32_t OpSource = 3;
+    const uint32_t OpName = 5;
+    const uint32_t OpLine = 8;
+    const uint32_t OpExtension = 10;
+    const uint32_t OpExtInstImport = 11;
+    const uint32_t OpExtInst = 12;
+    const uint32_t OpMemoryModel = 14;
+    const uint32_t OpCapability = 17;
+    const uint32_t OpReturn = 253;
+    const uint32_t OpModuleProcessed = 330;
+
+    Code makeHeader()
+    {
+        return Code{ 0x07230203, 0x00010000, 0, 16, 0 };
+    }
+
+    // Packs a nul terminated string into whole words
+    Code makeString(const char* string)
+    {
+        Code words(std::strlen(string) / sizeof(uint32_t) + 1, 0);
+        std::memcpy(words.data(), string, std::strlen(string));
+        return words;
+    }
+
+    void add(Code& code, uint32_t opcode, Code operands = Code(),
+        const char* string = nullptr)
+    {
+        if (string != nullptr)
+        {
+            Code words = makeString(string);
+            operands.insert(operands.end(), words.begin(), words.end());
+        }
+
+        code.push_back(static_cast<uint32_t>(operands.size() + 1) << 16 | opcode);
+        code.insert(code.end(), operands.begin(), operands.end());
+    }
+
+    Code strip(const Code& code)
+    {
+        return vw::ShaderModuleCache::strip(code.data(), code.size() * sizeof(uint32_t));
+    }
+
+    void checkStrip()
+    {
+        Code code = makeHeader();
+        Code expected = makeHeader();
+
+        add(code, OpCapability, { 1 });
+        add(expected, OpCapability, { 1 });
+        add(code, OpExtension, Code(), "SPV_KHR_non_semantic_info");
+        add(code, OpExtInstImport, { 1 }, "NonSemantic.Shader.DebugInfo.100");
+        add(code, OpExtInstImport, { 2 }, "GLSL.std.450");
+        add(expected, OpExtInstImport, { 2 }, "GLSL.std.450");
+        add(code, OpMemoryModel, { 0, 1 });
+        add(expected, OpMemoryModel, { 0, 1 });
+        add(code, OpSource, { 2, 450 });
+        add(code, OpName, { 3 }, "main");
+        add(code, OpModuleProcessed, Code(), "client vulkan100");
+        add(code, OpExtInst, { 5, 4, 1, 1 });
+        add(code, OpExtInst, { 5, 6, 2, 31, 7 });
+        add(expected, OpExtInst, { 5, 6, 2, 31, 7 });
+        add(code, OpLine, { 7, 1, 1 });
+        add(code, OpReturn);
+        add(expected, OpReturn);
+
+        VW_CHECK(strip(code) == expected);
+
+        // Stripping twice changes nothing more
+        VW_CHECK(strip(expected) == expected);
+    }
+
+    void checkUnstripped()
+    {
+        // OpenCL.DebugInfo.100 refers to the results of OpString and OpSource
+        Code debugInfo = makeHeader();
+        add(debugInfo, OpExtInstImport, { 1 }, "OpenCL.DebugInfo.100");
+        add(debugInfo, OpSource, { 2, 450 });
+        add(debugInfo, OpExtInst, { 5, 4, 1, 1 });
+        VW_CHECK(strip(debugInfo) == debugInfo);
+
+        // Instructions with a zero length or running past the end
+        Code zeroLength = makeHeader();
+        add(zeroLength, OpSource, { 2, 450 });
+        zeroLength.push_back(OpReturn);
+        VW_CHECK(strip(zeroLength) == zeroLength);
+
+        Code truncated = makeHeader();
+        add(truncated, OpSource, { 2, 450 });
+        truncated.pop_back();
+        VW_CHECK(strip(truncated) == truncated);
+
+        Code badMagic = makeHeader();
+        add(badMagic, OpSource, { 2, 450 });
+        badMagic[0] = 0x03022307;
+        VW_CHECK(strip(badMagic) == badMagic);
+
+        Code headerOnly = makeHeader();
+        headerOnly.resize(3);
+        VW_CHECK(strip(headerOnly) == headerOnly);
+
+        // Imports and extended instructions too short to name a set are kept
+        // without reading past them
+        Code tooShort = makeHeader();
+        add(tooShort, OpExtInstImport);
+        add(tooShort, OpExtInst, { 5, 4 });
+        add(tooShort, OpSource, { 2, 450 });
+        Code expected = makeHeader();
+        add(expected, OpExtInstImport);
+        add(expected, OpExtInst, { 5, 4 });
+        VW_CHECK(strip(tooShort) == expected);
+
+        Code lastImport = makeHeader();
+        add(lastImport, OpExtInstImport);
+        VW_CHECK(strip(lastImport) == lastImport);
+    }
+
+    bool hashesEqual(const Code& a, const Code& b)
+    {
+        uint64_t aLow, aHigh, bLow, bHigh;
+        vw::hashWords(a.data(), a.size(), aLow, aHigh);
+        vw::hashWords(b.data(), b.size(), bLow, bHigh);
+        return aLow == bLow && aHigh == bHigh;
+    }
+
+    void checkHash()
+    {
+        // Every word position, in the lanes and in the tail, changes the hash
+        for (size_t size = 1; size <= 20; ++size)
+        {
+            Code code(size);
+            for (size_t i = 0; i < size; ++i)
+                code[i] = static_cast<uint32_t>(i * 0x01000193u);
+
+            VW_CHECK(hashesEqual(code, Code(code)));
+            for (size_t i = 0; i < size; ++i)
+            {
+                Code changed = code;
+                changed[i] ^= 1;
+                VW_CHECK(!hashesEqual(code, changed));
+            }
+
+            // So does the length, even when the extra words are zero
+            Code longer = code;
+            longer.push_back(0);
+            VW_CHECK(!hashesEqual(code, longer));
+        }
+
+        VW_CHECK(!hashesEqual(Code(), Code(1, 0)));
+
+        Code code = makeHeader();
+        add(code, OpReturn);
+
+        uint64_t low, high;
+        vw::hashWords(code.data(), code.size(), low, high);
+        vw::ShaderModuleCache::Hash hash = vw::ShaderModuleCache::hash(code.data(),
+            code.size() * sizeof(uint32_t));
+        VW_CHECK(hash.low == low && hash.high == high);
+        VW_CHECK(low != high);
+    }
+}
+
+int main()
+{
+    checkStrip();
+    checkUnstripped();
+    checkHash();
+
+    return vwtest::report("shadermodulecachetest");
+}
@@ -0,0 +1,155 @@
+#include "check.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+    const VkDeviceSize ChunkSize = 64 * 1024;
+    const VkDeviceSize FileSize = 7 * ChunkSize / 2 + 123;
+    const VkDeviceSize DstOffset = 256;
+
+    // A host visible buffer the loads are checked through
+    struct TargetBuffer
+    {
+        TargetBuffer(vw::Device& device, VkDeviceSize size)
+            : device(device)
+            , buffer(VK_NULL_HANDLE)
+        {
+            VkBufferCreateInfo cinfo;
+            cinfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            cinfo.pNext = nullptr;
+            cinfo.flags = 0;
+            cinfo.size = size;
+            cinfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+            cinfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            cinfo.queueFamilyIndexCount = 0;
+            cinfo.pQueueFamilyIndices = nullptr;
+
+            VkResult result = device.getDispatch().vkCreateBuffer(device.getHandle(), &cinfo,
+                device.getAllocationCallbacks(), &buffer);
+            if (result != VK_SUCCESS)
+                throw vw::Exception("TargetBuffer", result);
+
+            allocation = device.getMemoryAllocator().allocateForBuffer(buffer,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+            std::memset(allocation.getMappedData(), 0, static_cast<size_t>(size));
+            device.getMemoryAllocator().flush(allocation);
+        }
+
+        ~TargetBuffer()
+        {
+            device.getMemoryAllocator().free(allocation);
+            device.getDispatch().vkDestroyBuffer(device.getHandle(), buffer,
+                device.getAllocationCallbacks());
+        }
+
+        const char* getData()
+        {
+            device.getMemoryAllocator().invalidate(allocation);
+            return static_cast<const char*>(allocation.getMappedData());
+        }
+
+        vw::Device& device;
+        VkBuffer buffer;
+        vw::Allocation allocation;
+    };
+
+    struct Chunk
+    {
+        VkDeviceSize offset;
+        VkDeviceSize size;
+    };
+
+    void checkLoad(vw::StreamLoader& loader, const char* path, const std::vector<char>& contents,
+        TargetBuffer& target)
+    {
+        std::vector<Chunk> chunks;
+        bool loaded = loader.load(path, target.buffer, DstOffset,
+            [&](VkDeviceSize offset, VkDeviceSize size)
+            {
+                chunks.push_back(Chunk{ offset, size });
+            });
+        VW_CHECK(loaded);
+
+        // Chunks are reported in order and cover the file exactly once
+        VkDeviceSize expected = 0;
+        for (const Chunk& chunk : chunks)
+        {
+            VW_CHECK(chunk.offset == expected);
+            VW_CHECK(chunk.size > 0 && chunk.size <= ChunkSize);
+            expected += chunk.size;
+        }
+        VW_CHECK(expected == FileSize);
+        VW_CHECK(chunks.size() == (FileSize + ChunkSize - 1) / ChunkSize);
+
+        const char* data = target.getData();
+        VW_CHECK(std::memcmp(data + DstOffset, contents.data(), contents.size()) == 0);
+        VW_CHECK(data[0] == 0 && data[DstOffset - 1] == 0);
+
+        vw::StreamLoader::Statistics stats = loader.getStatistics();
+        VW_CHECK(stats.chunkCount == chunks.size());
+        VW_CHECK(stats.read.bytes == FileSize);
+        VW_CHECK(stats.copy.bytes == FileSize);
+        VW_CHECK(stats.notify.bytes == FileSize);
+        VW_CHECK(stats.total.bytes == FileSize);
+    }
+
+    void checkFailures(vw::StreamLoader& loader, int fd, TargetBuffer& target)
+    {
+        // A range running past the end of the file is a short read, and the
+        // chunks before it still complete in order
+        std::vector<Chunk> chunks;
+        bool loaded = loader.load(fd, FileSize - 100, 3 * ChunkSize, target.buffer, 0,
+            [&](VkDeviceSize offset, VkDeviceSize size)
+            {
+                chunks.push_back(Chunk{ offset, size });
+            });
+        VW_CHECK(!loaded);
+        for (size_t i = 0; i < chunks.size(); ++i)
+            VW_CHECK(chunks[i].offset == i * ChunkSize);
+
+        VW_CHECK(!loader.load("/nonexistent/vwtest/file", target.buffer));
+        VW_CHECK(loader.load(fd, 5, 0, target.buffer));
+    }
+}
+
+int main()
+{
+    vw::Instance instance;
+    vw::Device device;
+    if (!vwtest::createDevice(instance, device, true))
+        return 0;
+
+    std::vector<char> contents(static_cast<size_t>(FileSize));
+    for (size_t i = 0; i < contents.size(); ++i)
+        contents[i] = static_cast<char>(i * 131 + (i >> 12));
+
+    char path[] = "/tmp/vwtestXXXXXX";
+    int fd = mkstemp(path);
+    VW_CHECK(fd >= 0);
+    if (fd < 0)
+        return vwtest::report("streamloadertest");
+
+    VW_CHECK(write(fd, contents.data(), contents.size()) ==
+        static_cast<ssize_t>(contents.size()));
+
+    {
+        vw::StreamLoader::Settings settings;
+        settings.chunkSize = ChunkSize;
+        settings.depth = 2;
+        settings.readThreads = 2;
+
+        vw::StreamLoader loader(device, settings);
+        TargetBuffer target(device, DstOffset + FileSize);
+        checkLoad(loader, path, contents, target);
+        checkFailures(loader, fd, target);
+    }
+
+    close(fd);
+    unlink(path);
+    return vwtest::report("streamloadertest");
+}
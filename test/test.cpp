@@ -94,8 +94,8 @@ int main(int argc, const char * const argv[])
 
     // Create a device.
     vw::DeviceCreator deviceCtor;
+    deviceCtor.setInstance(instance);
     deviceCtor.addLayer("VK_LAYER_LUNARG_standard_validation");
-    deviceCtor.addExtension(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
 
     std::sort(physicalDevices.begin(), physicalDevices.end(), DevicePriority());
     bool devSelected = false;
@@ -104,18 +104,8 @@ int main(int argc, const char * const argv[])
     {
         deviceCtor.setPhysicalDevice(dev);
 
-        for (auto family : dev.getDeviceQueueFamilies())
-        {
-            if (family.hasGraphicsSupport())
-            {
-                vw::DeviceCreator::PriorityList priorityList;
-                priorityList.resize(family.getQueueCount(), 1.0f);
-
-                deviceCtor.addQueues(family, priorityList);
-                devSelected = true;
-            }
-        }
-
+        // Request graphics plus any dedicated compute and transfer queues
+        devSelected = deviceCtor.planQueues();
         if (devSelected)
             break;
     }
@@ -148,6 +138,16 @@ int main(int argc, const char * const argv[])
         std::cout << "Queue index: " << queue.getQueueIndex() << "\n\n";
     }
 
+    const char* roleNames[] = { "Graphics", "Compute", "Transfer" };
+    for (int role = 0; role < vw::Device::QueueRole_Count; ++role)
+    {
+        auto queueRole = static_cast<vw::Device::QueueRole>(role);
+        vw::Queue& queue = device.getQueue(queueRole);
+        std::cout << roleNames[role] << " queue: family " << queue.getFamilyIndex() <<
+            ", index " << queue.getQueueIndex() <<
+            (device.hasDedicatedQueue(queueRole) ? " (dedicated)\n" : " (shared)\n");
+    }
+
     std::exit(0);
 }
 